@@ -0,0 +1,317 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bdd.h"
+#include <st.h>
+#include <omp.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "npncache.h"
+
+/* Modo --batch: lê vários alvos de um arquivo (um por linha, como o ninomiya_direct_isop.txt) e resolve todos
+no mesmo processo. Acima da ordem 1 os buckets não dependem do alvo, só do conjunto de variáveis, então os alvos
+são agrupados pelo suporte (as variáveis das quais a função realmente depende, em ordem alfabética) e cada grupo
+faz uma enumeração só, com todos os literais no bucket 1. Cada função nova é procurada numa hash com as tabelas
+verdade dos alvos pendentes do grupo, e o alvo é reportado na ordem em que aparece pela primeira vez (o mínimo).
+Só funciona com o backend de tabela verdade (suporte de até TT_MAX_VARS variáveis). Alvos cuja classe NPN já está no
+cache (de uma execução anterior ou de um grupo que já rodou) são respondidos sem enumeração. */
+#define BATCH_LINE_MAX 4096
+
+// Implementadas em cada executável
+DdNode *parseInputExpression(DdManager *manager, const char *input, Function **outVarMap, int *outVarCount, int *literalCount);
+Bucket *addBucket(Bucket *buckets, int *numBuckets);
+void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets);
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
+
+typedef struct {
+    int line;
+    char *expression;
+    TruthTable tt; //Sobre as variáveis do grupo
+    int group;
+    int nextSame; //Próximo alvo do grupo com a mesma tabela (-1 no fim)
+    int result; //0 enquanto pendente
+} BatchTarget;
+
+typedef struct {
+    char names[TT_MAX_VARS + 1];
+    int varCount;
+    int maxOrder; //Maior número de literais entre as expressões do grupo (limite superior da busca)
+    int pending;
+} BatchGroup;
+
+/* Bucket 1 com as duas polaridades de todas as variáveis, sem o filtro de unate (que depende do objetivo).
+Como fecha por complemento, a dobra fica sempre ligada aqui e cada bucket guarda metade das funções. */
+static inline void literalBucketInit(Bucket *bucket, const char *names, int varCount, SeenSet *uniqueCheck)
+{
+    bucket->order = 1;
+    bucketReserve(bucket, 2 * varCount);
+    for (int i = 0; i < varCount; i++) {
+        TruthTable varTt = ttVar(i, varCount);
+        bucketAppendLiteral(bucket, varTt, NULL, names[i], false);
+        bucketAppendLiteral(bucket, ~varTt & fullTt, NULL, names[i], true);
+        seenSetInsert(uniqueCheck, varTt);
+        seenSetInsert(uniqueCheck, ~varTt & fullTt);
+    }
+    foldComplements = bucketFoldLiterals(NULL, bucket);
+}
+
+// Funções que um bucket representa (com a dobra, cada entrada vale por ela e pelo complemento)
+static inline uint64_t bucketFunctionCount(const Bucket *bucket)
+{
+    return (uint64_t)bucket->size * (foldComplements ? 2 : 1);
+}
+
+/* Reescreve a tabela (na ordem de variáveis do parse) só sobre as variáveis do suporte, em ordem alfabética.
+Devolve os nomes em outNames. */
+static inline TruthTable batchProject(TruthTable tt, const Function *varMap, int varCount, char *outNames, int *outCount)
+{
+    int index[TT_MAX_VARS];
+    int count = 0;
+    for (int i = 0; i < varCount; i++) {
+        if (ttCofactor(tt, i, true, varCount) == ttCofactor(tt, i, false, varCount)) continue;
+        // Inserção ordenada pelo nome
+        int p = count++;
+        while (p > 0 && varMap[index[p - 1]].varName > varMap[i].varName) {
+            index[p] = index[p - 1];
+            p--;
+        }
+        index[p] = i;
+    }
+
+    TruthTable projected = 0;
+    for (int m = 0; m < (1 << count); m++) {
+        int original = 0;
+        for (int p = 0; p < count; p++) {
+            if ((m >> p) & 1) original |= 1 << index[p];
+        }
+        if ((tt >> original) & 1) projected |= (TruthTable)1 << m;
+    }
+    for (int p = 0; p < count; p++) outNames[p] = varMap[index[p]].varName;
+    outNames[count] = '\0';
+    *outCount = count;
+    return projected;
+}
+
+static inline void batchReport(BatchTarget *target, Bucket *buckets, int order, uint32_t ref, NpnCache *cache, const BatchGroup *group)
+{
+    target->result = order;
+    printf("ALVO %d: %s\n", target->line, target->expression);
+    printf("RESULTADO_LITERAIS: %d\n", order);
+    printf("RESULTADO_EXPRESSAO: ");
+    bucketEchoBegin();
+    printBucketFunction(buckets, order, ref);
+    const char *expression = bucketEchoEnd();
+    printf("\n");
+    if (cache->path[0] != '\0') npnCacheRecord(cache, target->tt, group->varCount, group->names, expression);
+}
+
+// Responde o alvo pelo cache NPN. false se a classe ainda não foi resolvida
+static inline bool batchCacheAnswer(BatchTarget *target, NpnCache *cache, const char *names, int varCount)
+{
+    if (cache->path[0] == '\0') return false; //Cache desligado
+    char expression[NPN_EXPR_MAX];
+    int literals = npnCacheLookup(cache, target->tt, varCount, names, expression, sizeof(expression));
+    if (literals == 0) return false;
+    target->result = literals;
+    printf("ALVO %d: %s\n", target->line, target->expression);
+    printf("RESULTADO_LITERAIS: %d\n", literals);
+    printf("RESULTADO_EXPRESSAO: %s\n", expression);
+    return true;
+}
+
+// Procura as funções novas do bucket entre os alvos pendentes do grupo
+static inline void batchScanBucket(Bucket *buckets, int order, st_table *pendingTable, BatchTarget *targets, BatchGroup *group,
+                                   NpnCache *cache)
+{
+    Bucket *bucket = &buckets[order - 1];
+    for (int k = 0; k < bucket->size && group->pending > 0; k++) {
+        for (int pol = 0; pol < (foldComplements ? 2 : 1); pol++) {
+            uint32_t ref = (uint32_t)k | (pol ? BUCKET_NEGATED : 0);
+            void *value;
+            if (!st_lookup(pendingTable, (void *)(uintptr_t)bucketRefTt(bucket, ref), &value)) continue;
+            for (int t = (int)(intptr_t)value - 1; t >= 0; t = targets[t].nextSame) {
+                if (targets[t].result != 0) continue;
+                batchReport(&targets[t], buckets, order, ref, cache, group);
+                group->pending--;
+            }
+        }
+    }
+}
+
+static inline int runBatch(DdManager *manager, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Erro ao abrir o arquivo de alvos");
+        return EXIT_FAILURE;
+    }
+
+    BatchTarget *targets = NULL;
+    int targetCount = 0;
+    BatchGroup *groups = NULL;
+    int groupCount = 0;
+    char line[BATCH_LINE_MAX];
+    int lineNumber = 0;
+    NpnCache cache;
+    npnCacheLoad(&cache, NPN_CACHE_DEFAULT_PATH);
+
+    // Parse de todos os alvos no mesmo manager
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        bool hasVariable = false;
+        for (int i = 0; line[i] != '\0'; i++) {
+            if ((line[i] >= 'a' && line[i] <= 'z') || (line[i] >= 'A' && line[i] <= 'Z')) hasVariable = true;
+        }
+        if (!hasVariable) continue; //Linhas vazias ou de cabeçalho
+
+        Function *varMap = NULL;
+        int varCount = 0;
+        int literalCount = 0;
+        DdNode *objective = parseInputExpression(manager, line, &varMap, &varCount, &literalCount);
+        if (objective == NULL) {
+            fprintf(stderr, "ALVO %d: erro ao parsear a expressão\n", lineNumber);
+            free(varMap);
+            continue;
+        }
+
+        TruthTable tt = 0;
+        bool supported = varCount <= TT_MAX_VARS;
+        if (supported) tt = bddToTruthTable(manager, objective, varCount);
+
+        Cudd_RecursiveDeref(manager, objective);
+        for (int i = 0; i < varCount; i++) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+
+        if (!supported) {
+            fprintf(stderr, "ALVO %d: %d variáveis, o modo batch só cobre até %d\n", lineNumber, varCount, TT_MAX_VARS);
+            free(varMap);
+            continue;
+        }
+
+        BatchTarget target;
+        target.line = lineNumber;
+        target.expression = strdup(line);
+        target.nextSame = -1;
+        target.result = 0;
+
+        char names[TT_MAX_VARS + 1];
+        int supportCount = 0;
+        target.tt = batchProject(tt, varMap, varCount, names, &supportCount);
+        free(varMap);
+
+        if (supportCount == 0) {
+            printf("ALVO %d: %s\n", target.line, target.expression);
+            printf("A expressão é uma %s.\n", target.tt ? "tautologia (Sempre verdadeira)" : "contradição (Sempre falsa)");
+            free(target.expression);
+            continue;
+        }
+        if (batchCacheAnswer(&target, &cache, names, supportCount)) {
+            free(target.expression);
+            continue;
+        }
+
+        int g = 0;
+        while (g < groupCount && strcmp(groups[g].names, names) != 0) g++;
+        if (g == groupCount) {
+            groups = (BatchGroup *)realloc(groups, (groupCount + 1) * sizeof(BatchGroup));
+            if (groups == NULL) exit(EXIT_FAILURE);
+            memcpy(groups[g].names, names, sizeof(names));
+            groups[g].varCount = supportCount;
+            groups[g].maxOrder = 0;
+            groups[g].pending = 0;
+            groupCount++;
+        }
+        if (literalCount > groups[g].maxOrder) groups[g].maxOrder = literalCount;
+        groups[g].pending++;
+        target.group = g;
+
+        targets = (BatchTarget *)realloc(targets, (targetCount + 1) * sizeof(BatchTarget));
+        if (targets == NULL) exit(EXIT_FAILURE);
+        targets[targetCount++] = target;
+    }
+    fclose(file);
+
+    printf("Batch: %d alvos em %d grupos de suporte\n", targetCount, groupCount);
+    double start_time = omp_get_wtime();
+
+    // Uma enumeração por grupo
+    for (int g = 0; g < groupCount; g++) {
+        BatchGroup *group = &groups[g];
+        useTruthTable = true;
+        fullTt = ttFullMask(group->varCount);
+        objectiveTt = 0; // Constante, nunca é gerada pelas combinações
+
+        // Grupos anteriores podem ter resolvido a classe de alvos deste
+        for (int t = 0; t < targetCount; t++) {
+            if (targets[t].group == g && targets[t].result == 0 && batchCacheAnswer(&targets[t], &cache, group->names, group->varCount)) {
+                group->pending--;
+            }
+        }
+        if (group->pending == 0) continue;
+
+        printf("Grupo %s: %d alvos, até a ordem %d\n", group->names, group->pending, group->maxOrder);
+
+        // Tabela -> primeiro alvo pendente com ela (índice + 1, para não confundir com NULL)
+        st_table *pendingTable = st_init_table(st_ptrcmp, st_ptrhash);
+        SeenSet *uniqueCheck = seenSetCreate(true, group->varCount);
+        if (pendingTable == NULL || uniqueCheck == NULL) {
+            fprintf(stderr, "Erro ao criar as tabelas do grupo %s\n", group->names);
+            exit(EXIT_FAILURE);
+        }
+        for (int t = 0; t < targetCount; t++) {
+            if (targets[t].group != g || targets[t].result != 0) continue;
+            void *value;
+            if (st_lookup(pendingTable, (void *)(uintptr_t)targets[t].tt, &value)) {
+                int head = (int)(intptr_t)value - 1;
+                targets[t].nextSame = targets[head].nextSame;
+                targets[head].nextSame = t;
+            } else {
+                st_insert(pendingTable, (void *)(uintptr_t)targets[t].tt, (void *)(intptr_t)(t + 1));
+            }
+        }
+
+        int numBuckets = 0;
+        Bucket *buckets = NULL;
+        while (numBuckets < group->maxOrder) buckets = addBucket(buckets, &numBuckets);
+        literalBucketInit(&buckets[0], group->names, group->varCount, uniqueCheck);
+        batchScanBucket(buckets, 1, pendingTable, targets, group, &cache);
+
+        // Com até 4 variáveis o espaço inteiro pode saturar antes do limite
+        uint64_t functionTotal = bucketFunctionCount(&buckets[0]);
+        uint64_t functionSpace = (group->varCount < TT_MAX_VARS) ? (uint64_t)fullTt - 1 : UINT64_MAX;
+        for (int order = 2; order <= group->maxOrder && group->pending > 0 && functionTotal < functionSpace; order++) {
+            createCombinedBucket(manager, buckets, numBuckets, order, NULL, uniqueCheck, 'c');
+            functionTotal += bucketFunctionCount(&buckets[order - 1]);
+            batchScanBucket(buckets, order, pendingTable, targets, group, &cache);
+        }
+
+        for (int t = 0; t < targetCount; t++) {
+            if (targets[t].group == g && targets[t].result == 0) {
+                printf("ALVO %d: %s\n", targets[t].line, targets[t].expression);
+                printf("Nenhuma equivalência encontrada até a ordem %d.\n", group->maxOrder);
+            }
+        }
+
+        freeAllBuckets(manager, buckets, numBuckets);
+        seenSetFree(uniqueCheck);
+        st_free_table(pendingTable);
+    }
+
+    double end_time = omp_get_wtime();
+    printf("BENCHMARK_TIME: %.6f\n", end_time - start_time);
+    if (cache.hits > 0) printf("Cache NPN: %d alvos respondidos sem busca\n", cache.hits);
+    npnCacheFree(&cache);
+
+    for (int t = 0; t < targetCount; t++) free(targets[t].expression);
+    free(targets);
+    free(groups);
+    return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef BDD_H
+#define BDD_H
+
+/* Backend de BDD escolhido na compilação. Por padrão é o CUDD; com -DUSE_ROBDD (make robdd) os mesmos nomes
+Cudd_* passam a apontar para o pacote do robdd.h, que aceita várias threads no mesmo manager.
+O st.h continua vindo da instalação do CUDD nos dois casos. */
+#ifdef USE_ROBDD
+
+#include "robdd.h"
+
+typedef RbManager DdManager;
+typedef RbNode DdNode;
+
+#define BDD_THREAD_SAFE 1
+#define CUDD_UNIQUE_SLOTS 256
+#define CUDD_CACHE_SLOTS 262144
+
+#define Cudd_Init(numVars, numVarsZ, numSlots, cacheSize, maxMemory) rbInit(numVars)
+#define Cudd_Quit(manager) rbQuit(manager)
+#define Cudd_AutodynDisable(manager) ((void)(manager))
+#define Cudd_ReadOne(manager) rbReadOne(manager)
+#define Cudd_ReadLogicZero(manager) rbReadZero(manager)
+#define Cudd_Not(node) rbNot(node)
+#define Cudd_Regular(node) rbRegular(node)
+#define Cudd_NotCond(node, c) rbNotCond(node, c)
+#define Cudd_Ref(node) rbRef(node)
+#define Cudd_RecursiveDeref(manager, node) rbDeref(manager, node)
+#define Cudd_bddIthVar(manager, i) rbIthVar(manager, i)
+#define Cudd_bddAnd(manager, f, g) rbAnd(manager, f, g)
+#define Cudd_bddOr(manager, f, g) rbOr(manager, f, g)
+#define Cudd_bddLeq(manager, f, g) rbLeq(manager, f, g)
+#define Cudd_Cofactor(manager, f, cube) rbCofactor(manager, f, cube)
+#define Cudd_Eval(manager, f, inputs) rbEval(manager, f, inputs)
+#define Cudd_bddTransfer(src, dst, f) rbTransfer(src, dst, f)
+#define Cudd_PrintDebug(manager, f, n, pr) rbPrintDebug(manager, f, n, pr)
+
+#else
+
+#include <cudd.h>
+
+#define BDD_THREAD_SAFE 0
+
+#endif
+
+// Com o CUDD toda chamada no manager compartilhado precisa desta seção crítica; com o backend próprio ela some
+#if BDD_THREAD_SAFE
+#define BDD_CRITICAL
+#else
+#define BDD_CRITICAL _Pragma("omp critical(bdd_access)")
+#endif
+
+// Ponto entre ordens em que nenhuma thread está combinando. O backend próprio aproveita para coletar lixo
+static inline void bddSafePoint(DdManager *manager)
+{
+#ifdef USE_ROBDD
+    rbSafePoint(manager);
+#else
+    (void)manager;
+#endif
+}
+
+#endif
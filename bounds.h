@@ -0,0 +1,193 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bdd.h"
+#include "bucket.h"
+
+/* Limites para o laço de ordens. Inferior: toda variável essencial aparece ao menos uma vez, e uma variável binate
+pelo menos duas (com um literal só a fórmula seria unate nela). Superior: uma fatoração de Shannon gulosa, que em cada
+passo escolhe a variável que deixa um cofator constante (f = x*f1, !x*f0, x+f0 ou !x+f1), senão uma unate
+(f = f0 + x*f1) e só então uma binate (x*f1 + !x*f0). A incumbente começa como a própria entrada (literalCount literais) e a fatoração
+só a troca se achar menos: a busca só precisa ir até upper - 1 (nem monta os buckets acima disso) e, se nada aparecer,
+a incumbente é o mínimo. Com lower >= upper a busca nem começa. Só cofatores e Cudd_bddLeq, que os dois backends de BDD têm. */
+#define BOUNDS_EXPR_MAX 1024
+
+typedef struct {
+    int lower;
+    int upper; //Literais da incumbente (0 se nem a entrada coube em BOUNDS_EXPR_MAX)
+    char incumbent[BOUNDS_EXPR_MAX];
+    bool reported; //A resposta foi a incumbente, que não é um mínimo provado pela busca (fica fora do cache NPN)
+} Bounds;
+
+static inline DdNode *boundsCofactor(DdManager *manager, DdNode *f, DdNode *var, bool value)
+{
+    DdNode *result = Cudd_Cofactor(manager, f, Cudd_NotCond(var, !value));
+    Cudd_Ref(result);
+    return result;
+}
+
+// Junta dois operandos com parênteses como no printFunction (só em volta de operador diferente)
+static inline bool boundsJoin(char *out, size_t outSize, OpType op, const char *a, OpType aOp, const char *b, OpType bOp)
+{
+    bool parA = (aOp == AND || aOp == OR) && aOp != op;
+    bool parB = (bOp == AND || bOp == OR) && bOp != op;
+    int written = snprintf(out, outSize, "%s%s%s%c%s%s%s", parA ? "(" : "", a, parA ? ")" : "", (op == AND) ? '*' : '+',
+                           parB ? "(" : "", b, parB ? ")" : "");
+    return written < (int)outSize;
+}
+
+/* Fatora f (não constante) em out e devolve os literais, ou 0 se passar de budget. outOp = operador do topo.
+split >= 0 força a variável do primeiro passo, -1 escolhe pela regra gulosa */
+static inline int boundsFactor(DdManager *manager, DdNode *f, const Function *varMap, int varCount, int split, int budget,
+                               char *out, size_t outSize, OpType *outOp)
+{
+    if (budget < 1) return 0;
+    DdNode *one = Cudd_ReadOne(manager);
+    DdNode *zero = Cudd_ReadLogicZero(manager);
+
+    // Variável de divisão: constante > unate > binate
+    int best = -1, bestRank = 3;
+    for (int i = (split >= 0) ? split : 0; i < ((split >= 0) ? split + 1 : varCount) && bestRank > 0; i++) {
+        DdNode *f1 = boundsCofactor(manager, f, varMap[i].bdd, true);
+        DdNode *f0 = boundsCofactor(manager, f, varMap[i].bdd, false);
+        int rank = 3;
+        if (f1 != f0) {
+            if (f1 == one || f1 == zero || f0 == one || f0 == zero) rank = 0;
+            else if (Cudd_bddLeq(manager, f0, f1) || Cudd_bddLeq(manager, f1, f0)) rank = 1;
+            else rank = 2;
+        }
+        if (rank < bestRank) {
+            best = i;
+            bestRank = rank;
+        }
+        Cudd_RecursiveDeref(manager, f1);
+        Cudd_RecursiveDeref(manager, f0);
+    }
+    if (best < 0) return 0;
+
+    DdNode *var = varMap[best].bdd;
+    char name = varMap[best].varName;
+    DdNode *f1 = boundsCofactor(manager, f, var, true);
+    DdNode *f0 = boundsCofactor(manager, f, var, false);
+    char pos[3] = {name, '\0', '\0'};
+    char neg[3] = {'!', name, '\0'};
+
+    int literals = 0;
+    char left[BOUNDS_EXPR_MAX], right[BOUNDS_EXPR_MAX];
+    OpType leftOp, rightOp;
+    if (f == var || f == Cudd_Not(var)) {
+        literals = (snprintf(out, outSize, "%s", (f == var) ? pos : neg) < (int)outSize) ? 1 : 0;
+        *outOp = (f == var) ? VAR : NOT;
+    } else if (bestRank == 0) {
+        // Um cofator constante: literal e o outro cofator
+        bool positive = (f0 == zero || f0 == one);
+        DdNode *rest = positive ? f1 : f0;
+        OpType op = ((positive ? f0 : f1) == zero) ? AND : OR;
+        // f0 == 0: x*f1, f0 == 1: !x+f1, f1 == 0: !x*f0, f1 == 1: x+f0
+        bool literalPositive = (op == AND) ? positive : !positive;
+        int sub = boundsFactor(manager, rest, varMap, varCount, -1, budget - 1, right, sizeof(right), &rightOp);
+        if (sub > 0 && boundsJoin(out, outSize, op, literalPositive ? pos : neg, VAR, right, rightOp)) {
+            literals = sub + 1;
+            *outOp = op;
+        }
+    } else if (bestRank == 1) {
+        // Unate: f = f0 + x*f1 (positiva) ou f1 + !x*f0 (negativa)
+        bool positive = Cudd_bddLeq(manager, f0, f1);
+        DdNode *base = positive ? f0 : f1;
+        DdNode *guarded = positive ? f1 : f0;
+        int a = boundsFactor(manager, base, varMap, varCount, -1, budget - 2, left, sizeof(left), &leftOp);
+        int b = (a > 0) ? boundsFactor(manager, guarded, varMap, varCount, -1, budget - 1 - a, right, sizeof(right), &rightOp) : 0;
+        char term[BOUNDS_EXPR_MAX];
+        if (b > 0 && boundsJoin(term, sizeof(term), AND, positive ? pos : neg, VAR, right, rightOp) &&
+            boundsJoin(out, outSize, OR, left, leftOp, term, AND)) {
+            literals = a + b + 1;
+            *outOp = OR;
+        }
+    } else {
+        // Binate: x*f1 + !x*f0
+        int a = boundsFactor(manager, f1, varMap, varCount, -1, budget - 3, left, sizeof(left), &leftOp);
+        int b = (a > 0) ? boundsFactor(manager, f0, varMap, varCount, -1, budget - 2 - a, right, sizeof(right), &rightOp) : 0;
+        char termPos[BOUNDS_EXPR_MAX], termNeg[BOUNDS_EXPR_MAX];
+        if (b > 0 && boundsJoin(termPos, sizeof(termPos), AND, pos, VAR, left, leftOp) &&
+            boundsJoin(termNeg, sizeof(termNeg), AND, neg, VAR, right, rightOp) &&
+            boundsJoin(out, outSize, OR, termPos, AND, termNeg, AND)) {
+            literals = a + b + 2;
+            *outOp = OR;
+        }
+    }
+    Cudd_RecursiveDeref(manager, f1);
+    Cudd_RecursiveDeref(manager, f0);
+    return (literals <= budget) ? literals : 0;
+}
+
+// Entrada como incumbente, no formato da saída: letras maiúsculas e sem espaços. false se não couber
+static inline bool boundsSeedInput(Bounds *bounds, const char *input, int literalCount)
+{
+    size_t n = 0;
+    for (const char *c = input; *c != '\0'; c++) {
+        if (*c == ' ') continue;
+        if (n + 1 >= sizeof(bounds->incumbent)) return false;
+        bounds->incumbent[n++] = (*c >= 'a' && *c <= 'z') ? (char)(*c - ('a' - 'A')) : *c;
+    }
+    bounds->incumbent[n] = '\0';
+    bounds->upper = literalCount;
+    return true;
+}
+
+// Limites do objetivo (não constante), a partir da entrada (input, com literalCount literais)
+static inline void boundsCompute(DdManager *manager, DdNode *objectiveExp, const Function *varMap, int varCount, const char *input,
+                                 int literalCount, Bounds *bounds)
+{
+    bounds->lower = 0;
+    for (int i = 0; i < varCount; i++) {
+        DdNode *f1 = boundsCofactor(manager, objectiveExp, varMap[i].bdd, true);
+        DdNode *f0 = boundsCofactor(manager, objectiveExp, varMap[i].bdd, false);
+        if (f1 != f0) {
+            bool unate = Cudd_bddLeq(manager, f0, f1) || Cudd_bddLeq(manager, f1, f0);
+            bounds->lower += unate ? 1 : 2;
+        }
+        Cudd_RecursiveDeref(manager, f1);
+        Cudd_RecursiveDeref(manager, f0);
+    }
+
+    // A regra gulosa erra fácil no primeiro passo, então ele é tentado com cada variável
+    bounds->upper = 0;
+    bounds->incumbent[0] = '\0';
+    bool seeded = boundsSeedInput(bounds, input, literalCount);
+    for (int i = 0; i < varCount; i++) {
+        char expression[BOUNDS_EXPR_MAX];
+        OpType op;
+        int budget = (bounds->upper > 0) ? bounds->upper - 1 : literalCount;
+        int literals = boundsFactor(manager, objectiveExp, varMap, varCount, i, budget, expression, sizeof(expression), &op);
+        if (literals > 0) {
+            bounds->upper = literals;
+            strcpy(bounds->incumbent, expression);
+            seeded = false;
+        }
+    }
+
+    if (seeded) {
+        printf("Limites: inferior %d, superior %d (incumbente: a entrada)\n", bounds->lower, bounds->upper);
+    } else if (bounds->upper > 0) {
+        printf("Limites: inferior %d, superior %d (incumbente %s)\n", bounds->lower, bounds->upper, bounds->incumbent);
+    } else {
+        printf("Limites: inferior %d, superior %d (entrada)\n", bounds->lower, literalCount);
+    }
+}
+
+// Nada menor que a incumbente apareceu (ou os limites se encontraram): ela é o resultado
+static inline void boundsReportIncumbent(Bounds *bounds)
+{
+    bounds->reported = true;
+    printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", bounds->upper);
+    printf("RESULTADO_LITERAIS: %d\n", bounds->upper);
+    printf("RESULTADO_EXPRESSAO: ");
+    bucketPuts(bounds->incumbent); // Pela cópia do bucket.h, para o cache NPN
+    printf("\n");
+}
+
+#endif
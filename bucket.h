@@ -0,0 +1,537 @@
+#ifndef BUCKET_H
+#define BUCKET_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bdd.h"
+#include "truthtable.h"
+#include "signature.h"
+
+// Tipos compartilhados entre teste.c, parallel.c e parallel2.c
+
+typedef enum{
+    VAR,
+    NOT,
+    AND,
+    OR
+} OpType;
+
+typedef struct Function
+{
+    DdNode *bdd; //NULL quando o backend é tabela verdade
+    TruthTable tt; //Apenas se o backend for tabela verdade
+    struct Function *left;
+    struct Function *right;
+    OpType operador;
+    char varName; //Apenas se operador == VAR
+} Function;
+
+// Candidatos do bucket para o goal check do modo e (goalcheck.h)
+typedef struct {
+    uint32_t *index; //Posição do candidato no bucket
+    TruthTable *residueTt;
+    DdNode **residueBdd;
+    Signature *residueSig; //Só no backend BDD com assinaturas (signature.h)
+    int32_t *subsetWitness; //Só com até 4 variáveis
+    int count;
+    uint64_t *partMask; //Candidatos em partições por máscara de suporte (sem o subsetWitness)
+    int *partStart; //partCount + 1 posições
+    int partCount;
+} GoalCandidates;
+
+typedef struct {
+    GoalCandidates andSide; //g >= objetivo
+    GoalCandidates orSide; //g <= objetivo
+    bool built;
+} GoalIndex;
+
+/* Bucket em colunas: a chave de cada função (tabela verdade ou BDD) fica num vetor contíguo e a origem em vetores
+paralelos, então os laços k/l só leem chaves em sequência e nenhuma função custa um malloc.
+A função k do bucket de ordem n é (bucket leftOrder[k], posição left[k]) op (bucket n - leftOrder[k], posição right[k]).
+No bucket 1 op é VAR ou NOT, leftOrder é 0 e left guarda o nome da variável.
+A expressão só é remontada na hora de imprimir (printBucketFunction). O mesmo tipo serve de área local das threads
+durante uma ordem (bucketAppend cresce sem trava) e as áreas são juntadas no bucket de uma vez no fim (bucketPublish). */
+typedef struct
+{
+    TruthTable *tt; //Só no backend de tabela verdade
+    DdNode **bdd; //Só no backend BDD
+    uint32_t *left;
+    uint32_t *right;
+    uint8_t *leftOrder;
+    uint8_t *op; //OpType
+    int order;
+    int size;
+    int capacity;
+    GoalIndex goal; //Montado só quando o goal check consulta o bucket
+    Signature *sig; //Assinatura por simulação de cada função (signature.h), montada quando o bucket é consultado
+    uint64_t *support; //Variáveis usadas pela fórmula de cada função (bucketSupportBuild), montado pelo goal check
+    bool mapped; //tt/left/right/leftOrder/op apontam para um snapshot mapeado (snapshot.h) e não são liberadas aqui
+} Bucket;
+
+typedef struct {
+    uint32_t left;
+    uint32_t right;
+    DdNode *bdd;
+    TruthTable tt;
+    uint8_t leftOrder;
+    char op;
+} CombinationBuffer;
+
+// Implementada em cada executável
+void printFunction(Function* node);
+
+// Estado do backend, definido em cada executável
+extern bool useTruthTable;
+extern TruthTable objectiveTt;
+extern TruthTable fullTt;
+extern bool foldComplements;
+
+/* Dobra de complementos: as fórmulas são NNF de literais com AND/OR, então !f custa os mesmos literais que f (a fórmula
+dual, com AND/OR trocados e os literais invertidos). Quando o bucket 1 tem as duas polaridades de todas as variáveis,
+foldComplements fica ligado e cada bucket guarda um representante só por par {f, !f}: na tabela verdade o que vale 1
+com todas as variáveis em 1, no BDD o nó regular. Qualquer referência a uma função (left/right das colunas, índices
+do goal check) pode levar BUCKET_NEGATED e aí vale o complemento; a expressão dual só é montada na impressão. */
+#define BUCKET_NEGATED 0x80000000u
+#define BUCKET_INDEX(ref) ((ref) & ~BUCKET_NEGATED)
+
+static inline TruthTable bucketCanonicalTt(TruthTable tt)
+{
+    TruthTable top = (fullTt >> 1) + 1;
+    return (tt & top) ? tt : (~tt & fullTt);
+}
+
+static inline DdNode *bucketCanonicalBdd(DdNode *bdd)
+{
+    return Cudd_Regular(bdd);
+}
+
+static inline OpType bucketDualOp(OpType op)
+{
+    switch (op) {
+        case VAR: return NOT;
+        case NOT: return VAR;
+        case AND: return OR;
+        default: return AND;
+    }
+}
+
+// !(left op right) = (!left) dual(op) (!right)
+static inline void bucketDualize(OpType *op, uint32_t *left, uint32_t *right)
+{
+    *op = bucketDualOp(*op);
+    *left ^= BUCKET_NEGATED;
+    *right ^= BUCKET_NEGATED;
+}
+
+/* Previsão de quantas funções novas a ordem targetOrder vai gerar, para o conjunto de duplicatas reservar espaço antes.
+Usa a razão de crescimento entre os dois últimos buckets (no mínimo 2x), limitada pelo total de combinações possíveis. */
+static inline size_t predictBucketGrowth(Bucket *buckets, int targetOrder)
+{
+    double pairs = 0;
+    for (int i = 0; i < targetOrder - 1; i++) {
+        int j = targetOrder - (i + 1) - 1;
+        if (j < i) break;
+        double n1 = buckets[i].size, n2 = buckets[j].size;
+        pairs += (i == j) ? n1 * (n1 + 1) / 2 : n1 * n2;
+    }
+    pairs *= 2; // AND e OR
+
+    double last = buckets[targetOrder - 2].size;
+    double prev = (targetOrder >= 3) ? buckets[targetOrder - 3].size : 0;
+    double ratio = (prev > 0 && last / prev > 2) ? last / prev : 2;
+    double predicted = last * ratio;
+    if (predicted > pairs) predicted = pairs;
+    return (size_t)predicted;
+}
+
+static inline void bucketReserve(Bucket *bucket, int capacity)
+{
+    if (capacity <= bucket->capacity) return;
+    if (useTruthTable) {
+        bucket->tt = (TruthTable *)realloc(bucket->tt, capacity * sizeof(TruthTable));
+    } else {
+        bucket->bdd = (DdNode **)realloc(bucket->bdd, capacity * sizeof(DdNode *));
+    }
+    bucket->left = (uint32_t *)realloc(bucket->left, capacity * sizeof(uint32_t));
+    bucket->right = (uint32_t *)realloc(bucket->right, capacity * sizeof(uint32_t));
+    bucket->leftOrder = (uint8_t *)realloc(bucket->leftOrder, capacity * sizeof(uint8_t));
+    bucket->op = (uint8_t *)realloc(bucket->op, capacity * sizeof(uint8_t));
+    if ((useTruthTable ? (void *)bucket->tt : (void *)bucket->bdd) == NULL || bucket->left == NULL ||
+        bucket->right == NULL || bucket->leftOrder == NULL || bucket->op == NULL) {
+        fprintf(stderr, "Erro ao realocar as colunas do bucket\n");
+        exit(EXIT_FAILURE);
+    }
+    bucket->capacity = capacity;
+}
+
+static inline void bucketAppend(Bucket *bucket, TruthTable tt, DdNode *bdd, OpType op, int leftOrder, uint32_t left, uint32_t right)
+{
+    if (bucket->size == bucket->capacity) bucketReserve(bucket, (bucket->capacity == 0) ? 256 : bucket->capacity * 2);
+    int k = bucket->size++;
+    if (useTruthTable) {
+        bucket->tt[k] = tt;
+    } else {
+        bucket->bdd[k] = bdd;
+    }
+    bucket->left[k] = left;
+    bucket->right[k] = right;
+    bucket->leftOrder[k] = (uint8_t)leftOrder;
+    bucket->op[k] = (uint8_t)op;
+}
+
+static inline void bucketAppendLiteral(Bucket *bucket, TruthTable tt, DdNode *bdd, char varName, bool negated)
+{
+    bucketAppend(bucket, tt, bdd, negated ? NOT : VAR, 0, (uint32_t)(unsigned char)varName, 0);
+}
+
+/* Entrada nova com a dobra: tt/bdd já é o representante, e complemented diz se op(left, right) deu o complemento dele
+(aí fica guardada a combinação dual, que dá exatamente o representante). */
+static inline void bucketAppendFolded(Bucket *bucket, TruthTable tt, DdNode *bdd, bool complemented, OpType op, int leftOrder, uint32_t left, uint32_t right)
+{
+    if (complemented) bucketDualize(&op, &left, &right);
+    bucketAppend(bucket, tt, bdd, op, leftOrder, left, right);
+}
+
+static inline void bucketFreeColumns(Bucket *bucket)
+{
+    if (!bucket->mapped) {
+        free(bucket->tt);
+        free(bucket->bdd);
+        free(bucket->left);
+        free(bucket->right);
+        free(bucket->leftOrder);
+        free(bucket->op);
+    }
+    bucket->mapped = false;
+    free(bucket->sig);
+    free(bucket->support);
+    bucket->sig = NULL;
+    bucket->support = NULL;
+    bucket->tt = NULL;
+    bucket->bdd = NULL;
+    bucket->left = NULL;
+    bucket->right = NULL;
+    bucket->leftOrder = NULL;
+    bucket->op = NULL;
+    bucket->size = 0;
+    bucket->capacity = 0;
+}
+
+// Junta as áreas locais das threads no bucket, na ordem das threads, e libera as áreas
+static inline void bucketPublish(Bucket *bucket, int order, Bucket *parts, int partCount)
+{
+    int total = 0;
+    for (int p = 0; p < partCount; p++) total += parts[p].size;
+
+    bucket->order = order;
+    bucket->size = 0;
+    if (total > 0) bucketReserve(bucket, total);
+    for (int p = 0; p < partCount; p++) {
+        Bucket *part = &parts[p];
+        int n = part->size;
+        if (n == 0) continue;
+        if (useTruthTable) {
+            memcpy(bucket->tt + bucket->size, part->tt, n * sizeof(TruthTable));
+        } else {
+            memcpy(bucket->bdd + bucket->size, part->bdd, n * sizeof(DdNode *));
+        }
+        memcpy(bucket->left + bucket->size, part->left, n * sizeof(uint32_t));
+        memcpy(bucket->right + bucket->size, part->right, n * sizeof(uint32_t));
+        memcpy(bucket->leftOrder + bucket->size, part->leftOrder, n * sizeof(uint8_t));
+        memcpy(bucket->op + bucket->size, part->op, n * sizeof(uint8_t));
+        bucket->size += n;
+    }
+    for (int p = 0; p < partCount; p++) bucketFreeColumns(&parts[p]);
+}
+
+// Chave da função no conjunto de duplicatas: o ponteiro do BDD ou a própria tabela verdade
+static inline uint64_t bucketKey(const Bucket *bucket, int k)
+{
+    return useTruthTable ? bucket->tt[k] : (uint64_t)(uintptr_t)bucket->bdd[k];
+}
+
+// Compara com o objetivo no backend ativo (com a dobra, o representante pode ser o complemento do objetivo)
+static inline bool bucketIsObjective(const Bucket *bucket, int k, DdNode *objectiveExp)
+{
+    if (useTruthTable) {
+        return bucket->tt[k] == objectiveTt || (foldComplements && bucket->tt[k] == (~objectiveTt & fullTt));
+    }
+    return bucket->bdd[k] == objectiveExp || (foldComplements && bucket->bdd[k] == Cudd_Not(objectiveExp));
+}
+
+/* Assinaturas do bucket order (1 = buckets[0]): o bucket 1 é avaliado direto, os outros saem das assinaturas dos pais,
+que já têm que estar montadas. O bucket não muda depois de publicado, então a coluna é montada uma vez só */
+static inline void bucketSigBuild(DdManager *manager, Bucket *buckets, int order)
+{
+    Bucket *bucket = &buckets[order - 1];
+    if (!sigEnabled || useTruthTable || bucket->sig != NULL || bucket->size == 0) return;
+    bucket->sig = (Signature *)malloc((size_t)bucket->size * sizeof(Signature));
+    if (bucket->sig == NULL) {
+        fprintf(stderr, "Erro ao alocar as assinaturas do bucket %d\n", order);
+        exit(EXIT_FAILURE);
+    }
+    for (int k = 0; k < bucket->size; k++) {
+        if (order == 1) {
+            bucket->sig[k] = sigEvaluate(manager, bucket->bdd[k]);
+            continue;
+        }
+        const Bucket *b1 = &buckets[bucket->leftOrder[k] - 1];
+        const Bucket *b2 = &buckets[order - bucket->leftOrder[k] - 1];
+        Signature left = sigNotCond(b1->sig[BUCKET_INDEX(bucket->left[k])], (bucket->left[k] & BUCKET_NEGATED) != 0);
+        Signature right = sigNotCond(b2->sig[BUCKET_INDEX(bucket->right[k])], (bucket->right[k] & BUCKET_NEGATED) != 0);
+        bucket->sig[k] = sigCombine(&left, &right, bucket->op[k] == AND);
+    }
+}
+
+// Monta as assinaturas dos buckets 1..order que ainda não têm. Chamada fora das regiões paralelas
+static inline void bucketSigEnsure(DdManager *manager, Bucket *buckets, int order)
+{
+    for (int o = 1; o <= order; o++) bucketSigBuild(manager, buckets, o);
+}
+
+// Assinatura de uma referência em out (com BUCKET_NEGATED, o complemento). NULL se o bucket não tem assinaturas
+static inline const Signature *bucketRefSig(const Bucket *bucket, uint32_t ref, Signature *out)
+{
+    if (bucket->sig == NULL) return NULL;
+    *out = sigNotCond(bucket->sig[BUCKET_INDEX(ref)], (ref & BUCKET_NEGATED) != 0);
+    return out;
+}
+
+/* Suporte de cada função: o bit v fica ligado se a fórmula guardada usa a v-ésima variável distinta do bucket 1.
+O suporte da fórmula contém o da função, e o bucket 1 só tem as variáveis das quais o objetivo depende
+(initializeFirstBucket), então uma combinação cujo suporte não cobre todas elas nunca é o objetivo nem o complemento.
+O suporte de uma combinação é a união dos suportes dos pais (a negação não muda nada), então, como nas assinaturas,
+só o bucket 1 é olhado de verdade. Com mais de BUCKET_SUPPORT_MAX_VARS variáveis a coluna não existe */
+#define BUCKET_SUPPORT_MAX_VARS 64
+
+static inline void bucketSupportBuild(Bucket *buckets, int order)
+{
+    Bucket *bucket = &buckets[order - 1];
+    if (bucket->support != NULL || bucket->size == 0) return;
+    if (order > 1 && buckets[0].support == NULL) return;
+    bucket->support = (uint64_t *)malloc((size_t)bucket->size * sizeof(uint64_t));
+    if (bucket->support == NULL) {
+        fprintf(stderr, "Erro ao alocar o suporte do bucket %d\n", order);
+        exit(EXIT_FAILURE);
+    }
+    int vars = 0;
+    for (int k = 0; k < bucket->size; k++) {
+        if (order > 1) {
+            const Bucket *b1 = &buckets[bucket->leftOrder[k] - 1];
+            const Bucket *b2 = &buckets[order - bucket->leftOrder[k] - 1];
+            bucket->support[k] = b1->support[BUCKET_INDEX(bucket->left[k])] | b2->support[BUCKET_INDEX(bucket->right[k])];
+            continue;
+        }
+        // Bucket 1: as duas polaridades de uma variável dividem o bit
+        int l = 0;
+        while (l < k && bucket->left[l] != bucket->left[k]) l++;
+        if (l < k) {
+            bucket->support[k] = bucket->support[l];
+        } else if (vars < BUCKET_SUPPORT_MAX_VARS) {
+            bucket->support[k] = (uint64_t)1 << vars++;
+        } else {
+            free(bucket->support);
+            bucket->support = NULL;
+            return;
+        }
+    }
+}
+
+// Monta o suporte dos buckets 1..order que ainda não têm. Chamada fora das regiões paralelas
+static inline void bucketSupportEnsure(Bucket *buckets, int order)
+{
+    for (int o = 1; o <= order; o++) bucketSupportBuild(buckets, o);
+}
+
+// Suporte que o objetivo exige: todas as variáveis do bucket 1 (0 se não há coluna de suporte)
+static inline uint64_t bucketSupportFull(const Bucket *buckets)
+{
+    uint64_t full = 0;
+    if (buckets[0].support == NULL) return 0;
+    for (int k = 0; k < buckets[0].size; k++) full |= buckets[0].support[k];
+    return full;
+}
+
+// Tabela verdade de uma referência (com BUCKET_NEGATED, o complemento do representante)
+static inline TruthTable bucketRefTt(const Bucket *bucket, uint32_t ref)
+{
+    TruthTable tt = bucket->tt[BUCKET_INDEX(ref)];
+    return (ref & BUCKET_NEGATED) ? ~tt & fullTt : tt;
+}
+
+// Referência que vale exatamente o objetivo, para imprimir (só faz sentido se bucketIsObjective)
+static inline uint32_t bucketObjectiveRef(const Bucket *bucket, int k, DdNode *objectiveExp)
+{
+    bool exact = useTruthTable ? bucket->tt[k] == objectiveTt : bucket->bdd[k] == objectiveExp;
+    return (uint32_t)k | (exact ? 0 : BUCKET_NEGATED);
+}
+
+/* Liga a dobra se o bucket 1 tiver as duas polaridades de todas as variáveis e tira os literais que não são
+representantes. Com o filtro de unate tirando alguma polaridade a dobra não vale (o complemento sairia do espaço). */
+static inline bool bucketFoldLiterals(DdManager *manager, Bucket *bucket)
+{
+    for (int k = 0; k < bucket->size; k++) {
+        bool paired = false;
+        for (int l = 0; l < bucket->size && !paired; l++) {
+            paired = bucket->left[l] == bucket->left[k] && bucket->op[l] != bucket->op[k];
+        }
+        if (!paired) return false;
+    }
+
+    int kept = 0;
+    for (int k = 0; k < bucket->size; k++) {
+        bool canonical = useTruthTable ? bucket->tt[k] == bucketCanonicalTt(bucket->tt[k])
+                                       : bucket->bdd[k] == bucketCanonicalBdd(bucket->bdd[k]);
+        if (!canonical) {
+            if (!useTruthTable) Cudd_RecursiveDeref(manager, bucket->bdd[k]);
+            continue;
+        }
+        if (useTruthTable) bucket->tt[kept] = bucket->tt[k];
+        else bucket->bdd[kept] = bucket->bdd[k];
+        bucket->left[kept] = bucket->left[k];
+        bucket->right[kept] = bucket->right[k];
+        bucket->leftOrder[kept] = bucket->leftOrder[k];
+        bucket->op[kept] = bucket->op[k];
+        kept++;
+    }
+    bucket->size = kept;
+    return true;
+}
+
+/* Cópia em texto do que printBucketFunction/printBucketCombination escrevem, para quem precisa guardar a expressão do
+resultado (cache NPN). Só quem imprime o resultado escreve, e nas versões paralelas isso já acontece dentro de um
+critical. Comprimento -1 = desligado, -2 = estourou o buffer (a cópia é descartada). */
+#define BUCKET_ECHO_MAX 1024
+static char bucketEcho[BUCKET_ECHO_MAX];
+static int bucketEchoLength = -1;
+static bool bucketEchoSilent = false; //Só copia, sem imprimir
+
+static inline void bucketEchoBegin(void)
+{
+    bucketEchoLength = 0;
+    bucketEcho[0] = '\0';
+}
+
+// Como o bucketEchoBegin, mas o texto só vai para a cópia
+static inline void bucketEchoCapture(void)
+{
+    bucketEchoBegin();
+    bucketEchoSilent = true;
+}
+
+// Texto impresso desde o bucketEchoBegin (NULL se nada coube) e desliga a cópia
+static inline const char *bucketEchoEnd(void)
+{
+    int length = bucketEchoLength;
+    bucketEchoLength = -1;
+    bucketEchoSilent = false;
+    return (length > 0) ? bucketEcho : NULL;
+}
+
+static inline void bucketPuts(const char *text)
+{
+    if (!bucketEchoSilent) fputs(text, stdout);
+    if (bucketEchoLength < 0) return;
+    size_t length = strlen(text);
+    if (bucketEchoLength + length >= BUCKET_ECHO_MAX) {
+        bucketEchoLength = -2; // Estourou: fica desligado até o bucketEchoEnd
+        return;
+    }
+    memcpy(bucketEcho + bucketEchoLength, text, length + 1);
+    bucketEchoLength += (int)length;
+}
+
+// Operador que aparece na impressão da referência (o dual se ela for negada)
+static inline OpType bucketRefOp(Bucket *buckets, int order, uint32_t ref)
+{
+    OpType op = (OpType)buckets[order - 1].op[BUCKET_INDEX(ref)];
+    return (ref & BUCKET_NEGATED) ? bucketDualOp(op) : op;
+}
+
+static inline void printBucketCombination(Bucket *buckets, OpType op, int leftOrder, uint32_t left, int rightOrder, uint32_t right);
+
+// Mesma saída do printFunction, remontando a expressão pelos índices. Referência negada sai como a fórmula dual
+static inline void printBucketFunction(Bucket *buckets, int order, uint32_t ref)
+{
+    Bucket *bucket = &buckets[order - 1];
+    uint32_t k = BUCKET_INDEX(ref);
+    OpType op = bucketRefOp(buckets, order, ref);
+    if (op == VAR || op == NOT) {
+        char literal[3] = {'!', (char)bucket->left[k], '\0'};
+        bucketPuts((op == NOT) ? literal : literal + 1);
+    } else {
+        int leftOrder = bucket->leftOrder[k];
+        uint32_t left = bucket->left[k];
+        uint32_t right = bucket->right[k];
+        if (ref & BUCKET_NEGATED) {
+            left ^= BUCKET_NEGATED;
+            right ^= BUCKET_NEGATED;
+        }
+        printBucketCombination(buckets, op, leftOrder, left, order - leftOrder, right);
+    }
+}
+
+// Imprime (left op right) sem precisar da função estar em bucket nenhum (usado nos relatórios de equivalência)
+static inline void printBucketCombination(Bucket *buckets, OpType op, int leftOrder, uint32_t left, int rightOrder, uint32_t right)
+{
+    OpType leftOp = bucketRefOp(buckets, leftOrder, left);
+    OpType rightOp = bucketRefOp(buckets, rightOrder, right);
+
+    bool parLeft = (leftOp != VAR && leftOp != NOT && leftOp != op);
+    if (parLeft) bucketPuts("(");
+    printBucketFunction(buckets, leftOrder, left);
+    if (parLeft) bucketPuts(")");
+
+    bucketPuts(op == AND ? "*" : "+");
+
+    bool parRight = (rightOp != VAR && rightOp != NOT && rightOp != op);
+    if (parRight) bucketPuts("(");
+    printBucketFunction(buckets, rightOrder, right);
+    if (parRight) bucketPuts(")");
+}
+
+/* Monta uma árvore de Function para a função k do bucket de ordem order, para quem precisa guardar a expressão
+depois que os buckets forem liberados (top-down). Os nós não são compartilhados: libera com freeFunctionTree. */
+static inline Function *bucketMaterialize(Bucket *buckets, int order, uint32_t ref)
+{
+    Bucket *bucket = &buckets[order - 1];
+    uint32_t k = BUCKET_INDEX(ref);
+    bool negated = (ref & BUCKET_NEGATED) != 0;
+    Function *node = (Function *)calloc(1, sizeof(Function));
+    if (node == NULL) {
+        fprintf(stderr, "Erro ao alocar nó da expressão\n");
+        exit(EXIT_FAILURE);
+    }
+    node->tt = useTruthTable ? (negated ? ~bucket->tt[k] & fullTt : bucket->tt[k]) : 0;
+    node->bdd = useTruthTable ? NULL : Cudd_NotCond(bucket->bdd[k], negated);
+    node->operador = bucketRefOp(buckets, order, ref);
+    if (node->operador == VAR) {
+        node->varName = (char)bucket->left[k];
+    } else if (node->operador == NOT) {
+        node->left = (Function *)calloc(1, sizeof(Function));
+        if (node->left == NULL) exit(EXIT_FAILURE);
+        node->left->operador = VAR;
+        node->left->varName = (char)bucket->left[k];
+        node->left->tt = ~node->tt & fullTt;
+    } else {
+        int leftOrder = bucket->leftOrder[k];
+        uint32_t flip = negated ? BUCKET_NEGATED : 0;
+        node->left = bucketMaterialize(buckets, leftOrder, bucket->left[k] ^ flip);
+        node->right = bucketMaterialize(buckets, order - leftOrder, bucket->right[k] ^ flip);
+    }
+    return node;
+}
+
+static inline void freeFunctionTree(Function *node)
+{
+    if (node == NULL) return;
+    freeFunctionTree(node->left);
+    freeFunctionTree(node->right);
+    free(node);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef CACHEDIR_H
+#define CACHEDIR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/* Pasta dos dados que ficam de uma execução para outra (cache NPN, snapshots dos buckets e checkpoints). Tudo isso é
+opcional: só liga com a variável de ambiente CACHE_DIR_ENV apontando para a pasta (criada se não existir). O
+benchmark.sh não a define, então cada repetição mede a busca e não uma consulta. Os arquivos da pasta somam no máximo
+CACHE_DIR_MAX_ENV megabytes (CACHE_DIR_DEFAULT_MB se não definida): o que passaria disso não é gravado. */
+#define CACHE_DIR_ENV "TCC_CACHE_DIR"
+#define CACHE_DIR_MAX_ENV "TCC_CACHE_MAX_MB"
+#define CACHE_DIR_DEFAULT_MB 1024
+#define CACHE_DIR_NAME_MAX 192 //Sobra espaço para o nome do arquivo nos caminhos de 256
+
+// Pasta do cache, ou NULL se ele está desligado
+static inline const char *cacheDir(void)
+{
+    const char *dir = getenv(CACHE_DIR_ENV);
+    if (dir == NULL || dir[0] == '\0') return NULL;
+    if (strlen(dir) > CACHE_DIR_NAME_MAX) {
+        fprintf(stderr, "Aviso: %s com mais de %d caracteres, cache desligado\n", CACHE_DIR_ENV, CACHE_DIR_NAME_MAX);
+        return NULL;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror("Aviso: não foi possível criar a pasta do cache, cache desligado");
+        return NULL;
+    }
+    return dir;
+}
+
+static inline uint64_t cacheDirLimit(void)
+{
+    const char *value = getenv(CACHE_DIR_MAX_ENV);
+    long long megabytes = (value != NULL) ? atoll(value) : 0;
+    if (megabytes <= 0) megabytes = CACHE_DIR_DEFAULT_MB;
+    return (uint64_t)megabytes << 20;
+}
+
+// Soma dos arquivos da pasta, sem contar skip (o arquivo que vai ser trocado)
+static inline uint64_t cacheDirUsage(const char *dir, const char *skip)
+{
+    DIR *handle = opendir(dir);
+    if (handle == NULL) return 0;
+    uint64_t total = 0;
+    char path[CACHE_DIR_NAME_MAX + 288];
+    struct dirent *entry;
+    while ((entry = readdir(handle)) != NULL) {
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (skip != NULL && strcmp(path, skip) == 0) continue;
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) total += (uint64_t)st.st_size;
+    }
+    closedir(handle);
+    return total;
+}
+
+/* Cabe gravar bytes em path (que substitui o arquivo atual, se houver)? Avisa quando não cabe */
+static inline bool cacheDirFits(const char *path, uint64_t bytes)
+{
+    const char *dir = cacheDir();
+    if (dir == NULL) return false;
+    uint64_t limit = cacheDirLimit();
+    uint64_t usage = cacheDirUsage(dir, path);
+    if (usage + bytes <= limit) return true;
+    fprintf(stderr, "Aviso: %s (%llu MB) passaria do limite de %llu MB da pasta %s, não gravado\n", path,
+            (unsigned long long)(bytes >> 20), (unsigned long long)(limit >> 20), dir);
+    return false;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef CANCEL_H
+#define CANCEL_H
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Token de cancelamento do modo e. Substitui o bool stop com #pragma omp flush: o flush é uma barreira de memória
+completa a cada teste, e o teste ficava no corpo dos laços, que seguiam até o fim com continue. Aqui o teste é uma
+leitura atômica relaxada, barata o bastante para entrar na condição dos laços de bloco (tile) e de trecho da linha,
+então depois do acerto cada thread termina no máximo o trecho em que está. O primeiro a levantar o token é quem
+imprime o resultado, sem precisar de seção crítica. */
+typedef struct {
+    _Alignas(64) atomic_bool raised;
+    char pad[64 - sizeof(atomic_bool)]; //Linha de cache só do token, lida por todas as threads
+} CancelToken;
+
+static inline void cancelInit(CancelToken *token)
+{
+    atomic_init(&token->raised, false);
+}
+
+// true só para quem levantou o token primeiro
+static inline bool cancelRaise(CancelToken *token)
+{
+    return !atomic_exchange_explicit(&token->raised, true, memory_order_acq_rel);
+}
+
+static inline bool cancelRaised(CancelToken *token)
+{
+    return atomic_load_explicit(&token->raised, memory_order_relaxed);
+}
+
+#endif
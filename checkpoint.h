@@ -0,0 +1,299 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "pairspace.h"
+#include "snapshot.h"
+
+/* Checkpoint de uma busca longa, para continuar em outra execução (--resume) em vez de jogar fora tudo no timeout.
+As ordens completas já vão para o snapshot (snapshot.h) no fim de cada ordem, e o conjunto de duplicatas é só a união
+das chaves dos buckets, então sai de novo deles. O que falta é a ordem em andamento: com SIGTERM (o timeout do
+benchmark.sh) ou SIGINT cada thread termina o bloco (PairTile) em que está e para de pegar trabalho; no parallel2 as
+filas ainda esvaziam. Então são gravados, ao lado do snapshot (.ckpt), os blocos prontos de cada espaço de pares e as
+funções da ordem aceitas até ali. Um segundo sinal mata o processo na hora.
+Na volta os espaços de pares são cortados com o mesmo número de workers de quem gravou (os blocos dependem dele), os
+blocos prontos são pulados e as funções entram de novo no bucket e no conjunto de duplicatas. Como os buckets, o
+progresso não depende do objetivo: o goal check do modo e já cobre a ordem antes de ela ser montada, e o modo c procura
+no bucket completo. Um checkpoint só vale com o snapshot em que foi gravado (hash das chaves das ordens anteriores). */
+#define CHECKPOINT_MAGIC "TCCCKPNT"
+#define CHECKPOINT_VERSION 1
+/* O --resume recarrega o parcial inteiro e põe cada chave de novo no conjunto de duplicatas: acima disso (ou do limite da
+pasta do cache) o checkpoint não é gravado e a ordem recomeça do snapshot, ou do checkpoint menor que já estava lá */
+#define CHECKPOINT_MAX_BYTES ((uint64_t)256 << 20)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t varCount;
+    uint64_t firstBucketHash;
+    uint64_t bucketsHash; //Chaves dos buckets 1..order-1
+    uint32_t folded;
+    uint32_t order; //Ordem em andamento
+    uint32_t workers; //workers do pairSpaceInit
+    uint32_t tileCount; //Seguido de tileCount bytes (1 = bloco pronto) e das colunas das funções aceitas
+    uint64_t entries;
+} CheckpointHeader;
+
+// Progresso da ordem em andamento: blocos de todos os espaços de pares, em sequência
+typedef struct {
+    int order;
+    int workers;
+    int *tileBase; //Primeiro bloco do espaço i
+    int tileCount;
+    uint8_t *done; //NULL com o checkpoint desligado
+} CheckpointProgress;
+
+typedef struct {
+    bool active;
+    char path[BUCKET_SNAPSHOT_PATH_MAX + 8];
+    const BucketSnapshot *snapshot;
+    // Checkpoint lido com --resume (order = 0 se não há)
+    int order;
+    int workers;
+    int tileCount;
+    char *data;
+    Bucket partial;
+    int resumed; //Ordem que foi retomada (o arquivo some quando ela termina)
+} CheckpointState;
+
+static CheckpointState checkpointState;
+static atomic_bool checkpointStop; //Levantado pelo sinal, lido pelas threads a cada bloco
+
+static void checkpointHandler(int sig)
+{
+    (void)sig;
+    atomic_store_explicit(&checkpointStop, true, memory_order_relaxed);
+}
+
+static inline bool checkpointStopRequested(void)
+{
+    return atomic_load_explicit(&checkpointStop, memory_order_relaxed);
+}
+
+static inline uint64_t checkpointBucketsHash(const Bucket *buckets, int order)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int o = 1; o < order; o++) {
+        hash = (hash ^ (uint64_t)buckets[o - 1].size) * 0x100000001b3ULL;
+        for (int k = 0; k < buckets[o - 1].size; k++) hash = (hash ^ buckets[o - 1].tt[k]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* Liga o checkpoint (depois do bucketSnapshotOpen) e, com resume, lê o da ordem seguinte à última do snapshot.
+Checkpoint de outra ordem ou de outro snapshot é ignorado */
+static inline void checkpointInit(const BucketSnapshot *snapshot, Bucket *buckets, bool resume)
+{
+    memset(&checkpointState, 0, sizeof(checkpointState));
+    atomic_init(&checkpointStop, false);
+    checkpointState.active = true;
+    checkpointState.snapshot = snapshot;
+    snprintf(checkpointState.path, sizeof(checkpointState.path), "%.*s.ckpt", (int)(strlen(snapshot->path) - strlen(".snap")), snapshot->path);
+
+    // SA_RESETHAND: o segundo sinal já tem o comportamento padrão
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = checkpointHandler;
+    action.sa_flags = SA_RESETHAND;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGINT, &action, NULL);
+
+    if (!resume) return;
+    FILE *file = fopen(checkpointState.path, "rb");
+    if (file == NULL) {
+        printf("Checkpoint: nenhum em %s, começando do snapshot\n", checkpointState.path);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = (fileSize >= (long)sizeof(CheckpointHeader)) ? (char *)malloc((size_t)fileSize) : NULL;
+    bool valid = data != NULL && fread(data, 1, (size_t)fileSize, file) == (size_t)fileSize;
+    fclose(file);
+
+    const CheckpointHeader *header = (const CheckpointHeader *)data;
+    size_t doneBytes = valid ? bucketSnapshotAlign(header->tileCount) : 0;
+    valid = valid && memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0 &&
+            header->version == CHECKPOINT_VERSION && header->varCount == (uint32_t)snapshot->varCount &&
+            header->firstBucketHash == snapshot->hash && header->folded == (uint32_t)foldComplements &&
+            (size_t)fileSize == sizeof(CheckpointHeader) + doneBytes + bucketSnapshotOrderBytes(header->entries);
+    // Só a ordem logo depois da última do snapshot, e com as mesmas funções nas anteriores
+    valid = valid && header->order == (uint32_t)snapshot->loaded + 1 && header->order == (uint32_t)snapshot->orders + 1 &&
+            header->bucketsHash == checkpointBucketsHash(buckets, header->order);
+    if (!valid) {
+        fprintf(stderr, "Checkpoint %s não corresponde ao snapshot atual, ignorado\n", checkpointState.path);
+        free(data);
+        return;
+    }
+
+    checkpointState.order = (int)header->order;
+    checkpointState.workers = (int)header->workers;
+    checkpointState.tileCount = (int)header->tileCount;
+    checkpointState.data = data;
+    bucketSnapshotAttach(&checkpointState.partial, header->order, header->entries, data + sizeof(CheckpointHeader) + doneBytes);
+    int ready = 0;
+    for (int t = 0; t < checkpointState.tileCount; t++) ready += data[sizeof(CheckpointHeader) + t] != 0;
+    printf("Checkpoint: retomando a ordem %d (%d de %d blocos prontos, %llu funções)\n", checkpointState.order, ready,
+           checkpointState.tileCount, (unsigned long long)header->entries);
+}
+
+// workers para o pairSpaceInit da ordem: os de quem gravou, se a ordem vai ser retomada
+static inline int checkpointWorkers(int order, int workers)
+{
+    return (checkpointState.order == order) ? checkpointState.workers : workers;
+}
+
+/* Progresso da ordem sobre os espaços já cortados. Se a ordem vai ser retomada, marca os blocos prontos e põe as
+funções aceitas em into (e as chaves no conjunto de duplicatas) */
+static inline void checkpointBeginOrder(CheckpointProgress *progress, int order, const PairSpace *spaces, int spaceCount,
+                                        int workers, Bucket *into, SeenSet *uniqueCheck)
+{
+    memset(progress, 0, sizeof(*progress));
+    if (!checkpointState.active || !useTruthTable) return;
+    progress->order = order;
+    progress->workers = workers;
+    progress->tileBase = (int *)malloc(((size_t)spaceCount + 1) * sizeof(int));
+    if (progress->tileBase == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < spaceCount; i++) {
+        progress->tileBase[i] = progress->tileCount;
+        progress->tileCount += spaces[i].tileCount;
+    }
+    progress->done = (uint8_t *)calloc((size_t)progress->tileCount + 1, sizeof(uint8_t));
+    if (progress->done == NULL) exit(EXIT_FAILURE);
+
+    if (checkpointState.order != order) return;
+    if (checkpointState.tileCount == progress->tileCount) {
+        memcpy(progress->done, checkpointState.data + sizeof(CheckpointHeader), progress->tileCount);
+        Bucket *partial = &checkpointState.partial;
+        seenSetReserve(uniqueCheck, partial->size);
+        for (int k = 0; k < partial->size; k++) {
+            seenSetInsert(uniqueCheck, partial->tt[k]);
+            bucketAppend(into, partial->tt[k], NULL, (OpType)partial->op[k], partial->leftOrder[k], partial->left[k], partial->right[k]);
+        }
+        checkpointState.resumed = order;
+    } else {
+        fprintf(stderr, "Checkpoint %s com outro corte da ordem %d, ignorado\n", checkpointState.path, order);
+    }
+    free(checkpointState.data);
+    memset(&checkpointState.partial, 0, sizeof(Bucket));
+    checkpointState.data = NULL;
+    checkpointState.order = 0;
+}
+
+static inline bool checkpointTileDone(const CheckpointProgress *progress, int space, int tile)
+{
+    return progress->done != NULL && progress->done[progress->tileBase[space] + tile];
+}
+
+// Cada bloco é de uma thread só, então cada byte tem um escritor
+static inline void checkpointMarkTile(CheckpointProgress *progress, int space, int tile)
+{
+    if (progress->done != NULL) progress->done[progress->tileBase[space] + tile] = 1;
+}
+
+// Algum bloco ficou de fora? Se não, a ordem está completa e segue o caminho normal (snapshot e checkpointExitAfterOrder)
+static inline bool checkpointOrderPending(const CheckpointProgress *progress)
+{
+    for (int t = 0; t < progress->tileCount; t++) {
+        if (!progress->done[t]) return true;
+    }
+    return false;
+}
+
+static inline void checkpointEndOrder(CheckpointProgress *progress)
+{
+    free(progress->tileBase);
+    free(progress->done);
+    memset(progress, 0, sizeof(*progress));
+}
+
+/* Grava o progresso da ordem interrompida (partial = as funções aceitas, já juntadas num bucket) e encerra.
+Chamada depois da região paralela, com todas as threads paradas */
+static inline void checkpointSaveAndExit(CheckpointProgress *progress, const Bucket *buckets, const Bucket *partial)
+{
+    // Só vale com o snapshot logo antes desta ordem, e só se não for grande demais para recarregar
+    uint64_t bytes = sizeof(CheckpointHeader) + bucketSnapshotAlign((size_t)progress->tileCount) +
+                     bucketSnapshotOrderBytes((uint64_t)partial->size);
+    if (checkpointState.snapshot->orders != progress->order - 1 || bytes > CHECKPOINT_MAX_BYTES ||
+        !cacheDirFits(checkpointState.path, bytes)) {
+        printf("\nInterrompido na ordem %d: checkpoint de %llu MB não gravado, a ordem recomeça no --resume\n", progress->order,
+               (unsigned long long)(bytes >> 20));
+        fflush(stdout);
+        exit(EXIT_FAILURE);
+    }
+    char temporary[sizeof(checkpointState.path) + 32];
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", checkpointState.path, (int)getpid());
+    FILE *file = fopen(temporary, "wb");
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.varCount = (uint32_t)checkpointState.snapshot->varCount;
+    header.firstBucketHash = checkpointState.snapshot->hash;
+    header.bucketsHash = checkpointBucketsHash(buckets, progress->order);
+    header.folded = (uint32_t)foldComplements;
+    header.order = (uint32_t)progress->order;
+    header.workers = (uint32_t)progress->workers;
+    header.tileCount = (uint32_t)progress->tileCount;
+    header.entries = (uint64_t)partial->size;
+
+    size_t n = (size_t)partial->size;
+    bool ok = file != NULL && fwrite(&header, sizeof(header), 1, file) == 1 &&
+              bucketSnapshotWriteColumn(file, progress->done, (size_t)progress->tileCount) &&
+              bucketSnapshotWriteColumn(file, partial->tt, n * sizeof(TruthTable)) &&
+              bucketSnapshotWriteColumn(file, partial->left, n * sizeof(uint32_t)) &&
+              bucketSnapshotWriteColumn(file, partial->right, n * sizeof(uint32_t)) &&
+              bucketSnapshotWriteColumn(file, partial->leftOrder, n * sizeof(uint8_t)) &&
+              bucketSnapshotWriteColumn(file, partial->op, n * sizeof(uint8_t));
+    if (file != NULL && fclose(file) != 0) ok = false;
+    if (!ok || rename(temporary, checkpointState.path) != 0) {
+        fprintf(stderr, "Erro ao gravar o checkpoint %s\n", checkpointState.path);
+        unlink(temporary);
+        exit(EXIT_FAILURE);
+    }
+    int ready = 0;
+    for (int t = 0; t < progress->tileCount; t++) ready += progress->done[t];
+    printf("\nInterrompido na ordem %d: %d de %d blocos prontos, checkpoint em %s (continue com --resume)\n",
+           progress->order, ready, progress->tileCount, checkpointState.path);
+    fflush(stdout);
+    exit(EXIT_FAILURE);
+}
+
+// Sinal entre duas ordens: as prontas já estão no snapshot
+static inline void checkpointExitAfterOrder(int order)
+{
+    printf("\nInterrompido depois da ordem %d: ordens prontas em %s (continue com --resume)\n", order, checkpointState.snapshot->path);
+    fflush(stdout);
+    exit(EXIT_FAILURE);
+}
+
+// A ordem retomada terminou (e foi para o snapshot): o checkpoint dela não serve mais
+static inline void checkpointOrderPublished(int order)
+{
+    if (checkpointState.active && checkpointState.resumed == order && checkpointState.snapshot->orders >= order) {
+        unlink(checkpointState.path);
+        checkpointState.resumed = 0;
+    }
+}
+
+// Volta os sinais ao padrão e solta o que sobrou do checkpoint lido
+static inline void checkpointFinish(void)
+{
+    if (!checkpointState.active) return;
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    free(checkpointState.data);
+    memset(&checkpointState, 0, sizeof(checkpointState));
+}
+
+#endif
@@ -0,0 +1,282 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <omp.h>
+
+/* Conjunto de funções já vistas (substitui o st_table uniqueCheck).
+Com tabela verdade e poucas variáveis o espaço inteiro de funções é pequeno: 4 variáveis são 2^16 funções,
+então um bitmap de 8 KB endereçado pela própria tabela resolve, e a inserção vira um fetch-or atômico sem trava.
+Com 5 variáveis são 2^32 funções (512 MB de bitmap), só liga se compilar com -DDEDUP_BITMAP_5VARS.
+Fora disso (BDDs ou tabelas maiores) usa uma hash de endereçamento aberto sem trava: cada slot é uma palavra atômica,
+0 é vazio, e a inserção é um compare-and-swap no primeiro slot vazio da sequência de sondagem.
+Slots nunca voltam a ficar vazios, então duas threads inserindo a mesma chave veem a mesma sequência e só uma ganha.
+A tabela não cresce durante a combinação (nada de rehash com todo mundo parado): o createCombinedBucket chama
+seenSetReserve antes de cada ordem, com a previsão de crescimento, fora da região paralela.
+Se a previsão errar e a sondagem passar de SEEN_MAX_PROBE slots, a chave vai para uma tabela de transbordo com trava,
+que é absorvida na próxima reserva. */
+#define SEEN_BITMAP_MAX_VARS 4
+#define SEEN_INITIAL_SLOTS (1 << 16)
+#define SEEN_MAX_PROBE 64
+#define SEEN_BATCH_PREFETCH 32
+
+typedef enum {
+    SEEN_BITMAP,
+    SEEN_HASH
+} SeenSetKind;
+
+typedef struct {
+    SeenSetKind kind;
+    // Bitmap
+    _Atomic uint64_t *bits;
+    size_t words;
+    // Hash aberta (capacidade sempre potência de 2)
+    _Atomic uint64_t *slots;
+    size_t capacity;
+    _Atomic size_t count;
+    atomic_bool zeroSeen; //A chave 0 marca slot vazio, então fica de fora da tabela
+    // Transbordo, só com a trava
+    uint64_t *overflow;
+    size_t overflowCapacity;
+    _Atomic size_t overflowCount;
+    omp_lock_t overflowLock;
+} SeenSet;
+
+// Espalha a chave (ponteiros de BDD têm os bits baixos sempre iguais)
+static inline uint64_t seenSetHash(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+// Inserção sem atomicidade, para rehash e para o transbordo (que já está sob trava). Retorna true se a chave era nova
+static inline bool seenPlainInsert(uint64_t *slots, size_t capacity, uint64_t key)
+{
+    size_t mask = capacity - 1;
+    size_t slot = seenSetHash(key) & mask;
+    while (slots[slot] != 0) {
+        if (slots[slot] == key) return false;
+        slot = (slot + 1) & mask;
+    }
+    slots[slot] = key;
+    return true;
+}
+
+static inline bool seenPlainContains(const uint64_t *slots, size_t capacity, uint64_t key)
+{
+    if (capacity == 0) return false;
+    size_t mask = capacity - 1;
+    size_t slot = seenSetHash(key) & mask;
+    while (slots[slot] != 0) {
+        if (slots[slot] == key) return true;
+        slot = (slot + 1) & mask;
+    }
+    return false;
+}
+
+// Escolhe a representação conforme o backend e o número de variáveis
+static inline SeenSet *seenSetCreate(bool truthTable, int varCount)
+{
+    SeenSet *set = (SeenSet *)calloc(1, sizeof(SeenSet));
+    if (set == NULL) return NULL;
+
+    int bitmapMaxVars = SEEN_BITMAP_MAX_VARS;
+#ifdef DEDUP_BITMAP_5VARS
+    bitmapMaxVars = 5;
+#endif
+
+    if (truthTable && varCount <= bitmapMaxVars) {
+        set->kind = SEEN_BITMAP;
+        // 2^(2^n) bits, no mínimo uma palavra
+        uint64_t bitCount = (uint64_t)1 << (1 << varCount);
+        set->words = (bitCount + 63) / 64;
+        set->bits = (_Atomic uint64_t *)calloc(set->words, sizeof(uint64_t));
+        if (set->bits == NULL) {
+            free(set);
+            return NULL;
+        }
+        return set;
+    }
+
+    set->kind = SEEN_HASH;
+    set->capacity = SEEN_INITIAL_SLOTS;
+    set->slots = (_Atomic uint64_t *)calloc(set->capacity, sizeof(uint64_t));
+    if (set->slots == NULL) {
+        free(set);
+        return NULL;
+    }
+    atomic_init(&set->count, 0);
+    atomic_init(&set->overflowCount, 0);
+    atomic_init(&set->zeroSeen, false);
+    omp_init_lock(&set->overflowLock);
+    return set;
+}
+
+static inline bool seenSetOverflowInsert(SeenSet *set, uint64_t key)
+{
+    omp_set_lock(&set->overflowLock);
+    size_t used = atomic_load_explicit(&set->overflowCount, memory_order_relaxed);
+    if ((used + 1) * 2 > set->overflowCapacity) {
+        size_t newCapacity = set->overflowCapacity ? set->overflowCapacity * 2 : 1024;
+        uint64_t *newSlots = (uint64_t *)calloc(newCapacity, sizeof(uint64_t));
+        if (newSlots == NULL) {
+            fprintf(stderr, "Erro ao alocar o transbordo do conjunto de duplicatas\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t k = 0; k < set->overflowCapacity; k++) {
+            if (set->overflow[k]) seenPlainInsert(newSlots, newCapacity, set->overflow[k]);
+        }
+        free(set->overflow);
+        set->overflow = newSlots;
+        set->overflowCapacity = newCapacity;
+    }
+    bool inserted = seenPlainInsert(set->overflow, set->overflowCapacity, key);
+    if (inserted) atomic_fetch_add_explicit(&set->overflowCount, 1, memory_order_relaxed);
+    omp_unset_lock(&set->overflowLock);
+    return inserted;
+}
+
+// Insere a partir do slot inicial já calculado. Sem trava, a não ser no transbordo
+static inline bool seenSetInsertAt(SeenSet *set, uint64_t key, size_t slot)
+{
+    if (key == 0) return !atomic_exchange_explicit(&set->zeroSeen, true, memory_order_relaxed);
+
+    size_t mask = set->capacity - 1;
+    for (int probe = 0; probe < SEEN_MAX_PROBE; probe++) {
+        uint64_t current = atomic_load_explicit(&set->slots[slot], memory_order_relaxed);
+        if (current == key) return false;
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong_explicit(&set->slots[slot], &expected, key,
+                                                        memory_order_relaxed, memory_order_relaxed)) {
+                atomic_fetch_add_explicit(&set->count, 1, memory_order_relaxed);
+                return true;
+            }
+            // Outra thread ocupou o slot primeiro. Se foi com a mesma chave, ela já está no conjunto
+            if (expected == key) return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return seenSetOverflowInsert(set, key);
+}
+
+// Insere a chave. Retorna true se ela ainda não estava no conjunto. Pode ser chamada de várias threads.
+static inline bool seenSetInsert(SeenSet *set, uint64_t key)
+{
+    if (set->kind == SEEN_BITMAP) {
+        uint64_t mask = (uint64_t)1 << (key & 63);
+        uint64_t old = atomic_fetch_or_explicit(&set->bits[key >> 6], mask, memory_order_relaxed);
+        return (old & mask) == 0;
+    }
+    return seenSetInsertAt(set, key, seenSetHash(key) & (set->capacity - 1));
+}
+
+// Inserção em lote (flush do CombinationBuffer): calcula os slots e faz o prefetch antes, para as faltas de cache
+// de um lote se sobreporem em vez de virem uma de cada vez. isNew[b] recebe o resultado de cada chave.
+static inline void seenSetInsertBatch(SeenSet *set, const uint64_t *keys, int count, bool *isNew)
+{
+    if (set->kind == SEEN_BITMAP) {
+        for (int b = 0; b < count; b++) isNew[b] = seenSetInsert(set, keys[b]);
+        return;
+    }
+
+    size_t mask = set->capacity - 1;
+    size_t slots[SEEN_BATCH_PREFETCH];
+    for (int start = 0; start < count; start += SEEN_BATCH_PREFETCH) {
+        int end = (start + SEEN_BATCH_PREFETCH < count) ? start + SEEN_BATCH_PREFETCH : count;
+        for (int b = start; b < end; b++) {
+            slots[b - start] = seenSetHash(keys[b]) & mask;
+            __builtin_prefetch((const void *)&set->slots[slots[b - start]], 1);
+        }
+        for (int b = start; b < end; b++) {
+            isNew[b] = seenSetInsertAt(set, keys[b], slots[b - start]);
+        }
+    }
+}
+
+static inline bool seenSetContains(SeenSet *set, uint64_t key)
+{
+    if (set->kind == SEEN_BITMAP) {
+        uint64_t word = atomic_load_explicit(&set->bits[key >> 6], memory_order_relaxed);
+        return (word >> (key & 63)) & 1;
+    }
+    if (key == 0) return atomic_load_explicit(&set->zeroSeen, memory_order_relaxed);
+
+    size_t mask = set->capacity - 1;
+    size_t slot = seenSetHash(key) & mask;
+    for (int probe = 0; probe < SEEN_MAX_PROBE; probe++) {
+        uint64_t current = atomic_load_explicit(&set->slots[slot], memory_order_relaxed);
+        if (current == key) return true;
+        if (current == 0) return false;
+        slot = (slot + 1) & mask;
+    }
+    if (atomic_load_explicit(&set->overflowCount, memory_order_relaxed) == 0) return false;
+    omp_set_lock(&set->overflowLock);
+    bool found = seenPlainContains(set->overflow, set->overflowCapacity, key);
+    omp_unset_lock(&set->overflowLock);
+    return found;
+}
+
+/* Garante espaço para mais "expected" chaves com fator de carga de no máximo 1/2 e absorve o transbordo.
+NÃO pode ser chamada com outras threads inserindo: o createCombinedBucket chama antes de abrir a região paralela. */
+static inline void seenSetReserve(SeenSet *set, size_t expected)
+{
+    if (set->kind == SEEN_BITMAP) return;
+
+    size_t overflowCount = atomic_load_explicit(&set->overflowCount, memory_order_relaxed);
+    size_t need = (atomic_load_explicit(&set->count, memory_order_relaxed) + overflowCount + expected) * 2;
+    if (need <= set->capacity && overflowCount == 0) return;
+
+    size_t newCapacity = set->capacity;
+    while (newCapacity < need) newCapacity *= 2;
+
+    uint64_t *newSlots = (uint64_t *)calloc(newCapacity, sizeof(uint64_t));
+    if (newSlots == NULL) {
+        // Sem memória para crescer: segue com a tabela atual, o transbordo continua valendo
+        fprintf(stderr, "Aviso: não foi possível crescer o conjunto de duplicatas para %zu slots\n", newCapacity);
+        return;
+    }
+    for (size_t k = 0; k < set->capacity; k++) {
+        uint64_t key = atomic_load_explicit(&set->slots[k], memory_order_relaxed);
+        if (key) seenPlainInsert(newSlots, newCapacity, key);
+    }
+    for (size_t k = 0; k < set->overflowCapacity; k++) {
+        if (set->overflow[k]) seenPlainInsert(newSlots, newCapacity, set->overflow[k]);
+    }
+    free((void *)set->slots);
+    free(set->overflow);
+    set->slots = (_Atomic uint64_t *)newSlots;
+    set->capacity = newCapacity;
+    set->overflow = NULL;
+    set->overflowCapacity = 0;
+    atomic_store_explicit(&set->count, atomic_load_explicit(&set->count, memory_order_relaxed) + overflowCount, memory_order_relaxed);
+    atomic_store_explicit(&set->overflowCount, 0, memory_order_relaxed);
+}
+
+static inline const char *seenSetDescription(SeenSet *set)
+{
+    return set->kind == SEEN_BITMAP ? "bitmap atômico" : "hash aberta sem trava";
+}
+
+static inline void seenSetFree(SeenSet *set)
+{
+    if (set == NULL) return;
+    if (set->kind == SEEN_BITMAP) {
+        free((void *)set->bits);
+    } else {
+        free((void *)set->slots);
+        free(set->overflow);
+        omp_destroy_lock(&set->overflowLock);
+    }
+    free(set);
+}
+
+#endif
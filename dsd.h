@@ -0,0 +1,407 @@
+#ifndef DSD_H
+#define DSD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bdd.h"
+#include <omp.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "batch.h"
+#include "npncache.h"
+
+/* Decomposição de suporte disjunto antes da busca. Se f = g(A) * h(B) (ou g(A) + h(B)) com A e B disjuntos, o mínimo
+de literais de f é a soma dos mínimos de g e h: fixando as variáveis de B num ponto em que h = 1, os literais de A de
+qualquer fórmula de f já formam uma fórmula de g (e o mesmo para h). Então f é quebrada recursivamente em blocos
+primos, cada bloco é resolvido sozinho e as fórmulas são juntadas. Fórmulas read-once nem chegam na busca.
+O teste de corte é f == Ex_B(f) * Ex_A(f) (para o OR, o mesmo sobre !f). Para não testar todos os subconjuntos, x e
+y só podem ficar em lados diferentes se f_xy * f_x'y' == f_xy' * f_x'y, então as variáveis que falham nesse teste são
+juntadas em componentes e só as uniões de componentes são testadas. Tudo é feito com cofatores (sem Cudd_Support nem
+Cudd_bddExistAbstract), que os dois backends de BDD têm. Os blocos primos passam pela mesma enumeração do modo batch,
+em tabela verdade, então a decomposição só é usada se nenhum bloco primo passar de TT_MAX_VARS variáveis. */
+#define DSD_MAX_COMPONENTS 16
+#define DSD_EXPR_MAX NPN_EXPR_MAX
+
+typedef struct {
+    OpType op; //AND ou OR (filhos left e right) ou VAR (bloco primo)
+    DdNode *function; //Referenciada
+    uint64_t support; //Bit i = variável i do varMap
+    int left, right;
+} DsdNode;
+
+typedef struct {
+    DsdNode *nodes;
+    int size;
+    int capacity;
+    int primes; //Blocos primos com mais de uma variável
+    int largest; //Variáveis no maior bloco primo
+} DsdTree;
+
+static inline DdNode *dsdCofactor(DdManager *manager, DdNode *f, DdNode *var, bool value)
+{
+    DdNode *result = Cudd_Cofactor(manager, f, Cudd_NotCond(var, !value));
+    Cudd_Ref(result);
+    return result;
+}
+
+// Ex_mask(f), referenciada
+static inline DdNode *dsdExists(DdManager *manager, DdNode *f, uint64_t mask, const Function *varMap)
+{
+    Cudd_Ref(f);
+    for (; mask != 0; mask &= mask - 1) {
+        DdNode *var = varMap[__builtin_ctzll(mask)].bdd;
+        DdNode *pos = dsdCofactor(manager, f, var, true);
+        DdNode *neg = dsdCofactor(manager, f, var, false);
+        DdNode *result = Cudd_bddOr(manager, pos, neg);
+        Cudd_Ref(result);
+        Cudd_RecursiveDeref(manager, pos);
+        Cudd_RecursiveDeref(manager, neg);
+        Cudd_RecursiveDeref(manager, f);
+        f = result;
+    }
+    return f;
+}
+
+static inline uint64_t dsdSupport(DdManager *manager, DdNode *f, const Function *varMap, int varCount)
+{
+    uint64_t support = 0;
+    for (int i = 0; i < varCount; i++) {
+        DdNode *pos = dsdCofactor(manager, f, varMap[i].bdd, true);
+        DdNode *neg = dsdCofactor(manager, f, varMap[i].bdd, false);
+        if (pos != neg) support |= (uint64_t)1 << i;
+        Cudd_RecursiveDeref(manager, pos);
+        Cudd_RecursiveDeref(manager, neg);
+    }
+    return support;
+}
+
+// Condição necessária para x e y ficarem em lados diferentes de um corte AND
+static inline bool dsdSeparable(DdManager *manager, DdNode *f, DdNode *x, DdNode *y)
+{
+    DdNode *cof[2][2];
+    for (int a = 0; a < 2; a++) {
+        DdNode *fx = dsdCofactor(manager, f, x, a);
+        for (int b = 0; b < 2; b++) cof[a][b] = dsdCofactor(manager, fx, y, b);
+        Cudd_RecursiveDeref(manager, fx);
+    }
+    DdNode *same = Cudd_bddAnd(manager, cof[1][1], cof[0][0]);
+    Cudd_Ref(same);
+    DdNode *mixed = Cudd_bddAnd(manager, cof[1][0], cof[0][1]);
+    Cudd_Ref(mixed);
+    bool separable = (same == mixed);
+    Cudd_RecursiveDeref(manager, same);
+    Cudd_RecursiveDeref(manager, mixed);
+    for (int a = 0; a < 2; a++) {
+        for (int b = 0; b < 2; b++) Cudd_RecursiveDeref(manager, cof[a][b]);
+    }
+    return separable;
+}
+
+// f == Ex_B(f) * Ex_A(f). Devolve as duas partes (referenciadas) se o corte vale
+static inline bool dsdTryCut(DdManager *manager, DdNode *f, uint64_t a, uint64_t b, const Function *varMap, DdNode **g, DdNode **h)
+{
+    *g = dsdExists(manager, f, b, varMap);
+    *h = dsdExists(manager, f, a, varMap);
+    DdNode *product = Cudd_bddAnd(manager, *g, *h);
+    Cudd_Ref(product);
+    bool cut = (product == f);
+    Cudd_RecursiveDeref(manager, product);
+    if (!cut) {
+        Cudd_RecursiveDeref(manager, *g);
+        Cudd_RecursiveDeref(manager, *h);
+    }
+    return cut;
+}
+
+/* Menor bloco A (com a primeira variável do suporte) tal que f = g(A) * h(resto). Componentes em ordem crescente de
+quantidade, então o primeiro corte achado é o menor. false se f não tem corte AND */
+static inline bool dsdSplitAnd(DdManager *manager, DdNode *f, uint64_t support, const Function *varMap, DdNode **g, DdNode **h, uint64_t *block)
+{
+    int vars[64];
+    int n = 0;
+    for (uint64_t m = support; m != 0; m &= m - 1) vars[n++] = __builtin_ctzll(m);
+    if (n < 2) return false;
+
+    // Union-find das variáveis que não podem ser separadas
+    int parent[64];
+    for (int p = 0; p < n; p++) parent[p] = p;
+    for (int p = 0; p < n; p++) {
+        for (int q = p + 1; q < n; q++) {
+            int rp = p, rq = q;
+            while (parent[rp] != rp) rp = parent[rp];
+            while (parent[rq] != rq) rq = parent[rq];
+            if (rp == rq) continue;
+            if (dsdSeparable(manager, f, varMap[vars[p]].bdd, varMap[vars[q]].bdd)) continue;
+            // A raiz é sempre o menor índice, então o componente da primeira variável é o primeiro
+            if (rp < rq) parent[rq] = rp;
+            else parent[rp] = rq;
+        }
+    }
+    uint64_t components[64];
+    int componentCount = 0;
+    for (int p = 0; p < n; p++) {
+        int r = p;
+        while (parent[r] != r) r = parent[r];
+        if (r == p) components[componentCount++] = 0;
+    }
+    if (componentCount < 2 || componentCount > DSD_MAX_COMPONENTS) return false;
+    componentCount = 0;
+    for (int p = 0; p < n; p++) {
+        if (parent[p] != p) continue;
+        for (int q = 0; q < n; q++) {
+            int r = q;
+            while (parent[r] != r) r = parent[r];
+            if (r == p) components[componentCount] |= (uint64_t)1 << vars[q];
+        }
+        componentCount++;
+    }
+
+    // O componente 0 tem a primeira variável; os outros entram em subconjuntos de tamanho crescente
+    int rest = componentCount - 1;
+    for (int size = 0; size < rest; size++) {
+        for (uint32_t subset = 0; subset < (1u << rest); subset++) {
+            if (__builtin_popcount(subset) != size) continue;
+            uint64_t a = components[0];
+            for (int c = 0; c < rest; c++) {
+                if ((subset >> c) & 1) a |= components[c + 1];
+            }
+            if (dsdTryCut(manager, f, a, support & ~a, varMap, g, h)) {
+                *block = a;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static inline int dsdAddNode(DsdTree *tree, OpType op, DdNode *function, uint64_t support)
+{
+    if (tree->size == tree->capacity) {
+        tree->capacity = tree->capacity ? tree->capacity * 2 : 16;
+        tree->nodes = (DsdNode *)realloc(tree->nodes, tree->capacity * sizeof(DsdNode));
+        if (tree->nodes == NULL) {
+            fprintf(stderr, "Erro ao alocar a árvore de decomposição\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    DsdNode *node = &tree->nodes[tree->size];
+    node->op = op;
+    node->function = function;
+    node->support = support;
+    node->left = node->right = -1;
+    return tree->size++;
+}
+
+// Decompõe f (referência passa para a árvore). Devolve o índice do nó
+static inline int dsdBuild(DdManager *manager, DsdTree *tree, DdNode *f, uint64_t support, const Function *varMap)
+{
+    DdNode *g, *h;
+    uint64_t block;
+    OpType op;
+    if (dsdSplitAnd(manager, f, support, varMap, &g, &h, &block)) {
+        op = AND;
+    } else if (dsdSplitAnd(manager, Cudd_Not(f), support, varMap, &g, &h, &block)) {
+        // !f = g * h, então f = !g + !h
+        op = OR;
+        g = Cudd_Not(g);
+        h = Cudd_Not(h);
+    } else {
+        int vars = __builtin_popcountll(support);
+        if (vars > 1) tree->primes++;
+        if (vars > tree->largest) tree->largest = vars;
+        return dsdAddNode(tree, VAR, f, support);
+    }
+
+    int node = dsdAddNode(tree, op, f, support);
+    int left = dsdBuild(manager, tree, g, block, varMap);
+    int right = dsdBuild(manager, tree, h, support & ~block, varMap);
+    tree->nodes[node].left = left;
+    tree->nodes[node].right = right;
+    return node;
+}
+
+static inline void dsdTreeFree(DdManager *manager, DsdTree *tree)
+{
+    for (int i = 0; i < tree->size; i++) Cudd_RecursiveDeref(manager, tree->nodes[i].function);
+    free(tree->nodes);
+    tree->nodes = NULL;
+    tree->size = tree->capacity = 0;
+}
+
+// Primeira referência do bucket (nas duas polaridades, com a dobra) com a tabela tt. -1 se não tem
+static inline int64_t dsdFindInBucket(Bucket *bucket, TruthTable tt)
+{
+    for (int k = 0; k < bucket->size; k++) {
+        for (int pol = 0; pol < (foldComplements ? 2 : 1); pol++) {
+            uint32_t ref = (uint32_t)k | (pol ? BUCKET_NEGATED : 0);
+            if (bucketRefTt(bucket, ref) == tt) return ref;
+        }
+    }
+    return -1;
+}
+
+/* Bloco primo pela enumeração do modo batch: bucket 1 com todos os literais do bloco e combinações sem objetivo até
+aparecer a tabela do bloco. Devolve os literais (0 se não apareceu até maxOrder) e a expressão em out */
+static inline int dsdSearchBlock(DdManager *manager, DdNode *f, uint64_t support, const Function *varMap, int maxOrder, NpnCache *cache, char *out, size_t outSize)
+{
+    int index[TT_MAX_VARS];
+    char names[TT_MAX_VARS + 1];
+    int k = 0;
+    for (uint64_t m = support; m != 0; m &= m - 1) {
+        index[k] = __builtin_ctzll(m);
+        names[k] = varMap[index[k]].varName;
+        k++;
+    }
+    names[k] = '\0';
+
+    int inputs[64] = {0};
+    TruthTable tt = 0;
+    for (int m = 0; m < (1 << k); m++) {
+        for (int p = 0; p < k; p++) inputs[index[p]] = (m >> p) & 1;
+        if (Cudd_Eval(manager, f, inputs) == Cudd_ReadOne(manager)) tt |= (TruthTable)1 << m;
+    }
+
+    if (cache != NULL) {
+        int literals = npnCacheLookup(cache, tt, k, names, out, outSize);
+        if (literals > 0) return literals;
+    }
+
+    useTruthTable = true;
+    fullTt = ttFullMask(k);
+    objectiveTt = 0; // Constante, nunca é gerada pelas combinações
+    SeenSet *uniqueCheck = seenSetCreate(true, k);
+    if (uniqueCheck == NULL) {
+        fprintf(stderr, "Erro ao criar o conjunto de duplicatas do bloco %s\n", names);
+        exit(EXIT_FAILURE);
+    }
+    int numBuckets = 0;
+    Bucket *buckets = NULL;
+    while (numBuckets < maxOrder) buckets = addBucket(buckets, &numBuckets);
+    literalBucketInit(&buckets[0], names, k, uniqueCheck);
+
+    int order = 1;
+    int64_t ref = dsdFindInBucket(&buckets[0], tt);
+    while (ref < 0 && order < maxOrder) {
+        order++;
+        createCombinedBucket(manager, buckets, numBuckets, order, NULL, uniqueCheck, 'c');
+        ref = dsdFindInBucket(&buckets[order - 1], tt);
+    }
+
+    int literals = 0;
+    if (ref >= 0) {
+        bucketEchoCapture();
+        printBucketFunction(buckets, order, (uint32_t)ref);
+        const char *expression = bucketEchoEnd();
+        if (expression != NULL && strlen(expression) < outSize) {
+            strcpy(out, expression);
+            literals = order;
+            if (cache != NULL) npnCacheRecord(cache, tt, k, names, expression);
+        }
+    }
+    freeAllBuckets(manager, buckets, numBuckets);
+    seenSetFree(uniqueCheck);
+    return literals;
+}
+
+// Operador de cima de uma expressão já escrita: + fora de parênteses é OR (o * tem precedência), senão * é AND,
+// e sem nenhum dos dois é literal ou negação (VAR)
+static inline OpType dsdTopOp(const char *expression)
+{
+    int depth = 0;
+    OpType op = VAR;
+    for (const char *c = expression; *c != '\0'; c++) {
+        if (*c == '(') depth++;
+        else if (*c == ')') depth--;
+        else if (depth == 0 && *c == '+') return OR;
+        else if (depth == 0 && *c == '*') op = AND;
+    }
+    return op;
+}
+
+// Expressão do nó em out. slack = literais que sobram no orçamento além de um por variável
+static inline int dsdSolveNode(DdManager *manager, DsdTree *tree, int idx, const Function *varMap, int slack, NpnCache *cache, char *out, size_t outSize)
+{
+    DsdNode *node = &tree->nodes[idx];
+    int vars = __builtin_popcountll(node->support);
+    if (node->op == VAR) {
+        if (vars == 1) {
+            int i = __builtin_ctzll(node->support);
+            bool negated = (node->function == Cudd_Not(varMap[i].bdd));
+            return (snprintf(out, outSize, "%s%c", negated ? "!" : "", varMap[i].varName) < (int)outSize) ? 1 : 0;
+        }
+        return dsdSearchBlock(manager, node->function, node->support, varMap, vars + slack, cache, out, outSize);
+    }
+
+    char part[2][DSD_EXPR_MAX];
+    int child[2] = {node->left, node->right};
+    int literals = 0;
+    for (int c = 0; c < 2; c++) {
+        int solved = dsdSolveNode(manager, tree, child[c], varMap, slack, cache, part[c], sizeof(part[c]));
+        if (solved == 0) return 0;
+        literals += solved;
+    }
+
+    // Parênteses como no printFunction: só em volta de filho composto com operador diferente. O operador de cima de um
+    // bloco primo vem da expressão que a busca (ou o cache NPN) devolveu
+    bool par[2];
+    for (int c = 0; c < 2; c++) {
+        OpType top = dsdTopOp(part[c]);
+        par[c] = top != VAR && top != node->op;
+    }
+    int written = snprintf(out, outSize, "%s%s%s%c%s%s%s", par[0] ? "(" : "", part[0], par[0] ? ")" : "",
+                           (node->op == AND) ? '*' : '+', par[1] ? "(" : "", part[1], par[1] ? ")" : "");
+    return (written < (int)outSize) ? literals : 0;
+}
+
+/* Tenta resolver o objetivo pela decomposição. false se ele não decompõe (ou tem bloco primo grande demais), e aí a
+busca normal segue sem nada alterado */
+static inline bool dsdReport(DdManager *manager, DdNode *objectiveExp, const Function *varMap, int varCount, int literalCount,
+                             NpnCache *cache)
+{
+    if (varCount > 64) return false;
+    double start_time = omp_get_wtime();
+    uint64_t support = dsdSupport(manager, objectiveExp, varMap, varCount);
+
+    DsdTree tree = {NULL, 0, 0, 0, 0};
+    Cudd_Ref(objectiveExp);
+    int root = dsdBuild(manager, &tree, objectiveExp, support, varMap);
+    if (tree.nodes[root].op == VAR) {
+        dsdTreeFree(manager, &tree);
+        return false;
+    }
+    printf("Decomposição disjunta: %d blocos, %d primos (maior com %d variáveis)\n", (tree.size + 1) / 2, tree.primes, tree.largest);
+    if (tree.largest > TT_MAX_VARS) {
+        printf("Bloco primo acima de %d variáveis, seguindo com a busca normal\n", TT_MAX_VARS);
+        dsdTreeFree(manager, &tree);
+        return false;
+    }
+
+    // A busca dos blocos troca o backend e a dobra; o objetivo inteiro volta a valer se algo falhar
+    bool savedUseTruthTable = useTruthTable;
+    TruthTable savedFullTt = fullTt, savedObjectiveTt = objectiveTt;
+    bool savedFold = foldComplements;
+
+    char expression[DSD_EXPR_MAX];
+    int slack = literalCount - __builtin_popcountll(support);
+    int literals = dsdSolveNode(manager, &tree, root, varMap, slack, cache, expression, sizeof(expression));
+
+    useTruthTable = savedUseTruthTable;
+    fullTt = savedFullTt;
+    objectiveTt = savedObjectiveTt;
+    foldComplements = savedFold;
+    dsdTreeFree(manager, &tree);
+    if (literals == 0) return false;
+
+    double end_time = omp_get_wtime();
+    printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", literals);
+    printf("RESULTADO_LITERAIS: %d\n", literals);
+    printf("RESULTADO_EXPRESSAO: %s\n", expression);
+    printf("BENCHMARK_TIME: %.6f\n", end_time - start_time);
+    // A composição dos blocos não passou pela busca exaustiva do objetivo inteiro: só os blocos vão para o cache NPN
+    return true;
+}
+
+#endif
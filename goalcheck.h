@@ -0,0 +1,284 @@
+#ifndef GOALCHECK_H
+#define GOALCHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bdd.h"
+#include "bucket.h"
+#include "checkpoint.h"
+
+/* Goal check do modo e: testa se o objetivo f sai na ordem n sem montar o bucket n.
+Uma raiz AND precisa de dois filhos que contenham f (g >= f) e cuja interseção seja exatamente f,
+ou seja, os "excessos" g & !f dos dois filhos têm que ser disjuntos. A raiz OR é o dual: filhos contidos em f
+(g <= f) cujas "faltas" f & !g sejam disjuntas. Cada bucket guarda uma vez só os candidatos dos dois lados com o resíduo
+já calculado, e o teste de um par vira um AND de palavras (ou um Cudd_bddLeq, que não cria nó nenhum).
+Com até 4 variáveis o resíduo cabe em 16 bits e dá pra indexar por subconjunto: subsetWitness[m] guarda um candidato
+cujo resíduo está contido em m, então o parceiro de f1 é uma consulta só em subsetWitness[!resíduo(f1)].
+Com a dobra de complementos cada entrada do bucket entra com as duas polaridades, e o índice do candidato leva
+BUCKET_NEGATED quando é o complemento do representante.
+No BDD, com assinaturas (signature.h), o candidato e o par só chegam ao Cudd_bddLeq se a assinatura não os refutar.
+Sem o índice por subconjunto os candidatos ficam ordenados pela máscara de suporte da função (bucketSupportBuild) e
+só os pares de partições cujos suportes juntos cobrem todas as variáveis do objetivo são testados. */
+#define GOAL_SUBSET_MAX_BITS 16
+
+typedef struct {
+    uint64_t mask;
+    int pos;
+} GoalSupportKey;
+
+static inline int goalSupportCompare(const void *a, const void *b)
+{
+    const GoalSupportKey *x = (const GoalSupportKey *)a, *y = (const GoalSupportKey *)b;
+    if (x->mask != y->mask) return (x->mask < y->mask) ? -1 : 1;
+    return x->pos - y->pos;
+}
+
+// Coluna reordenada pelas chaves (libera a antiga)
+static inline void *goalPermute(void *column, size_t elementSize, const GoalSupportKey *keys, int count)
+{
+    if (column == NULL) return NULL;
+    char *sorted = (char *)malloc((size_t)count * elementSize + 1);
+    if (sorted == NULL) {
+        fprintf(stderr, "Erro ao alocar memória para o goal check\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < count; c++) memcpy(sorted + (size_t)c * elementSize, (char *)column + (size_t)keys[c].pos * elementSize, elementSize);
+    free(column);
+    return sorted;
+}
+
+// Agrupa os candidatos por máscara de suporte. Sem coluna de suporte fica sem partições (partCount = 0)
+static inline void goalCandidatesPartition(const Bucket *bucket, GoalCandidates *side)
+{
+    if (bucket->support == NULL || side->count == 0) return;
+    GoalSupportKey *keys = (GoalSupportKey *)malloc((size_t)side->count * sizeof(GoalSupportKey));
+    if (keys == NULL) {
+        fprintf(stderr, "Erro ao alocar memória para o goal check\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int c = 0; c < side->count; c++) {
+        keys[c].mask = bucket->support[BUCKET_INDEX(side->index[c])];
+        keys[c].pos = c;
+    }
+    qsort(keys, side->count, sizeof(GoalSupportKey), goalSupportCompare);
+    side->index = (uint32_t *)goalPermute(side->index, sizeof(uint32_t), keys, side->count);
+    side->residueTt = (TruthTable *)goalPermute(side->residueTt, sizeof(TruthTable), keys, side->count);
+    side->residueBdd = (DdNode **)goalPermute(side->residueBdd, sizeof(DdNode *), keys, side->count);
+    side->residueSig = (Signature *)goalPermute(side->residueSig, sizeof(Signature), keys, side->count);
+
+    int parts = 1;
+    for (int c = 1; c < side->count; c++) parts += keys[c].mask != keys[c - 1].mask;
+    side->partMask = (uint64_t *)malloc((size_t)parts * sizeof(uint64_t));
+    side->partStart = (int *)malloc(((size_t)parts + 1) * sizeof(int));
+    if (side->partMask == NULL || side->partStart == NULL) {
+        fprintf(stderr, "Erro ao alocar memória para o goal check\n");
+        exit(EXIT_FAILURE);
+    }
+    side->partCount = 0;
+    for (int c = 0; c < side->count; c++) {
+        if (c > 0 && keys[c].mask == keys[c - 1].mask) continue;
+        side->partMask[side->partCount] = keys[c].mask;
+        side->partStart[side->partCount++] = c;
+    }
+    side->partStart[side->partCount] = side->count;
+    free(keys);
+}
+
+// Resíduo de g em relação ao objetivo: excesso (lado AND) ou falta (lado OR)
+static inline TruthTable goalResidueTt(TruthTable g, bool andSide)
+{
+    return andSide ? (g & ~objectiveTt) : (objectiveTt & ~g & fullTt);
+}
+
+static inline void goalCandidatesBuild(DdManager *manager, Bucket *bucket, DdNode *objectiveExp, GoalCandidates *side, bool andSide)
+{
+    int polarities = foldComplements ? 2 : 1;
+    size_t capacity = (size_t)bucket->size * polarities + 1;
+    side->index = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+    if (useTruthTable) {
+        side->residueTt = (TruthTable *)malloc(capacity * sizeof(TruthTable));
+    } else {
+        side->residueBdd = (DdNode **)malloc(capacity * sizeof(DdNode *));
+        side->residueSig = bucket->sig ? (Signature *)malloc(capacity * sizeof(Signature)) : NULL;
+    }
+    if (side->index == NULL || (side->residueTt == NULL && side->residueBdd == NULL)) {
+        fprintf(stderr, "Erro ao alocar memória para o goal check\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int k = 0; k < bucket->size; k++) {
+        for (int pol = 0; pol < polarities; pol++) {
+            if (useTruthTable) {
+                TruthTable g = pol ? ~bucket->tt[k] & fullTt : bucket->tt[k];
+                if (andSide ? !ttLeq(objectiveTt, g) : !ttLeq(g, objectiveTt)) continue;
+                side->residueTt[side->count] = goalResidueTt(g, andSide);
+            } else {
+                DdNode *g = Cudd_NotCond(bucket->bdd[k], pol);
+                Signature sg;
+                const Signature *gSig = bucketRefSig(bucket, (uint32_t)k | (pol ? BUCKET_NEGATED : 0), &sg);
+                if (andSide ? !sigMayLeq(&sigObjective, false, gSig, false) : !sigMayLeq(gSig, false, &sigObjective, false)) continue;
+                if (andSide ? !Cudd_bddLeq(manager, objectiveExp, g) : !Cudd_bddLeq(manager, g, objectiveExp)) continue;
+                if (side->residueSig) side->residueSig[side->count] = sigResidue(gSig, andSide);
+                DdNode *residue = andSide ? Cudd_bddAnd(manager, g, Cudd_Not(objectiveExp))
+                                          : Cudd_bddAnd(manager, objectiveExp, Cudd_Not(g));
+                Cudd_Ref(residue);
+                side->residueBdd[side->count] = residue;
+            }
+            side->index[side->count] = (uint32_t)k | (pol ? BUCKET_NEGATED : 0);
+            side->count++;
+        }
+    }
+
+    // Índice por subconjunto: fecha subsetWitness para cima, bit a bit (2^16 * 16 passos no pior caso)
+    uint64_t domain = fullTt + 1;
+    if (!(useTruthTable && side->count > 0 && fullTt <= ((TruthTable)1 << GOAL_SUBSET_MAX_BITS) - 1)) {
+        // Uma consulta por candidato já não depende do tamanho do outro lado: só a varredura ganha com as partições
+        goalCandidatesPartition(bucket, side);
+    } else {
+        side->subsetWitness = (int32_t *)malloc(domain * sizeof(int32_t));
+        if (side->subsetWitness == NULL) {
+            fprintf(stderr, "Erro ao alocar memória para o goal check\n");
+            exit(EXIT_FAILURE);
+        }
+        for (uint64_t m = 0; m < domain; m++) side->subsetWitness[m] = -1;
+        for (int k = 0; k < side->count; k++) {
+            if (side->subsetWitness[side->residueTt[k]] < 0) side->subsetWitness[side->residueTt[k]] = k;
+        }
+        for (uint64_t bit = 1; bit < domain; bit <<= 1) {
+            for (uint64_t m = 0; m < domain; m++) {
+                if ((m & bit) && side->subsetWitness[m] < 0) side->subsetWitness[m] = side->subsetWitness[m ^ bit];
+            }
+        }
+    }
+}
+
+// Os candidatos de um bucket são montados na primeira consulta e reaproveitados nas ordens seguintes
+static inline void goalIndexBuild(DdManager *manager, Bucket *bucket, DdNode *objectiveExp)
+{
+    if (bucket->goal.built) return;
+    goalCandidatesBuild(manager, bucket, objectiveExp, &bucket->goal.andSide, true);
+    goalCandidatesBuild(manager, bucket, objectiveExp, &bucket->goal.orSide, false);
+    bucket->goal.built = true;
+}
+
+static inline void goalCandidatesFree(DdManager *manager, GoalCandidates *side)
+{
+    if (side->residueBdd) {
+        for (int k = 0; k < side->count; k++) Cudd_RecursiveDeref(manager, side->residueBdd[k]);
+    }
+    free(side->index);
+    free(side->residueTt);
+    free(side->residueBdd);
+    free(side->residueSig);
+    free(side->subsetWitness);
+    free(side->partMask);
+    free(side->partStart);
+}
+
+static inline void goalIndexFree(DdManager *manager, GoalIndex *goal)
+{
+    if (!goal->built) return;
+    goalCandidatesFree(manager, &goal->andSide);
+    goalCandidatesFree(manager, &goal->orSide);
+    memset(goal, 0, sizeof(GoalIndex));
+}
+
+// Procura em s2[startL, endL) um parceiro para o candidato k de s1. Retorna o índice em s2 ou -1
+static inline int goalFindPartner(DdManager *manager, GoalCandidates *s1, int k, GoalCandidates *s2, int startL, int endL)
+{
+    if (s2->subsetWitness) {
+        // Sem restrição de ordem: o par (k, l) com l < k também é um par válido de buckets iguais
+        return s2->subsetWitness[~s1->residueTt[k] & fullTt];
+    }
+    for (int l = startL; l < endL; l++) {
+        if (!useTruthTable && s1->residueSig && s2->residueSig && !sigMayLeq(&s1->residueSig[k], false, &s2->residueSig[l], true)) continue;
+        bool disjoint = useTruthTable ? (s1->residueTt[k] & s2->residueTt[l]) == 0
+                                      : Cudd_bddLeq(manager, s1->residueBdd[k], Cudd_Not(s2->residueBdd[l]));
+        if (disjoint) return l;
+    }
+    return -1;
+}
+
+// Procura um par em s1[kBegin, kEnd) x s2[lBegin, lEnd); triangle = mesmo trecho dos dois lados, só l >= k
+static inline bool goalScan(DdManager *manager, GoalCandidates *s1, int kBegin, int kEnd, GoalCandidates *s2, int lBegin, int lEnd,
+                            bool triangle, int *outK, int *outL)
+{
+    for (int k = kBegin; k < kEnd; k++) {
+        int l = goalFindPartner(manager, s1, k, s2, triangle ? k : lBegin, lEnd);
+        if (l < 0) continue;
+        *outK = k;
+        *outL = l;
+        return true;
+    }
+    return false;
+}
+
+static inline unsigned long long goalPartPairs(int n1, int n2, bool triangle)
+{
+    return triangle ? (unsigned long long)n1 * (n1 + 1) / 2 : (unsigned long long)n1 * n2;
+}
+
+// Verifica se o objetivo aparece na ordem targetOrder combinando os buckets já montados. Imprime o resultado se achar
+static inline bool goalCheckOrder(DdManager *manager, Bucket *buckets, int targetOrder, DdNode *objectiveExp)
+{
+    bucketSupportEnsure(buckets, targetOrder - 1);
+    uint64_t fullSupport = bucketSupportFull(buckets);
+    unsigned long long pairs = 0, skipped = 0;
+    bool partitioned = false;
+
+    for (int i = 0; i < targetOrder - 1; i++) {
+        int j = targetOrder - (i + 1) - 1;
+        if (j < i) break; // Evita repetições desnecessárias
+        if (buckets[i].size == 0 || buckets[j].size == 0) continue;
+        // Sinal de parada (checkpoint.h): a ordem anterior já está no snapshot e o goal check recomeça no --resume
+        if (checkpointStopRequested()) checkpointExitAfterOrder(targetOrder - 1);
+
+        goalIndexBuild(manager, &buckets[i], objectiveExp);
+        goalIndexBuild(manager, &buckets[j], objectiveExp);
+
+        for (int op = 0; op < 2; op++) {
+            GoalCandidates *s1 = (op == 0) ? &buckets[i].goal.andSide : &buckets[i].goal.orSide;
+            GoalCandidates *s2 = (op == 0) ? &buckets[j].goal.andSide : &buckets[j].goal.orSide;
+            int k = -1, l = -1;
+            bool hit = false;
+
+            if (s1->partCount == 0 || s2->partCount == 0) {
+                hit = goalScan(manager, s1, 0, s1->count, s2, 0, s2->count, i == j, &k, &l);
+            } else {
+                // Só os pares de partições que juntas cobrem o suporte do objetivo
+                partitioned = true;
+                for (int p1 = 0; p1 < s1->partCount && !hit; p1++) {
+                    for (int p2 = (i == j) ? p1 : 0; p2 < s2->partCount && !hit; p2++) {
+                        bool triangle = (i == j) && p1 == p2;
+                        unsigned long long n = goalPartPairs(s1->partStart[p1 + 1] - s1->partStart[p1],
+                                                             s2->partStart[p2 + 1] - s2->partStart[p2], triangle);
+                        pairs += n;
+                        if ((s1->partMask[p1] | s2->partMask[p2]) != fullSupport) {
+                            skipped += n;
+                            continue;
+                        }
+                        if (checkpointStopRequested()) checkpointExitAfterOrder(targetOrder - 1);
+                        hit = goalScan(manager, s1, s1->partStart[p1], s1->partStart[p1 + 1],
+                                       s2, s2->partStart[p2], s2->partStart[p2 + 1], triangle, &k, &l);
+                    }
+                }
+            }
+            if (!hit) continue;
+
+            printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+            printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+
+            printf("RESULTADO_EXPRESSAO: ");
+            printBucketCombination(buckets, (op == 0) ? AND : OR, i + 1, s1->index[k], j + 1, s2->index[l]);
+            printf("\n");
+            return true;
+        }
+    }
+    if (partitioned) printf("Suporte (ordem %d): %llu de %llu pares do goal check descartados\n", targetOrder, skipped, pairs);
+    return false;
+}
+
+#endif
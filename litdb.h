@@ -0,0 +1,181 @@
+#ifndef LITDB_H
+#define LITDB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+#include "bucket.h"
+
+/* Tabela pré-computada com o mínimo de literais de todas as 65536 funções de 4 variáveis.
+Gerada uma vez com "./teste --gen-db litdb4.bin" (ou make litdb4.bin), que roda a enumeração por buckets até saturar.
+Cada entrada é indexada pela própria tabela verdade e guarda a ordem em que a função apareceu e um testemunho:
+para AND/OR os índices (tabelas verdade) dos dois pais, para literais o índice da variável.
+Assim a expressão é remontada seguindo os índices, sem guardar string nenhuma (6 bytes por função, ~384 KB). */
+#define LITDB_MAGIC "TCCLITDB"
+#define LITDB_VERSION 1
+#define LITDB_VARS 4
+#define LITDB_ENTRIES (1 << (1 << LITDB_VARS))
+#define LITDB_DEFAULT_PATH "litdb4.bin"
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t varCount;
+    uint32_t entries;
+    uint32_t reserved;
+} LitDbHeader;
+
+typedef struct {
+    uint8_t literals; //0 para constantes
+    uint8_t op; //OpType
+    uint16_t left; //AND/OR: tabela do pai esquerdo. VAR/NOT: índice da variável
+    uint16_t right;
+} __attribute__((packed)) LitDbEntry;
+
+typedef struct {
+    void *map;
+    size_t mapSize;
+    const LitDbEntry *entries;
+} LitDb;
+
+static inline int litDbWrite(const char *path, const LitDbEntry *entries)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror("Erro ao criar a tabela");
+        return -1;
+    }
+    LitDbHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LITDB_MAGIC, sizeof(header.magic));
+    header.version = LITDB_VERSION;
+    header.varCount = LITDB_VARS;
+    header.entries = LITDB_ENTRIES;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(entries, sizeof(LitDbEntry), LITDB_ENTRIES, f) == LITDB_ENTRIES;
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Erro ao escrever a tabela em %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Mapeia a tabela somente leitura. Retorna false (com mensagem) se o arquivo não existir ou não bater com o formato
+static inline bool litDbOpen(LitDb *db, const char *path)
+{
+    memset(db, 0, sizeof(*db));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Erro ao abrir a tabela %s (gere com: make %s)\n", path, LITDB_DEFAULT_PATH);
+        return false;
+    }
+    struct stat st;
+    size_t expected = sizeof(LitDbHeader) + (size_t)LITDB_ENTRIES * sizeof(LitDbEntry);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != expected) {
+        fprintf(stderr, "Tabela %s com tamanho inválido\n", path);
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, expected, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Erro no mmap da tabela");
+        return false;
+    }
+    const LitDbHeader *header = (const LitDbHeader *)map;
+    if (memcmp(header->magic, LITDB_MAGIC, sizeof(header->magic)) != 0 || header->version != LITDB_VERSION ||
+        header->varCount != LITDB_VARS || header->entries != LITDB_ENTRIES) {
+        fprintf(stderr, "Tabela %s com formato ou versão incompatível\n", path);
+        munmap(map, expected);
+        return false;
+    }
+    db->map = map;
+    db->mapSize = expected;
+    db->entries = (const LitDbEntry *)((const char *)map + sizeof(LitDbHeader));
+    return true;
+}
+
+static inline void litDbClose(LitDb *db)
+{
+    if (db->map) munmap(db->map, db->mapSize);
+    db->map = NULL;
+}
+
+// Leva uma tabela de varCount <= 4 variáveis para o espaço de 4 variáveis da tabela (replica nas variáveis que sobram)
+static inline uint16_t litDbIndex(TruthTable tt, int varCount)
+{
+    for (int v = varCount; v < LITDB_VARS; v++) {
+        tt |= tt << (1 << v);
+    }
+    return (uint16_t)(tt & ttFullMask(LITDB_VARS));
+}
+
+// Remonta a árvore de Function do testemunho, com os nomes de variáveis do varMap do parse.
+// Os nós são alocados aqui e liberados com litDbFreeFunction.
+static inline Function *litDbBuildFunction(const LitDb *db, uint16_t index, const Function *varMap)
+{
+    const LitDbEntry *e = &db->entries[index];
+    Function *node = (Function *)calloc(1, sizeof(Function));
+    node->tt = index;
+    node->operador = (OpType)e->op;
+    if (e->op == VAR) {
+        node->varName = varMap[e->left].varName;
+    } else if (e->op == NOT) {
+        Function *var = (Function *)calloc(1, sizeof(Function));
+        var->operador = VAR;
+        var->varName = varMap[e->left].varName;
+        node->left = var;
+    } else {
+        node->left = litDbBuildFunction(db, e->left, varMap);
+        node->right = litDbBuildFunction(db, e->right, varMap);
+    }
+    return node;
+}
+
+static inline void litDbFreeFunction(Function *node)
+{
+    if (node == NULL) return;
+    litDbFreeFunction(node->left);
+    litDbFreeFunction(node->right);
+    free(node);
+}
+
+// Modo d: responde direto pela tabela, sem montar bucket nenhum
+static inline int litDbQuery(const char *path, TruthTable objective, int varCount, const Function *varMap)
+{
+    if (varCount > LITDB_VARS) {
+        fprintf(stderr, "Erro: a tabela só cobre funções de até %d variáveis (objetivo tem %d).\n", LITDB_VARS, varCount);
+        return EXIT_FAILURE;
+    }
+    double start_time = omp_get_wtime();
+
+    LitDb db;
+    if (!litDbOpen(&db, path)) return EXIT_FAILURE;
+
+    uint16_t index = litDbIndex(objective, varCount);
+    int literals = db.entries[index].literals;
+    Function *root = litDbBuildFunction(&db, index, varMap);
+
+    double end_time = omp_get_wtime();
+
+    printf("RESULTADO_LITERAIS: %d\n", literals);
+    printf("RESULTADO_EXPRESSAO: ");
+    printFunction(root);
+    printf("\n");
+    printf("BENCHMARK_TIME: %.6f\n", end_time - start_time);
+
+    litDbFreeFunction(root);
+    litDbClose(&db);
+    return EXIT_SUCCESS;
+}
+
+#endif
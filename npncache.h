@@ -0,0 +1,324 @@
+#ifndef NPNCACHE_H
+#define NPNCACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <st.h>
+#include <omp.h>
+#include "truthtable.h"
+#include "cachedir.h"
+
+/* Cache de resultados por classe NPN. O mínimo de literais não muda se as variáveis forem permutadas (P), se alguma
+entrada for negada (N, troca x por !x nos literais) ou se a saída for negada (N, a fórmula dual com AND/OR trocados).
+Então o objetivo é levado para a forma canônica da classe (a menor tabela verdade entre todas as n! * 2^n * 2
+transformações, com até TT_MAX_VARS variáveis são 92160 tabelas de 64 bits) e o resultado é guardado uma vez por classe,
+com a expressão escrita nas variáveis canônicas a, b, c... Num acerto a expressão volta para as variáveis do objetivo
+trocando cada literal e, se a saída foi negada, os operadores.
+O arquivo (NPN_CACHE_DEFAULT_PATH, dentro da pasta do cachedir.h) é texto, uma classe por linha:
+"<variáveis> <tabela em hex> <literais> <expressão> <executável> <compilação>". Só entram resultados provados mínimos
+pela busca exaustiva (a incumbente dos limites e a composição da decomposição disjunta ficam de fora), e só são lidas as
+linhas do mesmo executável e da mesma compilação: um erro de um motor não vira resposta dos outros nem da próxima versão.
+É lido inteiro no início e cada resultado novo é acrescentado no fim. Só liga com a pasta do cache definida
+(TCC_CACHE_DIR); compilar com -DNO_NPN_CACHE desliga de vez. */
+#define NPN_CACHE_DEFAULT_PATH "npncache.txt"
+#define NPN_EXPR_MAX 1024
+
+#ifdef NO_NPN_CACHE
+#define NPN_CACHE_ENABLED 0
+#else
+#define NPN_CACHE_ENABLED 1
+#endif
+
+// c(z) = outNeg ^ f(x), com x[perm[i]] = z[i] ^ (bit i de negMask)
+typedef struct {
+    uint8_t perm[TT_MAX_VARS];
+    uint8_t negMask;
+    bool outNeg;
+} NpnTransform;
+
+typedef struct {
+    int literals;
+    char *expression; //Nas variáveis canônicas
+} NpnCacheEntry;
+
+typedef struct {
+    char path[CACHE_DIR_NAME_MAX + 64]; //Vazio com o cache desligado: nada é lido nem gravado
+    char engine[32]; //Executável que grava (nome do .c principal)
+    uint64_t build; //Hash da data e hora da compilação
+    st_table *classes[TT_MAX_VARS + 1]; //Por número de variáveis: tabela canônica -> NpnCacheEntry
+    int hits;
+} NpnCache;
+
+// Troca as duas metades da tabela em relação à variável i (f(x) -> f(x com x_i negado))
+static inline TruthTable npnFlipVar(TruthTable tt, int i, int varCount)
+{
+    int shift = 1 << i;
+    TruthTable var = ttVar(i, varCount);
+    return ((tt & var) >> shift) | ((tt << shift) & var);
+}
+
+// p(z) = f(x) com x[perm[i]] = z[i]
+static inline TruthTable npnPermute(TruthTable tt, const uint8_t *perm, int varCount)
+{
+    TruthTable result = 0;
+    for (int m = 0; m < (1 << varCount); m++) {
+        int x = 0;
+        for (int i = 0; i < varCount; i++) x |= ((m >> i) & 1) << perm[i];
+        result |= ((tt >> x) & 1) << m;
+    }
+    return result;
+}
+
+// Próxima permutação em ordem lexicográfica. false depois da última
+static inline bool npnNextPermutation(uint8_t *perm, int n)
+{
+    int i = n - 2;
+    while (i >= 0 && perm[i] >= perm[i + 1]) i--;
+    if (i < 0) return false;
+    int j = n - 1;
+    while (perm[j] <= perm[i]) j--;
+    uint8_t swap = perm[i];
+    perm[i] = perm[j];
+    perm[j] = swap;
+    for (int a = i + 1, b = n - 1; a < b; a++, b--) {
+        swap = perm[a];
+        perm[a] = perm[b];
+        perm[b] = swap;
+    }
+    return true;
+}
+
+/* Forma canônica: percorre as permutações e, para cada uma, as 2^n negações de entrada em código Gray
+(uma troca de metades por passo), comparando a tabela e o complemento dela */
+static inline TruthTable npnCanonical(TruthTable tt, int varCount, NpnTransform *best)
+{
+    TruthTable full = ttFullMask(varCount);
+    uint8_t perm[TT_MAX_VARS];
+    for (int i = 0; i < varCount; i++) perm[i] = (uint8_t)i;
+
+    TruthTable bestTt = tt;
+    memcpy(best->perm, perm, sizeof(perm));
+    best->negMask = 0;
+    best->outNeg = false;
+
+    do {
+        TruthTable cur = npnPermute(tt, perm, varCount);
+        unsigned mask = 0;
+        for (unsigned g = 0; g < (1u << varCount); g++) {
+            if (g > 0) {
+                int bit = __builtin_ctz(g);
+                cur = npnFlipVar(cur, bit, varCount);
+                mask ^= 1u << bit;
+            }
+            for (int outNeg = 0; outNeg < 2; outNeg++) {
+                TruthTable candidate = outNeg ? (~cur & full) : cur;
+                if (candidate < bestTt) {
+                    bestTt = candidate;
+                    memcpy(best->perm, perm, sizeof(perm));
+                    best->negMask = (uint8_t)mask;
+                    best->outNeg = outNeg;
+                }
+            }
+        }
+    } while (npnNextPermutation(perm, varCount));
+    return bestTt;
+}
+
+/* Reescreve uma expressão NNF (letras, !, *, +, parênteses) trocando cada variável por outra letra, com a polaridade
+invertida onde negate[letra] for true. Com dual, AND e OR também trocam e todo literal é negado (De Morgan).
+Devolve false se a expressão tiver algo fora disso ou não couber em out. */
+static inline bool npnRewrite(const char *expression, const char rename[256], const bool negate[256], bool dual, char *out, size_t outSize)
+{
+    size_t n = 0;
+    bool negated = false;
+    for (const char *p = expression; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (n + 3 >= outSize) return false;
+        if (c == '!') {
+            negated = true;
+        } else if (c == '*' || c == '+') {
+            out[n++] = dual ? ((c == '*') ? '+' : '*') : (char)c;
+        } else if (c == '(' || c == ')') {
+            out[n++] = (char)c;
+        } else if (rename[c] != '\0') {
+            if (negated ^ negate[c] ^ dual) out[n++] = '!';
+            out[n++] = rename[c];
+            negated = false;
+        } else if (c != ' ') {
+            return false;
+        }
+    }
+    out[n] = '\0';
+    return true;
+}
+
+// Literais de uma expressão NNF (uma letra por literal)
+static inline int npnCountLiterals(const char *expression)
+{
+    int literals = 0;
+    for (const char *p = expression; *p != '\0'; p++) {
+        if ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')) literals++;
+    }
+    return literals;
+}
+
+static inline void npnCacheInsert(NpnCache *cache, int varCount, TruthTable canonical, int literals, const char *expression)
+{
+    void *value;
+    if (st_lookup(cache->classes[varCount], (void *)(uintptr_t)canonical, &value)) return;
+    NpnCacheEntry *entry = (NpnCacheEntry *)malloc(sizeof(NpnCacheEntry));
+    if (entry == NULL) {
+        fprintf(stderr, "Erro ao alocar entrada do cache NPN\n");
+        exit(EXIT_FAILURE);
+    }
+    entry->literals = literals;
+    entry->expression = strdup(expression);
+    st_insert(cache->classes[varCount], (void *)(uintptr_t)canonical, entry);
+}
+
+// Cache NPN ligado nesta execução (compilado e com a pasta definida)
+static inline bool npnCacheActive(void)
+{
+    return NPN_CACHE_ENABLED && cacheDir() != NULL;
+}
+
+// Identidade de quem grava: __BASE_FILE__ é o .c principal da compilação, não este header
+static inline void npnCacheIdentity(NpnCache *cache)
+{
+    const char *base = strrchr(__BASE_FILE__, '/');
+    snprintf(cache->engine, sizeof(cache->engine), "%s", (base != NULL) ? base + 1 : __BASE_FILE__);
+    cache->build = 0xcbf29ce484222325ULL;
+    for (const char *c = __DATE__ " " __TIME__; *c != '\0'; c++) cache->build = (cache->build ^ (uint8_t)*c) * 0x100000001b3ULL;
+}
+
+/* Lê o arquivo name da pasta do cache (se existir). Linhas que não parseiam ou de outro executável/compilação são
+ignoradas. Com o cache desligado só cria as tabelas vazias */
+static inline void npnCacheLoad(NpnCache *cache, const char *name)
+{
+    const char *dir = NPN_CACHE_ENABLED ? cacheDir() : NULL;
+    cache->path[0] = '\0';
+    if (dir != NULL) snprintf(cache->path, sizeof(cache->path), "%s/%s", dir, name);
+    cache->hits = 0;
+    npnCacheIdentity(cache);
+    for (int v = 0; v <= TT_MAX_VARS; v++) {
+        cache->classes[v] = st_init_table(st_ptrcmp, st_ptrhash);
+        if (cache->classes[v] == NULL) {
+            fprintf(stderr, "Erro ao criar o cache NPN\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    FILE *file = (cache->path[0] != '\0') ? fopen(cache->path, "r") : NULL;
+    if (file == NULL) return;
+    char line[NPN_EXPR_MAX + 64];
+    char expression[NPN_EXPR_MAX];
+    char engine[sizeof(cache->engine)];
+    while (fgets(line, sizeof(line), file)) {
+        int varCount, literals;
+        unsigned long long canonical, build;
+        if (sscanf(line, "%d %llx %d %1023s %31s %llx", &varCount, &canonical, &literals, expression, engine, &build) != 6) continue;
+        if (varCount < 1 || varCount > TT_MAX_VARS) continue;
+        if (strcmp(engine, cache->engine) != 0 || build != cache->build) continue;
+        npnCacheInsert(cache, varCount, (TruthTable)canonical, literals, expression);
+    }
+    fclose(file);
+}
+
+static enum st_retval npnCacheFreeEntry(void *key, void *value, void *arg)
+{
+    (void)key;
+    (void)arg;
+    NpnCacheEntry *entry = (NpnCacheEntry *)value;
+    free(entry->expression);
+    free(entry);
+    return ST_CONTINUE;
+}
+
+static inline void npnCacheFree(NpnCache *cache)
+{
+    for (int v = 0; v <= TT_MAX_VARS; v++) {
+        if (cache->classes[v] == NULL) continue;
+        st_foreach(cache->classes[v], npnCacheFreeEntry, NULL);
+        st_free_table(cache->classes[v]);
+        cache->classes[v] = NULL;
+    }
+}
+
+/* Procura a classe de tt (sobre varCount variáveis, names[i] = nome da variável i) e, se achar, escreve em out a
+expressão já nas variáveis do objetivo. Devolve o número de literais ou 0 */
+static inline int npnCacheLookup(NpnCache *cache, TruthTable tt, int varCount, const char *names, char *out, size_t outSize)
+{
+    if (varCount < 1 || varCount > TT_MAX_VARS) return 0;
+    NpnTransform transform;
+    TruthTable canonical = npnCanonical(tt, varCount, &transform);
+    void *value;
+    if (!st_lookup(cache->classes[varCount], (void *)(uintptr_t)canonical, &value)) return 0;
+    NpnCacheEntry *entry = (NpnCacheEntry *)value;
+
+    // f(x) = outNeg ^ c(z) com z[i] = x[perm[i]] ^ neg[i]: o literal z_i vira x_perm[i], negado se neg[i]
+    char rename[256] = {0};
+    bool negate[256] = {false};
+    for (int i = 0; i < varCount; i++) {
+        rename['a' + i] = names[transform.perm[i]];
+        negate['a' + i] = (transform.negMask >> i) & 1;
+    }
+    if (!npnRewrite(entry->expression, rename, negate, transform.outNeg, out, outSize)) return 0;
+    cache->hits++;
+    return entry->literals;
+}
+
+// Responde o objetivo pelo cache, no mesmo formato da busca. false se a classe ainda não foi resolvida
+static inline bool npnCacheReport(NpnCache *cache, TruthTable tt, int varCount, const char *names)
+{
+    double start_time = omp_get_wtime();
+    char expression[NPN_EXPR_MAX];
+    int literals = npnCacheLookup(cache, tt, varCount, names, expression, sizeof(expression));
+    if (literals == 0) return false;
+    double end_time = omp_get_wtime();
+
+    printf("Cache NPN: classe já resolvida em %s\n", cache->path);
+    printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", literals);
+    printf("RESULTADO_LITERAIS: %d\n", literals);
+    printf("RESULTADO_EXPRESSAO: %s\n", expression);
+    printf("BENCHMARK_TIME: %.6f\n", end_time - start_time);
+    return true;
+}
+
+// Guarda o resultado de tt (expressão nas variáveis names) na memória e no fim do arquivo. Só para mínimos provados
+static inline void npnCacheRecord(NpnCache *cache, TruthTable tt, int varCount, const char *names, const char *expression)
+{
+    if (expression == NULL || varCount < 1 || varCount > TT_MAX_VARS) return;
+    NpnTransform transform;
+    TruthTable canonical = npnCanonical(tt, varCount, &transform);
+    void *value;
+    if (st_lookup(cache->classes[varCount], (void *)(uintptr_t)canonical, &value)) return;
+
+    // Inverso do npnCacheLookup: x_perm[i] vira z_i
+    char rename[256] = {0};
+    bool negate[256] = {false};
+    for (int i = 0; i < varCount; i++) {
+        unsigned char name = (unsigned char)names[transform.perm[i]];
+        rename[name] = (char)('a' + i);
+        negate[name] = (transform.negMask >> i) & 1;
+    }
+    char canonicalExpression[NPN_EXPR_MAX];
+    if (!npnRewrite(expression, rename, negate, transform.outNeg, canonicalExpression, sizeof(canonicalExpression))) return;
+
+    int literals = npnCountLiterals(canonicalExpression);
+    npnCacheInsert(cache, varCount, canonical, literals, canonicalExpression);
+
+    if (cache->path[0] == '\0' || !cacheDirFits(cache->path, strlen(canonicalExpression) + 64)) return;
+    FILE *file = fopen(cache->path, "a");
+    if (file == NULL) {
+        perror("Aviso: não foi possível gravar o cache NPN");
+        return;
+    }
+    fprintf(file, "%d %016llx %d %s %s %016llx\n", varCount, (unsigned long long)canonical, literals, canonicalExpression,
+            cache->engine, (unsigned long long)cache->build);
+    fclose(file);
+}
+
+#endif
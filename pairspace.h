@@ -0,0 +1,125 @@
+#ifndef PAIRSPACE_H
+#define PAIRSPACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/* Espaço de pares (k, l) entre dois buckets, cortado em blocos (tiles) de linhas k por colunas l.
+Um bloco de PAIR_TILE_COLS colunas de chaves (8 bytes cada) cabe na L1 e é reaproveitado pelas PAIR_TILE_ROWS linhas
+do bloco, então o bucket da direita deixa de ser varrido inteiro da memória para cada k.
+Quando os dois buckets são o mesmo (i == j) só existe o triângulo l >= k: blocos abaixo da diagonal nem são criados
+e os da diagonal começam cada linha em l = k, então nenhuma iteração é descartada.
+Os blocos são agrupados em pedaços (chunks) de trabalho parecido, pela soma acumulada de pares, e cada thread pega
+pedaços inteiros (omp for ou pairSpaceNextChunk). Com poucos blocos para o número de threads, as linhas por bloco
+diminuem até sobrar pedaço para todo mundo. */
+#define PAIR_TILE_ROWS 32
+#define PAIR_TILE_COLS 1024
+#define PAIR_CHUNKS_PER_WORKER 8
+
+typedef struct {
+    int kBegin, kEnd;
+    int lBegin, lEnd;
+} PairTile;
+
+typedef struct {
+    bool triangular;
+    PairTile *tiles;
+    int tileCount;
+    int *chunkStart; //Pedaço c cobre os blocos [chunkStart[c], chunkStart[c + 1])
+    int chunkCount;
+    uint64_t totalWork; //Pares (k, l) no espaço todo
+    _Atomic int nextChunk;
+} PairSpace;
+
+// Primeira coluna da linha k dentro do bloco
+static inline int pairTileFirstCol(const PairSpace *space, const PairTile *tile, int k)
+{
+    return (space->triangular && k > tile->lBegin) ? k : tile->lBegin;
+}
+
+static inline uint64_t pairTileWork(bool triangular, int kBegin, int kEnd, int lBegin, int lEnd)
+{
+    if (!triangular) return (uint64_t)(kEnd - kBegin) * (uint64_t)(lEnd - lBegin);
+    uint64_t work = 0;
+    for (int k = kBegin; k < kEnd; k++) {
+        int first = (k > lBegin) ? k : lBegin;
+        if (first < lEnd) work += lEnd - first;
+    }
+    return work;
+}
+
+// rows = tamanho do bucket da esquerda, cols = da direita. workers = threads que vão dividir os pedaços
+static inline void pairSpaceInit(PairSpace *space, int rows, int cols, bool triangular, int workers)
+{
+    if (workers < 1) workers = 1;
+    int wantedChunks = workers * PAIR_CHUNKS_PER_WORKER;
+    int colTiles = (cols + PAIR_TILE_COLS - 1) / PAIR_TILE_COLS;
+
+    int tileRows = PAIR_TILE_ROWS;
+    while (tileRows > 1 && (long long)((rows + tileRows - 1) / tileRows) * colTiles < wantedChunks) tileRows /= 2;
+    int rowTiles = (rows + tileRows - 1) / tileRows;
+
+    space->triangular = triangular;
+    space->tileCount = 0;
+    space->totalWork = 0;
+    space->tiles = (PairTile *)malloc(((size_t)rowTiles * colTiles + 1) * sizeof(PairTile));
+    uint64_t *work = (uint64_t *)malloc(((size_t)rowTiles * colTiles + 1) * sizeof(uint64_t));
+    if (space->tiles == NULL || work == NULL) {
+        fprintf(stderr, "Erro ao alocar os blocos do espaço de pares\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Linha a linha de blocos: as linhas do bloco ficam quentes enquanto as colunas passam
+    for (int kBegin = 0; kBegin < rows; kBegin += tileRows) {
+        int kEnd = (kBegin + tileRows < rows) ? kBegin + tileRows : rows;
+        for (int lBegin = 0; lBegin < cols; lBegin += PAIR_TILE_COLS) {
+            int lEnd = (lBegin + PAIR_TILE_COLS < cols) ? lBegin + PAIR_TILE_COLS : cols;
+            uint64_t w = pairTileWork(triangular, kBegin, kEnd, lBegin, lEnd);
+            if (w == 0) continue; // Inteiro abaixo da diagonal
+            PairTile *tile = &space->tiles[space->tileCount];
+            tile->kBegin = kBegin;
+            tile->kEnd = kEnd;
+            tile->lBegin = lBegin;
+            tile->lEnd = lEnd;
+            work[space->tileCount++] = w;
+            space->totalWork += w;
+        }
+    }
+
+    // Corta a soma acumulada em partes iguais: o pedaço c começa no primeiro bloco que passa de c/n do trabalho
+    space->chunkCount = (space->tileCount < wantedChunks) ? space->tileCount : wantedChunks;
+    space->chunkStart = (int *)malloc((space->chunkCount + 1) * sizeof(int));
+    if (space->chunkStart == NULL) exit(EXIT_FAILURE);
+    int c = 0;
+    uint64_t prefix = 0;
+    for (int t = 0; t < space->tileCount && c < space->chunkCount; t++) {
+        if (prefix * space->chunkCount >= (uint64_t)c * space->totalWork) space->chunkStart[c++] = t;
+        prefix += work[t];
+    }
+    space->chunkCount = c;
+    space->chunkStart[c] = space->tileCount;
+    atomic_init(&space->nextChunk, 0);
+    free(work);
+}
+
+// Próximo pedaço livre, para quem distribui sem omp for. -1 quando acabou
+static inline int pairSpaceNextChunk(PairSpace *space)
+{
+    int c = atomic_fetch_add_explicit(&space->nextChunk, 1, memory_order_relaxed);
+    return (c < space->chunkCount) ? c : -1;
+}
+
+static inline void pairSpaceFree(PairSpace *space)
+{
+    free(space->tiles);
+    free(space->chunkStart);
+    space->tiles = NULL;
+    space->chunkStart = NULL;
+    space->tileCount = 0;
+    space->chunkCount = 0;
+}
+
+#endif
@@ -2,17 +2,58 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <cudd.h>
+#include "bdd.h"
 #include <st.h>
 #include <time.h>
 //OpenMP mais por simplicidade e adequação ao código, altamente dependente de loops, que acredito serem paralelizáveis.
 //Eventualmente pode ser explorado o uso de MPI, para uma abordagem distribuída, mas isso seria um próximo trabalho. 
 #include <omp.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "litdb.h"
+#include "goalcheck.h"
+#include "topdown.h"
+#include "batch.h"
+#include "pairspace.h"
+#include "workpool.h"
+#include "cancel.h"
+#include "ttkernel.h"
+#include "prefilter.h"
+#include "npncache.h"
+#include "dsd.h"
+#include "bounds.h"
+#include "snapshot.h"
+#include "checkpoint.h"
 
 double global_total_time = 0.0;   // Tempo Fora (Espera + Serviço)
 double global_service_time = 0.0;
 #define PARALLEL_MIN_COMBINATIONS 3000
 #define BATCH_SIZE 256
+
+// Backend por tabela verdade: com ele o combine não passa mais pelo critical do manager
+bool useTruthTable = false;
+TruthTable objectiveTt = 0;
+TruthTable fullTt = 0;
+// Dobra de complementos (bucket.h): ligada quando o bucket 1 fecha por complemento
+bool foldComplements = false;
+
+/* Managers replicados (backend BDD com mais de uma thread). Cada thread tem o seu DdManager com cópias
+(Cudd_bddTransfer) de todos os buckets já montados, então combina sem passar pelo critical(bdd_access).
+Dentro da thread as funções repetidas caem no conjunto local, porque o nó é canônico no manager dela
+e as funções antigas já estão lá. No fim da ordem as novas de cada thread são transferidas para o manager
+principal, onde o ponteiro volta a ser a chave do uniqueCheck, e o bucket novo é replicado para a próxima ordem.
+Compilar com -DSHARED_MANAGER volta para o manager único com trava. Com o backend próprio (USE_ROBDD) as réplicas
+não são usadas: o manager único já aceita várias threads. */
+typedef struct {
+    int threads;
+    DdManager **managers;
+    DdNode **objective; //Objetivo em cada manager
+    DdNode ***nodes; //nodes[b][t * buckets[b].size + k]: réplica da função k do bucket b na thread t
+    SeenSet **seen; //Ponteiros das réplicas dos buckets, por thread (vivos até o fim)
+    int numBuckets;
+} ManagerReplicas;
+
+ManagerReplicas *replicas = NULL;
 /* Iniciando a versão paralela do código. A partir daqui, não temos mais guias. O primeiro passo seria localizar os pontos críticos que podem gerar
 condições de corrida. Vou fazer isso analisando novamente o código. Como o CUDD não é uma biblioteca thread-safe, vai dar um trabalhão, e o ganho
 pode acabar não sendo tão grande quanto esperado inicialmente, mas agora não dá tempo de mudar :) 
@@ -29,12 +70,6 @@ Hash:
 -> Permitir consultas a qualquer momento, mas barrar escritas. -> Inevitavelmente vai causar lentidão, mas a ideia é que isso seja compensado pelo
 paralelismo de tarefas / testar
 -> Retornar à hash única para cada bucket. Problemas de memória, muitas combinações desnecessárias, mas pode ser útil eventualmente*/
-typedef enum{
-    VAR,
-    NOT,
-    AND,
-    OR
-} OpType;
  //Fundir structs de BDD e implementação para diminuir o custo em memória
 /*typedef struct Function
 {
@@ -49,29 +84,6 @@ typedef struct
     Function *impRoot;
 } Function;
 */
-typedef struct Function
-{
-    DdNode *bdd;
-    struct Function *left;
-    struct Function *right;
-    OpType operador;
-    char varName; //Apenas se operador == VAR
-} Function;
-
-typedef struct
-{
-    Function **functions;
-    int order;
-    int size;
-} Bucket;
-
-typedef struct {
-    Function *f1;
-    Function *f2;
-    DdNode *bdd;
-    char op;
-} CombinationBuffer;
-
 
 //Adicionar apenas os literais no objetivo, remover as negações desnecessárias
 
@@ -80,7 +92,7 @@ typedef struct {
 // Função para adicionar um novo bucket
 Bucket *addBucket(Bucket *buckets, int *numBuckets);
 // Imprimir o bucket para fins de debug
-void printBucket(DdManager *manager, Bucket bucket, int varCount);
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount);
 // Função para liberar memória alocada
 // void freeAll(Bucket *buckets, int numBuckets);
 void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets);
@@ -93,15 +105,16 @@ DdNode *evaluatePostfix(DdManager *manager, char **postfix, int count, Function
 // Analisa a expressão infixada de entrada, converte para pós-fixada, e retorna o BDD resultante
 DdNode *parseInputExpression(DdManager *manager, const char *input, Function **outVarMap, int *outVarCount, int *literalCount);
 // Gera o bucket 1 com base no varMap retornado por parseInputExpression
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck);
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck);
 // Combina dois BDDs com AND, OR ou NOT -> gera todos os SOP'S e POS'S
 DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operator);
 // Função para criar um novo bucket de ordem l realizando todas as combinações possíveis entre todos os buckets de ordem n + m = l
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice);
-// Criar um novo nó caso seja variável
-Function* varNode(char varName, DdNode *bdd);
-//Criar um novo nó caso seja operador
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd);
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
+// Managers replicados por thread (backend BDD)
+ManagerReplicas *replicasCreate(DdManager *manager, int threads, int varCount, int numBuckets, DdNode *objectiveExp);
+void replicasAddBucket(DdManager *manager, ManagerReplicas *r, Bucket *bucket, int b);
+void replicasFree(ManagerReplicas *r, Bucket *buckets);
+bool createCombinedBucketReplicated(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
 //Printar a implementação
 void printFunction(Function* node);
 //Para log
@@ -115,8 +128,10 @@ int main(int argc, char *argv[])
     //A princípio toda a primeira parte da execução é sequencial, paralelizar iria gerar overhead desnecessário
     if (argc < 3)
     {
-        fprintf(stderr, "Uso: %s <expressão> <modo>\n", argv[0]);
-        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n");
+        fprintf(stderr, "Uso: %s <expressão> <modo> [tabela] [--resume]\n", argv[0]);
+        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n d - consultar a tabela pré-computada (até 4 variáveis, padrão %s)\n t - busca top-down a partir do objetivo (até %d variáveis)\n", LITDB_DEFAULT_PATH, TT_MAX_VARS);
+        fprintf(stderr, "Para vários alvos (um por linha): %s --batch <arquivo>\n", argv[0]);
+        fprintf(stderr, "Cache NPN e snapshots entre execuções (desligados por padrão): %s=<pasta> [%s=<MB>]\n", CACHE_DIR_ENV, CACHE_DIR_MAX_ENV);
         return EXIT_FAILURE;
     }
     /* Primeiro possível ponto crítico é esse carinha aqui.
@@ -133,28 +148,24 @@ int main(int argc, char *argv[])
     //Por estabilidade no paralelismo, desabilitar autodyn
     Cudd_AutodynDisable(manager);
 
-    //tabela hash para verificar duplicatas, migrada para cá pra permitir verificação entre buckets
-    //Segundo possível ponto crítico de corrida
-    /*Soluções possíveis:
-    -> Usar travas/semáforos para controlar o acesso à tabela hash durante operações de escrita.
-    -> Cada thread ter sua própria tabela hash e depois mesclar os resultados (mais trabalhoso).
-    -> Utilizar uma biblioteca de hash thread-safe (complicado de integrar, mas pode ser necessário).
-    -> Manter a tabela hash única, mas limitar as operações de escrita a momentos específicos, usando barreiras.
-    */
-    st_table *uniqueCheck = st_init_table(st_ptrcmp, st_ptrhash);
-    if (uniqueCheck == NULL)
-    {
-        fprintf(stderr, "Erro ao criar tabela hash ST\n");
+    
+    if (strcmp(argv[1], "--batch") == 0) {
+        int status = runBatch(manager, argv[2]);
         Cudd_Quit(manager);
-        return EXIT_FAILURE;
+        return status;
     }
-    
+
     char choice = argv[2][0];
 
-    if (choice != 'e' && choice != 'c') {
-        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e' ou 'c'.\n", choice);
+    if (choice != 'e' && choice != 'c' && choice != 'd' && choice != 't') {
+        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e', 'c', 'd' ou 't'.\n", choice);
         return EXIT_FAILURE;
     }
+    // --resume: continua do checkpoint de uma execução interrompida (checkpoint.h)
+    bool resume = false;
+    for (int a = 3; a < argc; a++) {
+        if (strcmp(argv[a], "--resume") == 0) resume = true;
+    }
 
     int numBuckets = 0;
     bool found = false;
@@ -170,14 +181,12 @@ int main(int argc, char *argv[])
     if (objectiveExp == NULL)
     {
         fprintf(stderr, "Erro ao parsear a expressão.\n");
-        st_free_table(uniqueCheck);
         Cudd_Quit(manager);
         return EXIT_FAILURE;
     }
     //Esqueci que tautologias e contradições existem, então adicionei só agora kkkkk
     if(objectiveExp == Cudd_ReadLogicZero(manager)) {
         printf("A expressão é uma contradição (Sempre falsa).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
@@ -185,54 +194,187 @@ int main(int argc, char *argv[])
     }
     if(objectiveExp == Cudd_ReadOne(manager)) {
         printf("A expressão é uma tautologia (Sempre verdadeira).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
         return EXIT_SUCCESS;
     }
     Cudd_PrintDebug(manager, objectiveExp, varCount, 2);
+
+    // Com poucas variáveis o CUDD só serve para o parse, o resto roda sobre tabelas verdade
+    if (varCount <= TT_MAX_VARS) {
+        useTruthTable = true;
+        fullTt = ttFullMask(varCount);
+        objectiveTt = bddToTruthTable(manager, objectiveExp, varCount);
+        printf("Backend: tabela verdade (%d variáveis)\n", varCount);
+    }
+
+    // Modo d: a resposta já está na tabela, não precisa de bucket nenhum
+    if (choice == 'd') {
+        int status = litDbQuery(argc > 3 ? argv[3] : LITDB_DEFAULT_PATH, objectiveTt, varCount, varMap);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return status;
+    }
+    if (choice == 't' && !useTruthTable) {
+        fprintf(stderr, "Erro: o modo t só funciona com até %d variáveis (objetivo tem %d).\n", TT_MAX_VARS, varCount);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+
+    // Cache NPN: objetivo equivalente a um já resolvido (a menos de permutação e negações) não passa pela busca
+    NpnCache npnCache;
+    char varNames[TT_MAX_VARS + 1] = {0};
+    bool npnActive = npnCacheActive() && useTruthTable && (choice == 'e' || choice == 'c');
+    if (npnActive) {
+        for (int i = 0; i < varCount; i++) varNames[i] = varMap[i].varName;
+        npnCacheLoad(&npnCache, NPN_CACHE_DEFAULT_PATH);
+        if (npnCacheReport(&npnCache, objectiveTt, varCount, varNames)) {
+            npnCacheFree(&npnCache);
+            Cudd_RecursiveDeref(manager, objectiveExp);
+            for (int i = 0; i < varCount; i++) {
+                if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+            }
+            free(varMap);
+            Cudd_Quit(manager);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    // Decomposição disjunta: objetivo que quebra em blocos de variáveis separadas é resolvido bloco a bloco
+    if ((choice == 'e' || choice == 'c') && dsdReport(manager, objectiveExp, varMap, varCount, literalCount, npnActive ? &npnCache : NULL)) {
+        if (npnActive) npnCacheFree(&npnCache);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_SUCCESS;
+    }
+
+    //Conjunto para verificar duplicatas entre buckets, antes o segundo ponto crítico de corrida.
+    //Agora as inserções são atômicas (bitmap) ou travam só uma fatia da hash, então não passam mais pelo critical.
+    SeenSet *uniqueCheck = seenSetCreate(useTruthTable, varCount);
+    if (uniqueCheck == NULL)
+    {
+        fprintf(stderr, "Erro ao criar o conjunto de duplicatas\n");
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+    printf("Dedup: %s\n", seenSetDescription(uniqueCheck));
+    if (useTruthTable) printf("Kernel: %s\n", ttCombineKernelName());
+    else {
+        // Fora do alcance da tabela verdade: assinaturas por simulação para evitar testes exatos no BDD
+        sigInit(manager, objectiveExp, varCount);
+        printf("Assinaturas: %d vetores de simulação\n", SIG_BITS);
+    }
     
      //Iniciar aqui para levar em conta apenas o algoritmo
     double start_time = omp_get_wtime();
     clock_t start_clock = clock();
 
     // Inicializa o bucket 1
+    // Limites da busca: abaixo do inferior não existe fórmula e a incumbente já é uma resposta com upper literais
+    int searchLimit = literalCount;
+    Bounds bounds = {0, 0, "", false};
+    BucketSnapshot snapshot = {0};
+    if (choice == 'e' || choice == 'c') {
+        boundsCompute(manager, objectiveExp, varMap, varCount, argv[1], literalCount, &bounds);
+        if (bounds.upper > 0) searchLimit = bounds.upper - 1;
+    }
+
     buckets = addBucket(buckets, &numBuckets);
-    initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    if (bounds.upper > 0 && bounds.lower >= bounds.upper) {
+        // Os limites se encontraram: nenhum bucket precisa ser montado
+        if (npnActive) bucketEchoBegin();
+        boundsReportIncumbent(&bounds);
+        found = true;
+    } else {
+        initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    }
+    if (!found && choice != 't') {
+        foldComplements = bucketFoldLiterals(manager, &buckets[0]);
+        if (foldComplements) printf("Dobra de complementos: ativa (%d representantes no bucket 1)\n", buckets[0].size);
+    }
     if (!found) {
-    printBucket(manager, buckets[0], varCount);
+    printBucket(manager, buckets, 1, varCount);
+    if (npnActive) bucketEchoBegin(); // A expressão do resultado vai para o cache NPN
 
     // Inicializa todos os buckets que poderão ser usados nesta execução do programa
-    while (numBuckets < literalCount)
+    while (numBuckets < searchLimit)
     {
         buckets = addBucket(buckets, &numBuckets);
     }
-    for (int order = 2; order <= literalCount; order++)
+    // Ordens que já estão no snapshot deste bucket 1 (snapshot.h) não são montadas de novo
+    bool snapshotActive = BUCKET_SNAPSHOT_ENABLED && cacheDir() != NULL && useTruthTable && (choice == 'e' || choice == 'c');
+    if (snapshotActive) bucketSnapshotOpen(&snapshot, buckets, numBuckets, varCount, uniqueCheck);
+    if (snapshotActive) checkpointInit(&snapshot, buckets, resume);
+    else if (resume) fprintf(stderr, "--resume ignorado: checkpoint só existe com %s, a tabela verdade e os modos e e c\n", CACHE_DIR_ENV);
+    if (choice == 't') {
+        // Motor top-down: só monta os buckets até a metade do orçamento
+        found = topDownSearch(manager, buckets, numBuckets, varCount, objectiveExp, uniqueCheck, true);
+    }
+#if !defined(SHARED_MANAGER) && !BDD_THREAD_SAFE
+    if (!useTruthTable && choice != 't' && omp_get_max_threads() > 1) {
+        replicas = replicasCreate(manager, omp_get_max_threads(), varCount, numBuckets, objectiveExp);
+        replicasAddBucket(manager, replicas, &buckets[0], 0);
+        printf("Managers replicados: %d\n", replicas->threads);
+    }
+#endif
+    for (int order = 2; order <= searchLimit && choice != 't'; order++)
     {
         //Aqui começa a parte paralela
         //Dentro da função, quero que cada thread trate de combinar buckets diferentes
         found = createCombinedBucket(manager, buckets, numBuckets, order, objectiveExp, uniqueCheck, choice);
         if (found) break; // Sai do loop se encontrou a equivalência
+        if (snapshotActive) {
+            bucketSnapshotSave(&snapshot, buckets, order);
+            checkpointOrderPublished(order);
+            if (checkpointStopRequested() && order < searchLimit) checkpointExitAfterOrder(order);
+        }
         //printBucket(manager, buckets[order - 1], varCount);
         
     }
+    if (!found && bounds.upper > 0) {
+        // Nada com menos literais que a incumbente
+        boundsReportIncumbent(&bounds);
+        found = true;
+    }
     }
     if (!found) {
-        printf("Nenhuma equivalência encontrada até a ordem %d.\n", literalCount);
+        printf("Nenhuma equivalência encontrada até a ordem %d.\n", searchLimit);
     }
     
     //Acaba aqui, liberar a memória não faz parte do algoritmo
     double end_time = omp_get_wtime();
     clock_t end_clock = clock();
+    if (npnActive) {
+        const char *resultExpression = bucketEchoEnd();
+        if (found && !bounds.reported) npnCacheRecord(&npnCache, objectiveTt, varCount, varNames, resultExpression);
+        npnCacheFree(&npnCache);
+    }
 
     // Após o uso, libera a hash
     // Vou ter que rever todos os frees mais pra frente
-    st_free_table(uniqueCheck);
+    seenSetFree(uniqueCheck);
+    sigFree();
+    if (replicas) replicasFree(replicas, buckets);
 
  
     Cudd_RecursiveDeref(manager, objectiveExp);
     freeAllBuckets(manager, buckets, numBuckets);
+    checkpointFinish();
+    bucketSnapshotClose(&snapshot);
 
     if (varMap != NULL) {
         for (int i = 0; i < varCount; i++) {
@@ -264,21 +406,20 @@ Bucket *addBucket(Bucket *buckets, int *numBuckets)
         fprintf(stderr, "Erro ao realocar memória para buckets.\n");
         exit(EXIT_FAILURE);
     }
-    buckets[(*numBuckets) - 1].order = 0;
-    buckets[(*numBuckets) - 1].functions = NULL;
-    buckets[(*numBuckets) - 1].size = 0;
+    memset(&buckets[(*numBuckets) - 1], 0, sizeof(Bucket));
     return buckets;
 }
 
-void printBucket(DdManager *manager, Bucket bucket, int varCount)
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount)
 {
-    printf("Bucket Order: %d | Size: %d\n", bucket.order, bucket.size);
-    if (bucket.functions != NULL)
+    Bucket *bucket = &buckets[order - 1];
+    printf("Bucket Order: %d | Size: %d\n", bucket->order, bucket->size);
+    if (bucket->size > 0)
     {
-        for (int i = 0; i < bucket.size; i++)
+        for (int i = 0; i < bucket->size; i++)
         {
             printf("  Function[%d]:", i);
-            printFunction(bucket.functions[i]);
+            printBucketFunction(buckets, order, i);
             printf("\n");
             //Cudd_PrintDebug(manager, bucket.functions[i], varCount, 2);
         }
@@ -295,27 +436,16 @@ void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets)
         return;
     for (int i = 0; i < numBuckets; i++)
     {
-        if (buckets[i].functions != NULL)
+        if (buckets[i].bdd != NULL)
         {
-            // Dereferencia todas as funções no bucket
+            // Dereferencia todas as funções no bucket (não existem no backend por tabela verdade)
             for (int j = 0; j < buckets[i].size; j++)
             {
-                if (buckets[i].functions[j] != NULL)
-                {
-                    //Deferecia o BDD
-                    Cudd_RecursiveDeref(manager, buckets[i].functions[j]->bdd);
-                    
-                    //Libera o nó de implementação
-                    //Primeiro verifica se é NOT. Se sim, libera o filho esquerdo antes
-                    if (buckets[i].functions[j]->bdd) 
-                    Cudd_RecursiveDeref(manager, buckets[i].functions[j]->bdd);
-
-                    //Libera a struct
-                    free(buckets[i].functions[j]);
-                }
+                Cudd_RecursiveDeref(manager, buckets[i].bdd[j]);
             }
-            free(buckets[i].functions); // Libera o array de ponteiros
         }
+        bucketFreeColumns(&buckets[i]); // Libera as colunas
+        goalIndexFree(manager, &buckets[i].goal);
     }
     free(buckets); // Libera o array de buckets
 }
@@ -521,54 +651,69 @@ DdNode *parseInputExpression(DdManager *manager, const char *input, Function **o
 }
 
 
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck)
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck)
 {
     printf("Inicializando o primeiro bucket...\n");
     bucket->order = 1;
-    bucket->functions = (Function **)malloc(((varCount * 2) + 1) * sizeof(Function *));
-    if (bucket->functions == NULL) exit(EXIT_FAILURE);
+    bucketReserve(bucket, varCount * 2);
 
     int actualSize = 0;
     
     for (int i = 0; i < varCount; i++)
     {
-        DdNode *varBdd = varMap[i].bdd;
+        bool isPosUnate, isNegUnate;
+
+        if (useTruthTable) {
+            // Mesma análise, mas com os cofatores tirados direto da tabela verdade
+            TruthTable cofPos = ttCofactor(objectiveTt, i, true, varCount);
+            TruthTable cofNeg = ttCofactor(objectiveTt, i, false, varCount);
+
+            // Verifica Dependência
+            if (cofPos == cofNeg) continue;
+
+            isPosUnate = ttLeq(cofNeg, cofPos);
+            isNegUnate = ttLeq(cofPos, cofNeg);
+        } else {
+            DdNode *varBdd = varMap[i].bdd;
+
+            // Calcula Cofatores: f(x=1) e f(x=0)
+            DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
+            Cudd_Ref(cofPos);
+            DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
+            Cudd_Ref(cofNeg);
+
+            // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
+            if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
+                Cudd_RecursiveDeref(manager, cofPos);
+                Cudd_RecursiveDeref(manager, cofNeg);
+                continue; 
+            }
 
+            // Verifica Unicidade
+            isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
+            isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
 
-        // Calcula Cofatores: f(x=1) e f(x=0)
-        DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
-        Cudd_Ref(cofPos);
-        DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
-        Cudd_Ref(cofNeg);
-        
-        // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
-        if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
             Cudd_RecursiveDeref(manager, cofPos);
             Cudd_RecursiveDeref(manager, cofNeg);
-            continue; 
         }
-
-        // Verifica Unicidade
-        bool isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
-        bool isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
         bool isBinate = !isPosUnate && !isNegUnate;
 
-        Cudd_RecursiveDeref(manager, cofPos);
-        Cudd_RecursiveDeref(manager, cofNeg);
-
         // Adiciona se for positivo unate ou binate
         if (isPosUnate || isBinate) {
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função]
-            bucket->functions[actualSize] = varNode(varMap[i].varName, varMap[i].bdd);
+            // Cria a entrada da função
+            if (useTruthTable) {
+                bucketAppendLiteral(bucket, ttVar(i, varCount), NULL, varMap[i].varName, false);
+            } else {
+                Cudd_Ref(varMap[i].bdd);
+                bucketAppendLiteral(bucket, 0, varMap[i].bdd, varMap[i].varName, false);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
-            //logExpressionToFile(bucket->functions[actualSize], 1);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) {
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) {
                 
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 *found = true;
             }
             actualSize++;
@@ -576,21 +721,23 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
 
         // Adiciona se for negativo unate ou binate
         if (isNegUnate || isBinate) {
-            // Temporário para o BDD negado
-            DdNode *notBdd = Cudd_Not(varMap[i].bdd);
-            Cudd_Ref(notBdd);
-            Function *varNodePtr = varNode(varMap[i].varName, varMap[i].bdd);
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função
-            bucket->functions[actualSize] = opNode(NOT, varNodePtr, NULL, notBdd);
+            if (useTruthTable) {
+                TruthTable varTt = ttVar(i, varCount);
+                bucketAppendLiteral(bucket, ~varTt & fullTt, NULL, varMap[i].varName, true);
+            } else {
+                // BDD negado
+                DdNode *notBdd = Cudd_Not(varMap[i].bdd);
+                Cudd_Ref(notBdd);
+                // Cria a entrada da função
+                bucketAppendLiteral(bucket, 0, notBdd, varMap[i].varName, true);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
-            //logExpressionToFile(bucket->functions[actualSize], 1);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) 
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) 
             {
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 printf("\n");
                 *found = true;
             }
@@ -598,7 +745,6 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
         }
     }
 
-    bucket->size = actualSize;
     printf("Primeiro bucket inicializado com %d funções.\n", actualSize);
     return NULL;
 }
@@ -628,57 +774,109 @@ DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operato
     return result;
 }
 
-// Função para realizar o realloc quando necessário
-void addFunctionToDynamicArray(Function *func, Function ***array, int *count, int *capacity)
+/* Descarrega o buffer de uma thread. A deduplicação acontece fora de qualquer critical (o SeenSet é seguro para várias threads);
+só os derefs de duplicatas ainda precisam do manager. As aceitas vão para o bucket parcial da própria thread, sem trava. */
+void flushCombinationBuffer(DdManager *manager, CombinationBuffer *buffer, int count, SeenSet *uniqueCheck, Bucket *part, CancelToken *cancel)
 {
-    if (*count == *capacity)
+    DdNode *rejected[BATCH_SIZE];
+    uint64_t keys[BATCH_SIZE];
+    bool isNew[BATCH_SIZE];
+    int rejectedCount = 0;
+
+    bool stopped = cancelRaised(cancel);
+
+    // Lote inteiro de uma vez no conjunto, sem seção crítica. Com a dobra a chave é o representante
+    if (!stopped) {
+        for (int b = 0; b < count; b++) {
+            if (useTruthTable) {
+                keys[b] = foldComplements ? bucketCanonicalTt(buffer[b].tt) : buffer[b].tt;
+            } else {
+                keys[b] = (uint64_t)(uintptr_t)(foldComplements ? bucketCanonicalBdd(buffer[b].bdd) : buffer[b].bdd);
+            }
+        }
+        seenSetInsertBatch(uniqueCheck, keys, count, isNew);
+    }
+
+    for (int b = 0; b < count; b++)
     {
-        // Dobra a capacidade (ou inicializa se for 0)
-        *capacity = (*capacity == 0) ? 256 : (*capacity) * 2;
-        *array = (Function **)realloc(*array, (*capacity) * sizeof(Function *));
-        if (*array == NULL)
+        if (!stopped && isNew[b]) {
+            bool complemented = useTruthTable ? keys[b] != buffer[b].tt : keys[b] != (uint64_t)(uintptr_t)buffer[b].bdd;
+            bucketAppendFolded(part, useTruthTable ? keys[b] : 0, useTruthTable ? NULL : (DdNode *)(uintptr_t)keys[b],
+                               complemented, (buffer[b].op == '*') ? AND : OR, buffer[b].leftOrder, buffer[b].left, buffer[b].right);
+        } else if (buffer[b].bdd) {
+            rejected[rejectedCount++] = buffer[b].bdd;
+        }
+    }
+
+    if (rejectedCount > 0) {
+        BDD_CRITICAL
         {
-            fprintf(stderr, "Erro ao realocar array dinâmico de BDDs\n");
-            exit(EXIT_FAILURE);
+            for (int b = 0; b < rejectedCount; b++) {
+                Cudd_RecursiveDeref(manager, rejected[b]);
+            }
         }
     }
-    (*array)[*count] = func;
-    (*count)++;
 }
 
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice)
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice)
 {
     Bucket *targetBucket = &buckets[targetOrder - 1];
-    
-    Function **newFunctions = NULL;
-    int newFuncCount = 0;
-    int newFuncCapacity = 0;
 
-    bool stop = false;
+    // Assinaturas dos buckets que vão ser combinados (só no backend BDD): o goal check e o pré-filtro consultam
+    bucketSigEnsure(manager, buckets, targetOrder - 1);
 
-    for (int i = 0; i < targetOrder-1; i++)
-    {
-        int order1 = buckets[i].order; 
-        int order2 = targetOrder - order1;
-        if (order2 < order1) break; // Evita repetições desnecessárias
-        int j = order2 - 1;
-        if (!(buckets[i].order > 0) && !(buckets[j].order > 0) && 
-                !(buckets[i].order + buckets[j].order == targetOrder)) continue;
-                Bucket *b1 = &buckets[i];
-                Bucket *b2 = &buckets[j];
+    // No modo e o objetivo é procurado por consulta nos buckets menores, e o bucket só é montado se ainda puder alimentar uma ordem maior
+    if (choice == 'e') {
+        if (goalCheckOrder(manager, buckets, targetOrder, objectiveExp)) return true;
+        if (targetOrder >= numBuckets) return false;
+    }
+
+    // Bucket mapeado do snapshot: já está completo, só falta procurar o objetivo nele (no modo e o goal check já procurou)
+    if (targetBucket->mapped) return bucketSnapshotFindObjective(buckets, targetOrder, objectiveExp);
+
+    // Nenhuma thread combinando agora: o backend próprio pode coletar os nós mortos da ordem anterior
+    if (!useTruthTable) bddSafePoint(manager);
 
-                 #pragma omp flush(stop)
-                if (stop) break; // Sai do loop se a flag de parada foi ativada na iteração passada
+    // Reserva espaço no conjunto de duplicatas antes de combinar (ninguém está inserindo agora)
+    seenSetReserve(uniqueCheck, predictBucketGrowth(buckets, targetOrder));
+    prefilterBegin();
 
-                if (b1->size == 0 || b2->size == 0) continue;
+    if (replicas) {
+        bool found = createCombinedBucketReplicated(manager, buckets, numBuckets, targetOrder, objectiveExp, uniqueCheck, choice);
+        prefilterReport(targetOrder);
+        // A próxima ordem precisa do bucket novo em todas as threads
+        if (!found && targetOrder < numBuckets) replicasAddBucket(manager, replicas, &buckets[targetOrder - 1], targetOrder - 1);
+        return found;
+    }
+    
+    // Um bucket parcial por thread, juntados no fim da ordem
+    int partCount = omp_get_max_threads();
+    Bucket *parts = (Bucket *)calloc(partCount, sizeof(Bucket));
+    if (parts == NULL) exit(EXIT_FAILURE);
+
+    CancelToken cancel;
+    cancelInit(&cancel);
+
+    // Espaços de pares de todos os (i, j) da ordem; com i == j só o triângulo l >= k existe
+    // Numa ordem retomada o corte é o de quem gravou o checkpoint
+    int chunkWorkers = checkpointWorkers(targetOrder, partCount);
+    PairSpace *spaces = (PairSpace *)calloc(targetOrder, sizeof(PairSpace));
+    if (spaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < targetOrder - 1; i++)
+    {
+        int j = targetOrder - (i + 1) - 1;
+        if (j < i) break; // Evita repetições desnecessárias
+        if (buckets[i].size > 0 && buckets[j].size > 0) pairSpaceInit(&spaces[i], buckets[i].size, buckets[j].size, i == j, chunkWorkers);
+    }
+    // Blocos prontos de uma execução interrompida são pulados e as funções deles já entram no parcial da thread 0
+    CheckpointProgress progress;
+    checkpointBeginOrder(&progress, targetOrder, spaces, targetOrder - 1, chunkWorkers, &parts[0], uniqueCheck);
+    // Os pedaços de todos os pares entram de uma vez nos deques (workpool.h): um par pequeno não espera mais o grande terminar
+    WorkPool pool;
+    workPoolInit(&pool, spaces, targetOrder - 1, partCount);
 
-                // Calcula a carga de trabalho estimada
-                //long long por que o valor cresce de forma explosiva
-                long long total_iterations = (long long)b1->size * (long long)b2->size;
-                // Parallel inicia o paralelismo, for define o loop a ser paralelizado
-                // collapse(2) combina os loops aninhados, schedule(dynamid) distribui a carga dinamicamente
                 //if() define que só paralelize trabalho que compense o overhead (Valor estimado com base em testes)
-                #pragma omp parallel if(total_iterations > PARALLEL_MIN_COMBINATIONS)
+                #pragma omp parallel if(pool.totalWork > PARALLEL_MIN_COMBINATIONS)
                 {
                     // Para calcular o tempo gasto em travas
                     double local_total_time = 0.0;
@@ -686,37 +884,135 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
                     //Vou aplicar batching pra diminuir o overhead de criação de threads e mudança de contexto
                     CombinationBuffer buffer[BATCH_SIZE];
                     int buffer_count = 0;
-                
-                #pragma omp for collapse(2) schedule(dynamic) nowait
-                for (int k = 0; k < b1->size; k++)
+                    int worker = omp_get_thread_num();
+                    Bucket *part = &parts[worker];
+                    TtCombineKernel combineKernel = ttCombineKernel();
+                    TruthTable andOut[TT_KERNEL_LANES], orOut[TT_KERNEL_LANES], negRight[TT_KERNEL_LANES];
+                    TruthTable negObjectiveTt = ~objectiveTt & fullTt;
+                    int polarities = foldComplements ? 2 : 1; // Com a dobra, b1[k] também combina com o complemento de b2[l]
+                    TtComboMask mask;
+                    PrefilterStats stats = {0, 0, 0, 0, 0, 0};
+
+                // Cada tarefa é um pedaço inteiro de blocos de um par; sem tarefa própria a thread rouba das outras
+                // O token é testado em cada tarefa, bloco e trecho de linha: depois do acerto ninguém termina o pedaço
+                // Com o sinal de parada (checkpoint.h) a thread termina o bloco em que está e não pega outro
+                for (int task = workPoolNext(&pool, worker); task >= 0 && !cancelRaised(&cancel) && !checkpointStopRequested(); task = workPoolNext(&pool, worker))
                 {
-                    for (int l = 0; l < b2->size; l++)
-                    {
-                        // Verifica se a flag de parada foi ativada
-                        #pragma omp flush(stop)
-                        if (stop) continue;
+                int i = pool.tasks[task].pair;
+                int j = targetOrder - (i + 1) - 1;
+                Bucket *b1 = &buckets[i];
+                Bucket *b2 = &buckets[j];
+                PairSpace *space = &spaces[i];
+                int c = pool.tasks[task].chunk;
+                for (int tile = space->chunkStart[c]; tile < space->chunkStart[c + 1] && !cancelRaised(&cancel) && !checkpointStopRequested(); tile++)
+                {
+                if (checkpointTileDone(&progress, i, tile)) continue;
+                for (int k = space->tiles[tile].kBegin; k < space->tiles[tile].kEnd; k++)
+                {
+                    int firstL = pairTileFirstCol(space, &space->tiles[tile], k);
+                    int lEnd = space->tiles[tile].lEnd;
+
+                    if (useTruthTable) {
+                        // Tabela verdade é local à thread: kernel vetorial sobre trechos da linha, só as não constantes entram no buffer
+                        for (int l0 = firstL; l0 < lEnd && !cancelRaised(&cancel); l0 += TT_KERNEL_LANES)
+                        for (int pol = 0; pol < polarities; pol++) {
+                            int count = (lEnd - l0 < TT_KERNEL_LANES) ? lEnd - l0 : TT_KERNEL_LANES;
+                            const TruthTable *right = &b2->tt[l0];
+                            if (pol) {
+                                for (int x = 0; x < count; x++) negRight[x] = ~b2->tt[l0 + x] & fullTt;
+                                right = negRight;
+                            }
+                            uint32_t rightFlag = pol ? BUCKET_NEGATED : 0;
+                            combineKernel(b1->tt[k], right, count, fullTt, objectiveTt, andOut, orOut, &mask);
+                            prefilterCountMask(&stats, count, &mask);
+
+                            // Com a dobra o complemento do objetivo também serve (a combinação dual dá o objetivo)
+                            uint64_t andNegHit = 0, orNegHit = 0;
+                            if (foldComplements) {
+                                andNegHit = ttKernelMatch(andOut, mask.andKeep, negObjectiveTt);
+                                orNegHit = ttKernelMatch(orOut, mask.orKeep, negObjectiveTt);
+                            }
 
-                        if (i == j && l < k) continue; // Evita repetições desnecessárias em buckets iguais
+                            //Parada imediata caso encontre equivalência
+                            uint64_t hits = mask.andHit | mask.orHit | andNegHit | orNegHit;
+                            if (hits && choice == 'e') {
+                                int x = __builtin_ctzll(hits);
+                                OpType hitOp = (((mask.andHit | andNegHit) >> x) & 1) ? AND : OR;
+                                uint32_t left = (uint32_t)k, hitRight = (uint32_t)(l0 + x) | rightFlag;
+                                if (((andNegHit | orNegHit) >> x) & 1) bucketDualize(&hitOp, &left, &hitRight);
+                                if (cancelRaise(&cancel)) {
+                                    printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+                                    printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+                                    printf("RESULTADO_EXPRESSAO: ");
+                                    printBucketCombination(buckets, hitOp, i + 1, left, j + 1, hitRight);
+                                    printf("\n");
+                                }
+                                break;
+                            }
+
+                            for (uint64_t keep = mask.andKeep | mask.orKeep; keep != 0; keep &= keep - 1) {
+                                int x = __builtin_ctzll(keep);
+                                for (int op = 0; op < 2; op++) {
+                                    if (!(((op == 0 ? mask.andKeep : mask.orKeep) >> x) & 1)) continue;
+                                    buffer[buffer_count].left = (uint32_t)k;
+                                    buffer[buffer_count].right = (uint32_t)(l0 + x) | rightFlag;
+                                    buffer[buffer_count].leftOrder = (uint8_t)(i + 1);
+                                    buffer[buffer_count].bdd = NULL;
+                                    buffer[buffer_count].tt = (op == 0) ? andOut[x] : orOut[x];
+                                    buffer[buffer_count].op = (op == 0) ? '*' : '+';
+                                    buffer_count++;
+                                    if (buffer_count == BATCH_SIZE) {
+                                        flushCombinationBuffer(manager, buffer, buffer_count, uniqueCheck, part, &cancel);
+                                        buffer_count = 0;
+                                    }
+                                }
+                            }
+                        }
+                        continue;
+                    }
+
+                    for (int l = firstL; l < lEnd && !cancelRaised(&cancel); l++)
+                    for (int pol = 0; pol < polarities; pol++)
+                    {
+                        DdNode *right = Cudd_NotCond(b2->bdd[l], pol);
+                        uint32_t rightRef = (uint32_t)l | (pol ? BUCKET_NEGATED : 0);
+
+                        // Pré-filtro com Cudd_bddLeq: não cria nó, mas usa o cache do manager, então também é crítico
+                        // Se as assinaturas já refutam tudo, nenhum Cudd_bddLeq roda e a trava nem é pega
+                        int ops = 0;
+                        Signature leftSig, rightSig;
+                        const Signature *sf = bucketRefSig(b1, (uint32_t)k, &leftSig);
+                        const Signature *sg = bucketRefSig(b2, rightRef, &rightSig);
+                        if (prefilterNeedsManager(sf, sg)) {
+                            double t_filter_start = omp_get_wtime();
+                            BDD_CRITICAL
+                            {
+                                double t_in_start = omp_get_wtime();
+                                ops = prefilterBdd(manager, b1->bdd[k], right, sf, sg, &stats);
+                                local_service_time += omp_get_wtime() - t_in_start;
+                            }
+                            local_total_time += omp_get_wtime() - t_filter_start;
+                        } else {
+                            ops = prefilterBdd(manager, b1->bdd[k], right, sf, sg, &stats);
+                        }
 
-                        Function *f1 = b1->functions[k];
-                        Function *f2 = b2->functions[l];
-                        
                         for (int op = 0; op < 2; op++)
                         {
-                            if (stop) continue; //Só pra garantir
+                            if (cancelRaised(&cancel)) break;
+                            if (!(ops & ((op == 0) ? PREFILTER_AND : PREFILTER_OR))) continue;
 
                             DdNode *newBdd = NULL;
                             char opChar = (op == 0) ? '*' : '+';
-                            
+
                             // Medir o tempo gasto dentro do critical, apenas para combinar bdds
                            double t_out_start = omp_get_wtime();
-                            //Crítico pois precisa acessar o manager, que é compartilhado
+                            //Crítico pois precisa acessar o manager, que é compartilhado (o BDD_CRITICAL some no backend próprio)
                            
-                            #pragma omp critical(bdd_access)
+                            BDD_CRITICAL
                             {
                                 double t_in_start = omp_get_wtime();
-                                if(!stop)
-                                newBdd = combineBdds(manager, f1->bdd, f2->bdd, opChar);
+                                if (!cancelRaised(&cancel))
+                                newBdd = combineBdds(manager, b1->bdd[k], right, opChar);
                                 double t_in_end = omp_get_wtime();
                                 local_service_time += (t_in_end - t_in_start);
                             }
@@ -728,41 +1024,33 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
                             
 
                             if (newBdd == Cudd_ReadLogicZero(manager) || newBdd == Cudd_ReadOne(manager)) {
-                             #pragma omp critical(bdd_access)
+                             BDD_CRITICAL
                              Cudd_RecursiveDeref(manager, newBdd);
                              continue;
                             }
 
-
                             //Parada imediata caso encontre equivalência
-                            if (newBdd == objectiveExp && choice == 'e')
+                            bool negHit = foldComplements && newBdd == Cudd_Not(objectiveExp);
+                            if ((newBdd == objectiveExp || negHit) && choice == 'e')
                             {
-                                #pragma omp critical(success_report)
+                                OpType hitOp = (opChar == '*') ? AND : OR;
+                                uint32_t left = (uint32_t)k, hitRight = rightRef;
+                                if (negHit) bucketDualize(&hitOp, &left, &hitRight);
+                                // Só quem levantou o token primeiro imprime
+                                if (cancelRaise(&cancel))
                                 {
-                                    if(!stop) 
-                                    {
-                                        stop = true; // Ativa a flag de parada
-                                    
-                                        printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
-
-                                        // Prefixo para facilitar o grep no script
-                                        printf("RESULTADO_LITERAIS: %d\n", targetOrder);
-                                
-                                        Function tempNode;
-                                        tempNode.operador = (opChar == '*') ? AND : OR;
-                                        tempNode.left = f1;
-                                        tempNode.right = f2;
-                                        tempNode.varName = '\0';
-                                        
-
-                                        printf("RESULTADO_EXPRESSAO: ");
-                                        printFunction(&tempNode); 
-                                        printf("\n"); // Nova linha obrigatória após a expressão recursiva
-                                
-                                    }
+                                    printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+
+                                    // Prefixo para facilitar o grep no script
+                                    printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+                            
+                                    printf("RESULTADO_EXPRESSAO: ");
+                                    printBucketCombination(buckets, hitOp, i + 1, left, j + 1, hitRight);
+                                    printf("\n"); // Nova linha obrigatória após a expressão recursiva
+                            
                                 }
 
-                                #pragma omp critical(bdd_access)
+                                BDD_CRITICAL
                                 {
                                     Cudd_RecursiveDeref(manager, newBdd);
                                 }
@@ -770,55 +1058,27 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
                             }
 
 
-                            buffer[buffer_count].f1 = f1;
-                            buffer[buffer_count].f2 = f2;
+                            buffer[buffer_count].left = (uint32_t)k;
+                            buffer[buffer_count].right = rightRef;
+                            buffer[buffer_count].leftOrder = (uint8_t)(i + 1);
                             buffer[buffer_count].bdd = newBdd;
+                            buffer[buffer_count].tt = 0;
                             buffer[buffer_count].op = opChar;
                             buffer_count++;
 
                             if (buffer_count == BATCH_SIZE)
                             {
-                                #pragma omp critical(bdd_access)
-                                {
-                                    for (int b = 0; b<buffer_count; b++)
-                                    {
-                                        #pragma omp flush(stop)
-                                        if(stop){
-                                            Cudd_RecursiveDeref(manager, buffer[b].bdd);
-                                            continue;
-                                        }
-                                    if (st_insert(uniqueCheck, (char *)buffer[b].bdd, (char *)buffer[b].bdd) == 0) {
-                                        
-                                        Function *newFunction = opNode((buffer[b].op == '*') ? AND : OR, buffer[b].f1, buffer[b].f2, buffer[b].bdd);
-                                
-                                        addFunctionToDynamicArray(newFunction, &newFunctions, &newFuncCount, &newFuncCapacity);
-                                    } else {
-
-                                        Cudd_RecursiveDeref(manager, buffer[b].bdd);
-                                    }
-                                }
+                                flushCombinationBuffer(manager, buffer, buffer_count, uniqueCheck, part, &cancel);
+                                buffer_count = 0; // Reseta o buffer
                             }
-                            buffer_count = 0; // Reseta o buffer
-                        }
                     }
                 }
             } // Fim do loop for
+                checkpointMarkTile(&progress, i, tile);
+                } // Fim do loop de blocos
+                } // Fim do loop de tarefas
             if (buffer_count > 0) {
-                #pragma omp critical(bdd_access)
-                {
-                    for (int b = 0; b < buffer_count; b++) {
-                        if(stop) {
-                             Cudd_RecursiveDeref(manager, buffer[b].bdd);
-                             continue;
-                        }
-                        if (st_insert(uniqueCheck, (char *)buffer[b].bdd, (char *)buffer[b].bdd) == 0) {
-                            Function *newFunction = opNode((buffer[b].op == '*') ? AND : OR, buffer[b].f1, buffer[b].f2, buffer[b].bdd);
-                            addFunctionToDynamicArray(newFunction, &newFunctions, &newFuncCount, &newFuncCapacity);
-                        } else {
-                            Cudd_RecursiveDeref(manager, buffer[b].bdd);
-                        }
-                    }
-                }
+                flushCombinationBuffer(manager, buffer, buffer_count, uniqueCheck, part, &cancel);
                 buffer_count = 0;
             }
             #pragma omp atomic
@@ -826,38 +1086,42 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
 
             #pragma omp atomic
             global_service_time += local_service_time;
-        } // Fim do parallel region
+            prefilterMerge(&stats);
+        } // Fim do parallel region, a única barreira da ordem
+    for (int i = 0; i < targetOrder; i++) pairSpaceFree(&spaces[i]);
+    free(spaces);
+    workPoolFree(&pool);
+    prefilterReport(targetOrder);
 
-    }
 
-
-            if(stop){
+            if (cancelRaised(&cancel)) {
                 //Limpar o que foi alocado
-                for(int i=0; i<newFuncCount; i++) {
-                    Cudd_RecursiveDeref(manager, newFunctions[i]->bdd);
-                    free(newFunctions[i]);
+                for (int t = 0; t < partCount; t++) {
+                    for (int k = 0; k < parts[t].size; k++) {
+                        if (parts[t].bdd[k]) Cudd_RecursiveDeref(manager, parts[t].bdd[k]);
+                    }
+                    bucketFreeColumns(&parts[t]);
                 }
-                free(newFunctions);
+                free(parts);
+                checkpointEndOrder(&progress);
                 return true;    
             }
 
 
-    targetBucket->order = targetOrder;
-    targetBucket->size = newFuncCount;
-
-    if (newFuncCount > 0) {
-        // Não sei se precisa, mas economiza um pouco de memória
-        targetBucket->functions = newFunctions;
-    } else {
-        free(newFunctions);
-        targetBucket->functions = NULL;
+    // Junta os parciais das threads no bucket da ordem (índices dos pais continuam valendo, só mudam as posições novas)
+    bucketPublish(targetBucket, targetOrder, parts, partCount);
+    free(parts);
+    // Parada pedida no meio da ordem: os blocos marcados terminaram inteiros, e as funções deles estão no bucket
+    if (progress.done != NULL && checkpointStopRequested() && checkpointOrderPending(&progress)) {
+        checkpointSaveAndExit(&progress, buckets, targetBucket);
     }
-    //printBucket(manager, *targetBucket, 0);
+    checkpointEndOrder(&progress);
+    //printBucket(manager, buckets, targetOrder, 0);
     // Verifica array final se a opção não era saída imediata
-    for (int i = 0; i < newFuncCount; i++) {
-        if (newFunctions[i]->bdd == objectiveExp) {
+    for (int i = 0; i < targetBucket->size; i++) {
+        if (bucketIsObjective(targetBucket, i, objectiveExp)) {
             printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
-            printFunction(newFunctions[i]);
+            printBucketFunction(buckets, targetOrder, bucketObjectiveRef(targetBucket, i, objectiveExp));
             printf("\n");
             printf("No de literais: %d\n", targetOrder);
             return true;
@@ -868,24 +1132,223 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
     return false;
 }
 
-Function* varNode(char varName, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = VAR; // variável
-    node->varName = varName;
-    node->left = NULL;
-    node->right = NULL;
-    return node;
+ManagerReplicas *replicasCreate(DdManager *manager, int threads, int varCount, int numBuckets, DdNode *objectiveExp)
+{
+    ManagerReplicas *r = (ManagerReplicas *)calloc(1, sizeof(ManagerReplicas));
+    if (r == NULL) exit(EXIT_FAILURE);
+    r->threads = threads;
+    r->numBuckets = numBuckets;
+    r->managers = (DdManager **)calloc(threads, sizeof(DdManager *));
+    r->objective = (DdNode **)calloc(threads, sizeof(DdNode *));
+    r->seen = (SeenSet **)calloc(threads, sizeof(SeenSet *));
+    r->nodes = (DdNode ***)calloc(numBuckets, sizeof(DdNode **));
+    if (r->managers == NULL || r->objective == NULL || r->seen == NULL || r->nodes == NULL) exit(EXIT_FAILURE);
+
+    for (int t = 0; t < threads; t++) {
+        // Mesmas variáveis, com os mesmos índices, para o transfer mapear um para um
+        r->managers[t] = Cudd_Init(varCount, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
+        r->seen[t] = seenSetCreate(false, varCount);
+        if (r->managers[t] == NULL || r->seen[t] == NULL) {
+            fprintf(stderr, "Erro ao criar o manager da thread %d\n", t);
+            exit(EXIT_FAILURE);
+        }
+        r->objective[t] = Cudd_bddTransfer(manager, r->managers[t], objectiveExp);
+        Cudd_Ref(r->objective[t]);
+    }
+    return r;
+}
+
+// Copia o bucket b para todos os managers. O manager principal só é lido aqui, então cada thread copia o seu em paralelo
+void replicasAddBucket(DdManager *manager, ManagerReplicas *r, Bucket *bucket, int b)
+{
+    int size = bucket->size;
+    r->nodes[b] = (DdNode **)malloc((size_t)r->threads * (size > 0 ? size : 1) * sizeof(DdNode *));
+    if (r->nodes[b] == NULL) exit(EXIT_FAILURE);
+
+    #pragma omp parallel for num_threads(r->threads) schedule(static, 1)
+    for (int t = 0; t < r->threads; t++) {
+        for (int k = 0; k < size; k++) {
+            DdNode *local = Cudd_bddTransfer(manager, r->managers[t], bucket->bdd[k]);
+            Cudd_Ref(local);
+            r->nodes[b][(size_t)t * size + k] = local;
+            seenSetInsert(r->seen[t], (uint64_t)(uintptr_t)local);
+        }
+    }
+}
+
+void replicasFree(ManagerReplicas *r, Bucket *buckets)
+{
+    for (int t = 0; t < r->threads; t++) {
+        for (int b = 0; b < r->numBuckets; b++) {
+            if (r->nodes[b] == NULL) continue;
+            for (int k = 0; k < buckets[b].size; k++) {
+                Cudd_RecursiveDeref(r->managers[t], r->nodes[b][(size_t)t * buckets[b].size + k]);
+            }
+        }
+        Cudd_RecursiveDeref(r->managers[t], r->objective[t]);
+        seenSetFree(r->seen[t]);
+        Cudd_Quit(r->managers[t]);
+    }
+    for (int b = 0; b < r->numBuckets; b++) free(r->nodes[b]);
+    free(r->nodes);
+    free(r->seen);
+    free(r->objective);
+    free(r->managers);
+    free(r);
 }
 
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = operador; // 1 p/ not, 2 p/ and, 3 p/ or
-    node->varName = '\0'; // não usado para operadores
-    node->left = left;
-    node->right = right;
-    return node;
+// Mesma enumeração do createCombinedBucket, mas cada thread combina no seu manager, sem trava nenhuma
+bool createCombinedBucketReplicated(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice)
+{
+    Bucket *targetBucket = &buckets[targetOrder - 1];
+    ManagerReplicas *r = replicas;
+    // Funções novas de cada thread, ainda no manager dela (a coluna bdd guarda o nó local)
+    Bucket *locals = (Bucket *)calloc(r->threads, sizeof(Bucket));
+    // Os espaços de pares e as tarefas são compartilhados pelas threads, então nascem antes da região paralela
+    PairSpace *spaces = (PairSpace *)calloc(targetOrder, sizeof(PairSpace));
+    if (locals == NULL || spaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < targetOrder - 1; i++) {
+        int j = targetOrder - (i + 1) - 1;
+        if (j < i) break;
+        if (buckets[i].size > 0 && buckets[j].size > 0) pairSpaceInit(&spaces[i], buckets[i].size, buckets[j].size, i == j, r->threads);
+    }
+    WorkPool pool;
+    workPoolInit(&pool, spaces, targetOrder - 1, r->threads);
+    CancelToken cancel;
+    cancelInit(&cancel);
+
+    #pragma omp parallel num_threads(r->threads)
+    {
+        int t = omp_get_thread_num();
+        DdManager *local = r->managers[t];
+        Bucket *mine = &locals[t];
+        SeenSet *orderSeen = seenSetCreate(false, 0);
+        if (orderSeen == NULL) exit(EXIT_FAILURE);
+        double local_service_time = 0.0;
+        PrefilterStats stats = {0, 0, 0, 0, 0, 0};
+        int polarities = foldComplements ? 2 : 1;
+
+        // Tarefas de todos os pares nos deques, com roubo entre as threads
+        for (int task = workPoolNext(&pool, t); task >= 0 && !cancelRaised(&cancel); task = workPoolNext(&pool, t))
+        {
+            int i = pool.tasks[task].pair;
+            int j = targetOrder - (i + 1) - 1;
+            Bucket *b1 = &buckets[i];
+            Bucket *b2 = &buckets[j];
+            DdNode **n1 = &r->nodes[i][(size_t)t * b1->size];
+            DdNode **n2 = &r->nodes[j][(size_t)t * b2->size];
+
+            PairSpace *space = &spaces[i];
+            int c = pool.tasks[task].chunk;
+            for (int tile = space->chunkStart[c]; tile < space->chunkStart[c + 1] && !cancelRaised(&cancel); tile++)
+            for (int k = space->tiles[tile].kBegin; k < space->tiles[tile].kEnd; k++)
+            {
+                for (int l = pairTileFirstCol(space, &space->tiles[tile], k); l < space->tiles[tile].lEnd && !cancelRaised(&cancel); l++)
+                for (int pol = 0; pol < polarities; pol++)
+                {
+                    DdNode *right = Cudd_NotCond(n2[l], pol);
+                    uint32_t rightRef = (uint32_t)l | (pol ? BUCKET_NEGATED : 0);
+
+                    Signature leftSig, rightSig;
+                    int ops = prefilterBdd(local, n1[k], right, bucketRefSig(b1, (uint32_t)k, &leftSig), bucketRefSig(b2, rightRef, &rightSig), &stats);
+                    for (int op = 0; op < 2; op++)
+                    {
+                        if (!(ops & ((op == 0) ? PREFILTER_AND : PREFILTER_OR))) continue;
+                        char opChar = (op == 0) ? '*' : '+';
+                        double t_start = omp_get_wtime();
+                        DdNode *newBdd = combineBdds(local, n1[k], right, opChar);
+                        local_service_time += omp_get_wtime() - t_start;
+                        if (newBdd == NULL) continue;
+
+                        if (newBdd == Cudd_ReadLogicZero(local) || newBdd == Cudd_ReadOne(local)) {
+                            Cudd_RecursiveDeref(local, newBdd);
+                            continue;
+                        }
+
+                        bool negHit = foldComplements && newBdd == Cudd_Not(r->objective[t]);
+                        if ((newBdd == r->objective[t] || negHit) && choice == 'e')
+                        {
+                            OpType hitOp = (opChar == '*') ? AND : OR;
+                            uint32_t left = (uint32_t)k, hitRight = rightRef;
+                            if (negHit) bucketDualize(&hitOp, &left, &hitRight);
+                            if (cancelRaise(&cancel))
+                            {
+                                printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+                                printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+
+                                printf("RESULTADO_EXPRESSAO: ");
+                                printBucketCombination(buckets, hitOp, i + 1, left, j + 1, hitRight);
+                                printf("\n");
+                            }
+                            Cudd_RecursiveDeref(local, newBdd);
+                            continue;
+                        }
+
+                        // As funções antigas já estão no manager da thread, então repetidas caem aqui sem sair dela.
+                        // As novas ficam num conjunto só desta ordem: os nós que o merge recusar são liberados e o ponteiro pode voltar
+                        // Com a dobra a chave é o nó regular, o mesmo que o merge vai achar depois do transfer
+                        DdNode *canonical = foldComplements ? bucketCanonicalBdd(newBdd) : newBdd;
+                        uint64_t key = (uint64_t)(uintptr_t)canonical;
+                        if (!seenSetContains(r->seen[t], key) && seenSetInsert(orderSeen, key)) {
+                            bucketAppendFolded(mine, 0, canonical, canonical != newBdd, (opChar == '*') ? AND : OR, i + 1, (uint32_t)k, rightRef);
+                        } else {
+                            Cudd_RecursiveDeref(local, newBdd);
+                        }
+                    }
+                }
+            }
+        }
+
+        seenSetFree(orderSeen);
+        prefilterMerge(&stats);
+        #pragma omp atomic
+        global_service_time += local_service_time;
+        #pragma omp atomic
+        global_total_time += local_service_time;
+    }
+
+    // Junta as funções de todas as threads no manager principal. A chave volta a ser o ponteiro do nó transferido
+    targetBucket->order = targetOrder;
+    for (int t = 0; t < r->threads; t++) {
+        Bucket *mine = &locals[t];
+        for (int k = 0; k < mine->size; k++) {
+            if (!cancelRaised(&cancel)) {
+                DdNode *mainBdd = Cudd_bddTransfer(r->managers[t], manager, mine->bdd[k]);
+                Cudd_Ref(mainBdd);
+                DdNode *canonical = foldComplements ? bucketCanonicalBdd(mainBdd) : mainBdd;
+                if (seenSetInsert(uniqueCheck, (uint64_t)(uintptr_t)canonical)) {
+                    bucketAppendFolded(targetBucket, 0, canonical, canonical != mainBdd, (OpType)mine->op[k], mine->leftOrder[k], mine->left[k], mine->right[k]);
+                } else {
+                    Cudd_RecursiveDeref(manager, mainBdd);
+                }
+            }
+            // A réplica definitiva vem do replicasAddBucket, que transfere de novo a partir do manager principal
+            Cudd_RecursiveDeref(r->managers[t], mine->bdd[k]);
+        }
+        bucketFreeColumns(mine);
+    }
+    free(locals);
+    for (int i = 0; i < targetOrder; i++) pairSpaceFree(&spaces[i]);
+    free(spaces);
+    workPoolFree(&pool);
+
+    if (cancelRaised(&cancel)) {
+        for (int i = 0; i < targetBucket->size; i++) Cudd_RecursiveDeref(manager, targetBucket->bdd[i]);
+        bucketFreeColumns(targetBucket);
+        return true;
+    }
+
+    // Verifica array final se a opção não era saída imediata
+    for (int i = 0; i < targetBucket->size; i++) {
+        if (bucketIsObjective(targetBucket, i, objectiveExp)) {
+            printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+            printBucketFunction(buckets, targetOrder, bucketObjectiveRef(targetBucket, i, objectiveExp));
+            printf("\n");
+            printf("No de literais: %d\n", targetOrder);
+            return true;
+        }
+    }
+    return false;
 }
 
 void printFunction(Function* node) {
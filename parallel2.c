@@ -2,63 +2,127 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <cudd.h>
+#include "bdd.h"
 #include <st.h>
 #include <time.h>
 #include <omp.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "litdb.h"
+#include "goalcheck.h"
+#include "topdown.h"
+#include "batch.h"
+#include "ring.h"
+#include "cancel.h"
+#include "pairspace.h"
+#include "ttkernel.h"
+#include "prefilter.h"
+#include "npncache.h"
+#include "dsd.h"
+#include "bounds.h"
+#include "snapshot.h"
+#include "checkpoint.h"
 
 double global_total_time = 0.0;   // Tempo Fora (Espera + Serviço)
 double global_service_time = 0.0;
 #define PARALLEL_MIN_COMBINATIONS 3000
 #define BATCH_SIZE 2048
-#define QUEUE_SIZE 100000
-
-typedef enum{
-    VAR,
-    NOT,
-    AND,
-    OR
-} OpType;
-
-typedef struct Function
-{
-    DdNode *bdd;
-    struct Function *left;
-    struct Function *right;
-    OpType operador;
-    char varName; //Apenas se operador == VAR
-} Function;
-
-typedef struct
-{
-    Function **functions;
-    int order;
-    int size;
-} Bucket;
-
-typedef struct {
-    Function *f1;
-    Function *f2;
-    DdNode *bdd;
-    char op;
-} CombinationBuffer;
+// Memória máxima em lotes circulando entre produtores e combinadores (~1900 lotes de 35 KB), e o mesmo para os resultados
+#define TASK_POOL_BYTES ((size_t)64 << 20)
+#define RESULT_POOL_BYTES ((size_t)64 << 20)
+#define PIPELINE_MAX_SHARDS 16
+// Profundidade média da fila (em lotes) que faz o estágio seguinte ganhar (funda) ou perder (rasa) uma thread na próxima ordem
+#define PIPELINE_DEEP_BATCHES 8.0
+#define PIPELINE_SHALLOW_BATCHES 1.0
+
+// Backend por tabela verdade: os combinadores deixam de chamar o CUDD para cada par
+bool useTruthTable = false;
+TruthTable objectiveTt = 0;
+TruthTable fullTt = 0;
+// Dobra de complementos (bucket.h): ligada quando o bucket 1 fecha por complemento
+bool foldComplements = false;
 
 typedef struct {
-    Function *f1[BATCH_SIZE];
-    Function *f2[BATCH_SIZE];
+    // Posições dos operandos nos buckets: o esquerdo está no bucket leftOrder, o direito no complementar
+    // (com BUCKET_NEGATED quando a dobra combina com o complemento dele)
+    uint32_t left[BATCH_SIZE];
+    uint32_t right[BATCH_SIZE];
+    uint8_t leftOrder[BATCH_SIZE];
     char op[BATCH_SIZE];
     int count; // Quantos itens validos neste batch
 } TaskBatch;
 
+// Os lotes passam por ponteiro: "ready" leva os cheios para os combinadores e "pool" devolve os vazios para reuso.
+// Os lotes só são alocados quando o pool está vazio, até o limite de TASK_POOL_BYTES; daí o produtor espera um voltar.
 typedef struct {
-    TaskBatch batches[QUEUE_SIZE];
-    int head;
-    int tail;
-    int count;
-    omp_lock_t lock;
-    bool finished; // Flag para indicar que os produtores acabaram
+    BatchRing ready;
+    BatchRing pool;
+    _Atomic size_t allocated;
+    size_t maxBatches;
 } TaskQueue;
 
+// Combinação já feita, indo do combinador para o shard dono da chave. A chave é a tabela verdade ou o nó canônico
+// (com a referência do combinador); complemented diz que a função gerada é o complemento da chave
+typedef struct {
+    uint64_t key[BATCH_SIZE];
+    uint32_t left[BATCH_SIZE];
+    uint32_t right[BATCH_SIZE];
+    uint8_t leftOrder[BATCH_SIZE];
+    uint8_t complemented[BATCH_SIZE];
+    char op[BATCH_SIZE];
+    int count;
+} ResultBatch;
+
+// Uma fila por shard, todas alimentadas por todos os combinadores, e um pool de lotes vazios comum
+typedef struct {
+    BatchRing shards[PIPELINE_MAX_SHARDS];
+    int shardCount;
+    BatchRing pool;
+    _Atomic size_t allocated;
+    size_t maxBatches;
+} ResultQueue;
+
+/* Pipeline de três estágios: produtores geram os pares (e, na tabela verdade, já passam o kernel vetorial),
+combinadores fazem o AND/OR e separam os resultados pelo hash da chave, e cada shard deduplica só as chaves que caem nele.
+Como uma chave sempre vai para o mesmo shard, duas threads nunca disputam a mesma chave no conjunto de duplicatas, e o bucket
+parcial de cada shard é só dele. Os estados de avaliação dos combinadores (tabela verdade, memória do pré-filtro) são privados.
+As larguras valem para a ordem inteira e são ajustadas entre uma ordem e outra pela profundidade média das filas. */
+typedef struct {
+    int threads; //Time para o qual as larguras foram calculadas (0 = ainda não calculadas)
+    int producers;
+    int combiners; //Com zero o produtor combina o próprio lote
+    int shards; //Com zero (uma thread só) o combinador deduplica direto
+} PipelineWidths;
+
+static PipelineWidths pipelineWidths = {0, 0, 0, 0};
+
+// Estado de uma ordem, compartilhado pelos três estágios
+typedef struct {
+    DdManager *manager;
+    Bucket *buckets;
+    int targetOrder;
+    DdNode *objectiveExp;
+    SeenSet *uniqueCheck;
+    char choice;
+    CancelToken *cancel;
+    TaskQueue *tasks;
+    ResultQueue *results;
+    Bucket *parts; //Bucket parcial de cada shard
+    bool inlineDedup; //Sem threads de shard: o combinador deduplica direto
+    _Atomic uint64_t readyDepthSum, readySamples;
+    _Atomic uint64_t shardDepthSum, shardSamples;
+} Pipeline;
+
+// Estado privado de um combinador: um lote aberto por shard e a memória do pré-filtro do BDD
+typedef struct {
+    ResultBatch *open[PIPELINE_MAX_SHARDS];
+    PrefilterStats stats;
+    int lastOrder;
+    uint32_t lastLeft, lastRight;
+    int lastOps;
+    double serviceTime;
+} Combiner;
+
 
 
 // Protótipos para funções úteis
@@ -66,7 +130,7 @@ typedef struct {
 // Função para adicionar um novo bucket
 Bucket *addBucket(Bucket *buckets, int *numBuckets);
 // Imprimir o bucket para fins de debug
-void printBucket(DdManager *manager, Bucket bucket, int varCount);
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount);
 // Função para liberar memória alocada
 // void freeAll(Bucket *buckets, int numBuckets);
 void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets);
@@ -79,23 +143,36 @@ DdNode *evaluatePostfix(DdManager *manager, char **postfix, int count, Function
 // Analisa a expressão infixada de entrada, converte para pós-fixada, e retorna o BDD resultante
 DdNode *parseInputExpression(DdManager *manager, const char *input, Function **outVarMap, int *outVarCount, int *literalCount);
 // Gera o bucket 1 com base no varMap retornado por parseInputExpression
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck);
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck);
 // Combina dois BDDs com AND, OR ou NOT -> gera todos os SOP'S e POS'S
 DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operator);
 // Função para criar um novo bucket de ordem l realizando todas as combinações possíveis entre todos os buckets de ordem n + m = l
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice);
-// Criar um novo nó caso seja variável
-Function* varNode(char varName, DdNode *bdd);
-//Criar um novo nó caso seja operador
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd);
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
 //Printar a implementação
 void printFunction(Function* node);
 //Para log
 //void fprintFunction(FILE *f, Function* node);
 //void logExpressionToFile(Function *node, int ordem);
-void initQueue(TaskQueue *q);
+bool initQueue(TaskQueue *q);
+void destroyQueue(TaskQueue *q);
+TaskBatch *acquireBatch(TaskQueue *q);
+void releaseBatch(TaskQueue *q, TaskBatch *t);
 void enqueue(TaskQueue *q, TaskBatch *t);
-bool dequeue(TaskQueue *q, TaskBatch *t);
+TaskBatch *dequeue(TaskQueue *q);
+void *acquireFromPool(BatchRing *pool, _Atomic size_t *allocated, size_t maxBatches, size_t batchBytes);
+bool initResultQueue(ResultQueue *q, int shardCount);
+void destroyResultQueue(ResultQueue *q);
+ResultBatch *acquireResult(ResultQueue *q);
+void releaseResult(ResultQueue *q, ResultBatch *r);
+// Larguras iniciais dos estágios para um time de threads, e o ajuste pela profundidade medida na ordem que acabou
+void pipelineDefaultWidths(PipelineWidths *w, int threads);
+void pipelineAdapt(PipelineWidths *w, double readyDepth, double shardDepth);
+// Estágio 2: combina um lote de pares e manda os resultados para os shards
+void pipelineCombine(Pipeline *p, Combiner *c, TaskBatch *task);
+// Manda os lotes abertos do combinador (ou deduplica direto, sem shards)
+void pipelineFlushResults(Pipeline *p, Combiner *c, int shard);
+// Estágio 3: deduplica um lote de resultados no shard dono
+void pipelineDedup(Pipeline *p, int shard, ResultBatch *r);
 
 int main(int argc, char *argv[])
 {
@@ -104,8 +181,10 @@ int main(int argc, char *argv[])
     //A princípio toda a primeira parte da execução é sequencial, paralelizar iria gerar overhead desnecessário
     if (argc < 3)
     {
-        fprintf(stderr, "Uso: %s <expressão> <modo>\n", argv[0]);
-        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n");
+        fprintf(stderr, "Uso: %s <expressão> <modo> [tabela] [--resume]\n", argv[0]);
+        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n d - consultar a tabela pré-computada (até 4 variáveis, padrão %s)\n t - busca top-down a partir do objetivo (até %d variáveis)\n", LITDB_DEFAULT_PATH, TT_MAX_VARS);
+        fprintf(stderr, "Para vários alvos (um por linha): %s --batch <arquivo>\n", argv[0]);
+        fprintf(stderr, "Cache NPN e snapshots entre execuções (desligados por padrão): %s=<pasta> [%s=<MB>]\n", CACHE_DIR_ENV, CACHE_DIR_MAX_ENV);
         return EXIT_FAILURE;
     }
 
@@ -119,20 +198,24 @@ int main(int argc, char *argv[])
     //Por estabilidade no paralelismo, desabilitar autodyn
     Cudd_AutodynDisable(manager);
 
-    st_table *uniqueCheck = st_init_table(st_ptrcmp, st_ptrhash);
-    if (uniqueCheck == NULL)
-    {
-        fprintf(stderr, "Erro ao criar tabela hash ST\n");
+    
+    if (strcmp(argv[1], "--batch") == 0) {
+        int status = runBatch(manager, argv[2]);
         Cudd_Quit(manager);
-        return EXIT_FAILURE;
+        return status;
     }
-    
+
     char choice = argv[2][0];
 
-    if (choice != 'e' && choice != 'c') {
-        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e' ou 'c'.\n", choice);
+    if (choice != 'e' && choice != 'c' && choice != 'd' && choice != 't') {
+        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e', 'c', 'd' ou 't'.\n", choice);
         return EXIT_FAILURE;
     }
+    // --resume: continua do checkpoint de uma execução interrompida (checkpoint.h)
+    bool resume = false;
+    for (int a = 3; a < argc; a++) {
+        if (strcmp(argv[a], "--resume") == 0) resume = true;
+    }
 
     int numBuckets = 0;
     bool found = false;
@@ -147,14 +230,12 @@ int main(int argc, char *argv[])
     if (objectiveExp == NULL)
     {
         fprintf(stderr, "Erro ao parsear a expressão.\n");
-        st_free_table(uniqueCheck);
         Cudd_Quit(manager);
         return EXIT_FAILURE;
     }
     //Esqueci que tautologias e contradições existem, então adicionei só agora kkkkk
     if(objectiveExp == Cudd_ReadLogicZero(manager)) {
         printf("A expressão é uma contradição (Sempre falsa).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
@@ -162,55 +243,179 @@ int main(int argc, char *argv[])
     }
     if(objectiveExp == Cudd_ReadOne(manager)) {
         printf("A expressão é uma tautologia (Sempre verdadeira).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
         return EXIT_SUCCESS;
     }
     Cudd_PrintDebug(manager, objectiveExp, varCount, 2);
+
+    // Com poucas variáveis o CUDD só serve para o parse, o resto roda sobre tabelas verdade
+    if (varCount <= TT_MAX_VARS) {
+        useTruthTable = true;
+        fullTt = ttFullMask(varCount);
+        objectiveTt = bddToTruthTable(manager, objectiveExp, varCount);
+        printf("Backend: tabela verdade (%d variáveis)\n", varCount);
+    }
+
+    // Modo d: a resposta já está na tabela, não precisa de bucket nenhum
+    if (choice == 'd') {
+        int status = litDbQuery(argc > 3 ? argv[3] : LITDB_DEFAULT_PATH, objectiveTt, varCount, varMap);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return status;
+    }
+    if (choice == 't' && !useTruthTable) {
+        fprintf(stderr, "Erro: o modo t só funciona com até %d variáveis (objetivo tem %d).\n", TT_MAX_VARS, varCount);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+
+    // Cache NPN: objetivo equivalente a um já resolvido (a menos de permutação e negações) não passa pela busca
+    NpnCache npnCache;
+    char varNames[TT_MAX_VARS + 1] = {0};
+    bool npnActive = npnCacheActive() && useTruthTable && (choice == 'e' || choice == 'c');
+    if (npnActive) {
+        for (int i = 0; i < varCount; i++) varNames[i] = varMap[i].varName;
+        npnCacheLoad(&npnCache, NPN_CACHE_DEFAULT_PATH);
+        if (npnCacheReport(&npnCache, objectiveTt, varCount, varNames)) {
+            npnCacheFree(&npnCache);
+            Cudd_RecursiveDeref(manager, objectiveExp);
+            for (int i = 0; i < varCount; i++) {
+                if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+            }
+            free(varMap);
+            Cudd_Quit(manager);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    // Decomposição disjunta: objetivo que quebra em blocos de variáveis separadas é resolvido bloco a bloco
+    if ((choice == 'e' || choice == 'c') && dsdReport(manager, objectiveExp, varMap, varCount, literalCount, npnActive ? &npnCache : NULL)) {
+        if (npnActive) npnCacheFree(&npnCache);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_SUCCESS;
+    }
+
+    //Conjunto de duplicatas, depende do backend escolhido acima
+    SeenSet *uniqueCheck = seenSetCreate(useTruthTable, varCount);
+    if (uniqueCheck == NULL)
+    {
+        fprintf(stderr, "Erro ao criar o conjunto de duplicatas\n");
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+    printf("Dedup: %s\n", seenSetDescription(uniqueCheck));
+    if (useTruthTable) printf("Kernel: %s\n", ttCombineKernelName());
+    else {
+        // Fora do alcance da tabela verdade: assinaturas por simulação para evitar testes exatos no BDD
+        sigInit(manager, objectiveExp, varCount);
+        printf("Assinaturas: %d vetores de simulação\n", SIG_BITS);
+    }
     
      //Iniciar aqui para levar em conta apenas o algoritmo
     double start_time = omp_get_wtime();
     clock_t start_clock = clock();
 
     // Inicializa o bucket 1
+    // Limites da busca: abaixo do inferior não existe fórmula e a incumbente já é uma resposta com upper literais
+    int searchLimit = literalCount;
+    Bounds bounds = {0, 0, "", false};
+    BucketSnapshot snapshot = {0};
+    if (choice == 'e' || choice == 'c') {
+        boundsCompute(manager, objectiveExp, varMap, varCount, argv[1], literalCount, &bounds);
+        if (bounds.upper > 0) searchLimit = bounds.upper - 1;
+    }
+
     buckets = addBucket(buckets, &numBuckets);
-    initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    if (bounds.upper > 0 && bounds.lower >= bounds.upper) {
+        // Os limites se encontraram: nenhum bucket precisa ser montado
+        if (npnActive) bucketEchoBegin();
+        boundsReportIncumbent(&bounds);
+        found = true;
+    } else {
+        initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    }
+    if (!found && choice != 't') {
+        foldComplements = bucketFoldLiterals(manager, &buckets[0]);
+        if (foldComplements) printf("Dobra de complementos: ativa (%d representantes no bucket 1)\n", buckets[0].size);
+    }
     if (!found) {
 
-    printBucket(manager, buckets[0], varCount);
+    printBucket(manager, buckets, 1, varCount);
+    if (npnActive) bucketEchoBegin(); // A expressão do resultado vai para o cache NPN
 
     // Inicializa todos os buckets que poderão ser usados nesta execução do programa
-    while (numBuckets < literalCount)
+    while (numBuckets < searchLimit)
     {
         buckets = addBucket(buckets, &numBuckets);
     }
-    for (int order = 2; order <= literalCount; order++)
+    // Ordens que já estão no snapshot deste bucket 1 (snapshot.h) não são montadas de novo
+    bool snapshotActive = BUCKET_SNAPSHOT_ENABLED && cacheDir() != NULL && useTruthTable && (choice == 'e' || choice == 'c');
+    if (snapshotActive) bucketSnapshotOpen(&snapshot, buckets, numBuckets, varCount, uniqueCheck);
+    if (snapshotActive) checkpointInit(&snapshot, buckets, resume);
+    else if (resume) fprintf(stderr, "--resume ignorado: checkpoint só existe com %s, a tabela verdade e os modos e e c\n", CACHE_DIR_ENV);
+    if (choice == 't') {
+        // Motor top-down: só monta os buckets até a metade do orçamento
+        found = topDownSearch(manager, buckets, numBuckets, varCount, objectiveExp, uniqueCheck, true);
+    }
+    for (int order = 2; order <= searchLimit && choice != 't'; order++)
     {
         //Aqui começa a parte paralela
         //Dentro da função, quero que cada thread trate de combinar buckets diferentes
         found = createCombinedBucket(manager, buckets, numBuckets, order, objectiveExp, uniqueCheck, choice);
         if (found) break; // Sai do loop se encontrou a equivalência
+        if (snapshotActive) {
+            bucketSnapshotSave(&snapshot, buckets, order);
+            checkpointOrderPublished(order);
+            if (checkpointStopRequested() && order < searchLimit) checkpointExitAfterOrder(order);
+        }
         //printBucket(manager, buckets[order - 1], varCount);
         
     }
+    if (!found && bounds.upper > 0) {
+        // Nada com menos literais que a incumbente
+        boundsReportIncumbent(&bounds);
+        found = true;
+    }
     }
     if (!found) {
-        printf("Nenhuma equivalência encontrada até a ordem %d.\n", literalCount);
+        printf("Nenhuma equivalência encontrada até a ordem %d.\n", searchLimit);
     }
     
     //Acaba aqui, liberar a memória não faz parte do algoritmo
     double end_time = omp_get_wtime();
     clock_t end_clock = clock();
+    if (npnActive) {
+        const char *resultExpression = bucketEchoEnd();
+        if (found && !bounds.reported) npnCacheRecord(&npnCache, objectiveTt, varCount, varNames, resultExpression);
+        npnCacheFree(&npnCache);
+    }
 
     // Após o uso, libera a hash
     // Vou ter que rever todos os frees mais pra frente
-    st_free_table(uniqueCheck);
+    seenSetFree(uniqueCheck);
+    sigFree();
 
  
     Cudd_RecursiveDeref(manager, objectiveExp);
     freeAllBuckets(manager, buckets, numBuckets);
+    checkpointFinish();
+    bucketSnapshotClose(&snapshot);
 
     if (varMap != NULL) {
         for (int i = 0; i < varCount; i++) {
@@ -242,17 +447,16 @@ Bucket *addBucket(Bucket *buckets, int *numBuckets)
         fprintf(stderr, "Erro ao realocar memória para buckets.\n");
         exit(EXIT_FAILURE);
     }
-    buckets[(*numBuckets) - 1].order = 0;
-    buckets[(*numBuckets) - 1].functions = NULL;
-    buckets[(*numBuckets) - 1].size = 0;
+    memset(&buckets[(*numBuckets) - 1], 0, sizeof(Bucket));
     return buckets;
 }
 
-void printBucket(DdManager *manager, Bucket bucket, int varCount)
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount)
 {
     (void)manager;
     (void)varCount;
-    (void)bucket;
+    (void)buckets;
+    (void)order;
     // Função mantida vazia para evitar prints de debug
 }
 
@@ -262,27 +466,16 @@ void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets)
         return;
     for (int i = 0; i < numBuckets; i++)
     {
-        if (buckets[i].functions != NULL)
+        if (buckets[i].bdd != NULL)
         {
-            // Dereferencia todas as funções no bucket
+            // Dereferencia todas as funções no bucket (não existem no backend por tabela verdade)
             for (int j = 0; j < buckets[i].size; j++)
             {
-                if (buckets[i].functions[j] != NULL)
-                {
-                    //Deferecia o BDD
-                    Cudd_RecursiveDeref(manager, buckets[i].functions[j]->bdd);
-                    
-                    //Libera o nó de implementação
-                    //Primeiro verifica se é NOT. Se sim, libera o filho esquerdo antes
-                    if (buckets[i].functions[j]->bdd) 
-                    Cudd_RecursiveDeref(manager, buckets[i].functions[j]->bdd);
-
-                    //Libera a struct
-                    free(buckets[i].functions[j]);
-                }
+                Cudd_RecursiveDeref(manager, buckets[i].bdd[j]);
             }
-            free(buckets[i].functions); // Libera o array de ponteiros
         }
+        bucketFreeColumns(&buckets[i]); // Libera as colunas
+        goalIndexFree(manager, &buckets[i].goal);
     }
     free(buckets); // Libera o array de buckets
 }
@@ -488,53 +681,69 @@ DdNode *parseInputExpression(DdManager *manager, const char *input, Function **o
 }
 
 
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck)
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck)
 {
     printf("Inicializando o primeiro bucket...\n");
     bucket->order = 1;
-    bucket->functions = (Function **)malloc(((varCount * 2) + 1) * sizeof(Function *));
-    if (bucket->functions == NULL) exit(EXIT_FAILURE);
+    bucketReserve(bucket, varCount * 2);
 
     int actualSize = 0;
     
     for (int i = 0; i < varCount; i++)
     {
-        DdNode *varBdd = varMap[i].bdd;
+        bool isPosUnate, isNegUnate;
+
+        if (useTruthTable) {
+            // Mesma análise, mas com os cofatores tirados direto da tabela verdade
+            TruthTable cofPos = ttCofactor(objectiveTt, i, true, varCount);
+            TruthTable cofNeg = ttCofactor(objectiveTt, i, false, varCount);
+
+            // Verifica Dependência
+            if (cofPos == cofNeg) continue;
+
+            isPosUnate = ttLeq(cofNeg, cofPos);
+            isNegUnate = ttLeq(cofPos, cofNeg);
+        } else {
+            DdNode *varBdd = varMap[i].bdd;
+
+            // Calcula Cofatores: f(x=1) e f(x=0)
+            DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
+            Cudd_Ref(cofPos);
+            DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
+            Cudd_Ref(cofNeg);
+
+            // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
+            if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
+                Cudd_RecursiveDeref(manager, cofPos);
+                Cudd_RecursiveDeref(manager, cofNeg);
+                continue; 
+            }
 
+            // Verifica Unicidade
+            isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
+            isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
 
-        // Calcula Cofatores: f(x=1) e f(x=0)
-        DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
-        Cudd_Ref(cofPos);
-        DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
-        Cudd_Ref(cofNeg);
-        
-        // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
-        if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
             Cudd_RecursiveDeref(manager, cofPos);
             Cudd_RecursiveDeref(manager, cofNeg);
-            continue; 
         }
-
-        // Verifica Unicidade
-        bool isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
-        bool isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
         bool isBinate = !isPosUnate && !isNegUnate;
 
-        Cudd_RecursiveDeref(manager, cofPos);
-        Cudd_RecursiveDeref(manager, cofNeg);
-
         // Adiciona se for positivo unate ou binate
         if (isPosUnate || isBinate) {
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função]
-            bucket->functions[actualSize] = varNode(varMap[i].varName, varMap[i].bdd);
+            // Cria a entrada da função
+            if (useTruthTable) {
+                bucketAppendLiteral(bucket, ttVar(i, varCount), NULL, varMap[i].varName, false);
+            } else {
+                Cudd_Ref(varMap[i].bdd);
+                bucketAppendLiteral(bucket, 0, varMap[i].bdd, varMap[i].varName, false);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) {
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) {
                 
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 printf("\n");
                 *found = true;
             }
@@ -543,20 +752,23 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
 
         // Adiciona se for negativo unate ou binate
         if (isNegUnate || isBinate) {
-            // Temporário para o BDD negado
-            DdNode *notBdd = Cudd_Not(varMap[i].bdd);
-            Cudd_Ref(notBdd);
-            Function *varNodePtr = varNode(varMap[i].varName, varMap[i].bdd);
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função
-            bucket->functions[actualSize] = opNode(NOT, varNodePtr, NULL, notBdd);
+            if (useTruthTable) {
+                TruthTable varTt = ttVar(i, varCount);
+                bucketAppendLiteral(bucket, ~varTt & fullTt, NULL, varMap[i].varName, true);
+            } else {
+                // BDD negado
+                DdNode *notBdd = Cudd_Not(varMap[i].bdd);
+                Cudd_Ref(notBdd);
+                // Cria a entrada da função
+                bucketAppendLiteral(bucket, 0, notBdd, varMap[i].varName, true);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) 
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) 
             {
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 printf("\n");
                 *found = true;
             }
@@ -564,7 +776,6 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
         }
     }
 
-    bucket->size = actualSize;
     return NULL;
 }
 
@@ -593,119 +804,118 @@ DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operato
     return result;
 }
 
-// Função para realizar o realloc quando necessário
-void addFunctionToDynamicArray(Function *func, Function ***array, int *count, int *capacity)
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice)
 {
-    if (*count == *capacity)
-    {
-        // Dobra a capacidade (ou inicializa se for 0)
-        *capacity = (*capacity == 0) ? 256 : (*capacity) * 2;
-        *array = (Function **)realloc(*array, (*capacity) * sizeof(Function *));
-        if (*array == NULL)
-        {
-            fprintf(stderr, "Erro ao realocar array dinâmico de BDDs\n");
-            exit(EXIT_FAILURE);
-        }
+    Bucket *targetBucket = &buckets[targetOrder - 1];
+
+    // Assinaturas dos buckets que vão ser combinados (só no backend BDD): o goal check e o pré-filtro consultam
+    bucketSigEnsure(manager, buckets, targetOrder - 1);
+
+    // No modo e o objetivo é procurado por consulta nos buckets menores, e o bucket só é montado se ainda puder alimentar uma ordem maior
+    if (choice == 'e') {
+        if (goalCheckOrder(manager, buckets, targetOrder, objectiveExp)) return true;
+        if (targetOrder >= numBuckets) return false;
     }
-    (*array)[*count] = func;
-    (*count)++;
-}
 
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice)
-{
-    Bucket *targetBucket = &buckets[targetOrder - 1];
-    
-    Function **newFunctions = NULL;
-    int newFuncCount = 0;
-    int newFuncCapacity = 0;
+    // Bucket mapeado do snapshot: já está completo, só falta procurar o objetivo nele (no modo e o goal check já procurou)
+    if (targetBucket->mapped) return bucketSnapshotFindObjective(buckets, targetOrder, objectiveExp);
+
+    // Nenhuma thread combinando agora: o backend próprio pode coletar os nós mortos da ordem anterior
+    if (!useTruthTable) bddSafePoint(manager);
 
-    bool stop = false;
+    // Reserva espaço no conjunto de duplicatas antes de combinar (ninguém está inserindo agora)
+    seenSetReserve(uniqueCheck, predictBucketGrowth(buckets, targetOrder));
+    prefilterBegin();
+    
+    // Quem acha o objetivo levanta o token; os produtores param no próximo bloco ou trecho de linha e o resto das filas é descartado
+    CancelToken cancel;
+    cancelInit(&cancel);
+    // Os shards escrevem nos parciais, que viram o bucket novo no fim da ordem
+    targetBucket->order = targetOrder;
 
     TaskQueue *queue = (TaskQueue *)malloc(sizeof(TaskQueue));
-    initQueue(queue);
+    if (queue == NULL || !initQueue(queue)) {
+        fprintf(stderr, "Erro ao criar a fila de tarefas\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Larguras da ordem anterior, ou as iniciais se o time de threads mudou
+    int threads = omp_get_max_threads();
+    if (pipelineWidths.threads != threads) pipelineDefaultWidths(&pipelineWidths, threads);
+    PipelineWidths widths = pipelineWidths;
+
+    // Um espaço de pares por par de buckets, dividido em pedaços que os produtores pegam por contador atômico
+    // Numa ordem retomada o corte é o de quem gravou o checkpoint
+    int chunkWorkers = checkpointWorkers(targetOrder, threads);
+    PairSpace *spaces = (PairSpace *)calloc(targetOrder, sizeof(PairSpace));
+    if (spaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < targetOrder - 1; i++) {
+        int j = targetOrder - buckets[i].order - 1;
+        if (j < i) break;
+        if (buckets[i].size > 0 && buckets[j].size > 0) pairSpaceInit(&spaces[i], buckets[i].size, buckets[j].size, i == j, chunkWorkers);
+    }
+    CheckpointProgress progress;
 
-    int active_workers;
+    Pipeline p = {manager, buckets, targetOrder, objectiveExp, uniqueCheck, choice, &cancel, queue, NULL, NULL, false};
+    atomic_init(&p.readyDepthSum, 0);
+    atomic_init(&p.readySamples, 0);
+    atomic_init(&p.shardDepthSum, 0);
+    atomic_init(&p.shardSamples, 0);
 
-    #pragma omp parallel
+    #pragma omp parallel num_threads(threads)
     {
         #pragma omp single
-        active_workers = omp_get_num_threads() - 1;
+        {
+            // O runtime pode ter dado menos threads do que o pedido
+            if (omp_get_num_threads() != widths.threads) pipelineDefaultWidths(&widths, omp_get_num_threads());
+            int shardCount = (widths.shards > 0) ? widths.shards : 1;
+            p.results = (ResultQueue *)malloc(sizeof(ResultQueue));
+            p.parts = (Bucket *)calloc(shardCount, sizeof(Bucket));
+            if (p.results == NULL || p.parts == NULL || !initResultQueue(p.results, shardCount)) {
+                fprintf(stderr, "Erro ao criar as filas dos shards\n");
+                exit(EXIT_FAILURE);
+            }
+            p.inlineDedup = widths.shards == 0;
+            // Blocos prontos de uma execução interrompida são pulados e as funções deles já entram no parcial do shard 0
+            checkpointBeginOrder(&progress, targetOrder, spaces, targetOrder - 1, chunkWorkers, &p.parts[0], uniqueCheck);
+            ringSetProducers(&queue->ready, widths.producers);
+            // Todo mundo que não é shard acaba combinando (os produtores quando terminam os pares)
+            for (int s = 0; s < shardCount; s++) ringSetProducers(&p.results->shards[s], widths.producers + widths.combiners);
+        }
 
         int tid = omp_get_thread_num();
-        int numThreads = omp_get_num_threads();
-        
-        if (tid == 0){
-            TaskBatch task;
-            while (true){
-                bool hasWork = dequeue(queue, &task);
-                int current_workers;
-                #pragma omp atomic read
-                current_workers = active_workers;
-
-                if (!hasWork) {
-                    if (current_workers == 0 && queue->count == 0) break; // Tudo processado
-                    continue; // File vazia mas ainda tem produção
-                }
-                if (stop) continue; //Parada ativada, limpa a fila
-
+        Combiner combiner;
+        memset(&combiner, 0, sizeof(combiner));
+        combiner.lastOrder = -1;
+
+        if (tid < widths.shards) {
+            // Estágio 3: o shard tid só recebe as chaves que caem nele. ringPop devolve false quando todos os combinadores terminaram
+            void *item;
+            double local_service_time = 0.0;
+            while (ringPop(&p.results->shards[tid], &item)) {
+                atomic_fetch_add_explicit(&p.shardDepthSum, ringDepth(&p.results->shards[tid]), memory_order_relaxed);
+                atomic_fetch_add_explicit(&p.shardSamples, 1, memory_order_relaxed);
                 double t_svc_start = omp_get_wtime();
-
-                // Loop interno para processar o lote inteiro
-                for (int i = 0; i < task.count; i++) {
-                    if (stop) break; // Checa stop dentro do lote também
-
-                    Function *func1 = task.f1[i];
-                    Function *func2 = task.f2[i];
-                    char op = task.op[i];
-
-       
-                    DdNode *newBdd = combineBdds(manager, func1->bdd, func2->bdd, op);
-                if (newBdd != NULL && newBdd != Cudd_ReadLogicZero(manager) && newBdd != Cudd_ReadOne(manager)) {
-
-                    if (newBdd == objectiveExp && choice == 'e'){
-                        stop = true;
-                        #pragma omp flush(stop)
-                        printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
-                        printf("RESULTADO_LITERAIS: %d\n", targetOrder);
-                            
-                        Function tempNode;
-                        tempNode.operador = (task.op[i] == '*') ? AND : OR;
-                        tempNode.left = task.f1[i];
-                        tempNode.right = task.f2[i];
-                        tempNode.varName = '\0';
-
-                        printf("RESULTADO_EXPRESSAO: ");
-                        printFunction(&tempNode);
-                        printf("\n");
-                    }
-
-                    if (!stop) {
-                        if (st_insert(uniqueCheck, (char *)newBdd, (char *)newBdd) == 0) {
-                                Function *newFunction = opNode((task.op[i] == '*') ? AND : OR, task.f1[i], task.f2[i], newBdd);
-                                addFunctionToDynamicArray(newFunction, &newFunctions, &newFuncCount, &newFuncCapacity);
-                            } else {
-                                Cudd_RecursiveDeref(manager, newBdd);
-                            }
-                    } else {
-                        Cudd_RecursiveDeref(manager, newBdd);
-                    }
-                } else {
-                    if(newBdd) Cudd_RecursiveDeref(manager, newBdd);
+                pipelineDedup(&p, tid, (ResultBatch *)item);
+                local_service_time += omp_get_wtime() - t_svc_start;
+                releaseResult(p.results, (ResultBatch *)item);
             }
-            double t_svc_end = omp_get_wtime();
             #pragma omp atomic
-            global_service_time += (t_svc_end - t_svc_start);
-        }
-    }
-    } else
+            global_service_time += local_service_time;
+        } else
+        {
+    if (tid >= widths.shards + widths.combiners)
     {
-    //Aqui as outras threads, que só fazem as combinações e enfileiram
-    TaskBatch localBatch;
-    localBatch.count = 0;    
+    //Estágio 1: os produtores só geram os pares (na tabela verdade já filtrados pelo kernel) e enfileiram
+    TaskBatch *localBatch = acquireBatch(queue);
+    TtCombineKernel combineKernel = ttCombineKernel();
+    TruthTable andOut[TT_KERNEL_LANES], orOut[TT_KERNEL_LANES], negRight[TT_KERNEL_LANES];
+    TtComboMask mask;
+    PrefilterStats stats = {0, 0, 0, 0, 0, 0};
+    int polarities = foldComplements ? 2 : 1; // Com a dobra, b1[k] também combina com o complemento de b2[l]
     for (int i = 0; i < targetOrder-1; i++)
         {
-            #pragma omp flush(stop)
-            if (stop) break; // Sai do loop se a flag de parada foi ativada na iteração passada
+            if (cancelRaised(&cancel)) break; // Sai do loop se o token foi levantado na iteração passada
 
     
             int order1 = buckets[i].order; 
@@ -718,100 +928,335 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
 
                 if (b1->size == 0 || b2->size == 0) continue;
 
-                //Distribui manualmente o loop
-
-                int worker_count = numThreads - 1;
-                int my_id = tid - 1;
-                
-                for (int k = my_id; k < b1->size; k+= worker_count)
+                // Pedaços de trabalho igual pegos por contador atômico: quem acaba antes pega o próximo
+                PairSpace *space = &spaces[i];
+                int c;
+                // Com o sinal de parada (checkpoint.h) o produtor termina o bloco em que está; as filas esvaziam normalmente
+                while (!cancelRaised(&cancel) && !checkpointStopRequested() && (c = pairSpaceNextChunk(space)) >= 0)
+                for (int tile = space->chunkStart[c]; tile < space->chunkStart[c + 1] && !cancelRaised(&cancel) && !checkpointStopRequested(); tile++)
                 {
-                     // Verifica se a flag de parada foi ativada
-                    #pragma omp flush(stop)
-                    if (stop) continue;
-
-                    for (int l = 0; l < b2->size; l++)
+                if (checkpointTileDone(&progress, i, tile)) continue;
+                for (int k = space->tiles[tile].kBegin; k < space->tiles[tile].kEnd; k++)
+                {
+                    int firstL = pairTileFirstCol(space, &space->tiles[tile], k);
+                    int lEnd = space->tiles[tile].lEnd;
+                    for (int l0 = firstL; l0 < lEnd && !cancelRaised(&cancel); l0 += TT_KERNEL_LANES)
+                    for (int pol = 0; pol < polarities; pol++)
                     {
-                        if (i == j && l < k) continue; // Evita repetições desnecessárias em buckets iguais
-
-                        //Function *f1 = b1->functions[k];
-                        //Function *f2 = b2->functions[l];
-                        
-                        // Enfileira as duas operações
-                        int idx = localBatch.count;
-                        localBatch.f1[idx] = b1->functions[k];
-                        localBatch.f2[idx] = b2->functions[l];
-                        localBatch.op[idx] = '*'; // Primeiro AND
-                        localBatch.count++;
-                        
-                        if (localBatch.count == BATCH_SIZE) {
-                            enqueue(queue, &localBatch);
-                            localBatch.count = 0;
+                        int count = (lEnd - l0 < TT_KERNEL_LANES) ? lEnd - l0 : TT_KERNEL_LANES;
+                        uint32_t rightFlag = pol ? BUCKET_NEGATED : 0;
+                        uint64_t andKeep, orKeep;
+                        if (useTruthTable) {
+                            const TruthTable *right = &b2->tt[l0];
+                            if (pol) {
+                                for (int x = 0; x < count; x++) negRight[x] = ~b2->tt[l0 + x] & fullTt;
+                                right = negRight;
+                            }
+                            // O kernel vetorial já descarta as constantes, então só vai para a fila o que pode entrar no bucket
+                            combineKernel(b1->tt[k], right, count, fullTt, objectiveTt, andOut, orOut, &mask);
+                            prefilterCountMask(&stats, count, &mask);
+                            andKeep = mask.andKeep;
+                            orKeep = mask.orKeep;
+                        } else {
+                            andKeep = orKeep = (count == 64) ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1);
+                        }
+
+                        // Enfileira as operações que sobraram, primeiro AND
+                        for (uint64_t keep = andKeep | orKeep; keep != 0; keep &= keep - 1) {
+                            int x = __builtin_ctzll(keep);
+                            for (int op = 0; op < 2; op++) {
+                                if (!(((op == 0 ? andKeep : orKeep) >> x) & 1)) continue;
+                                int idx = localBatch->count;
+                                localBatch->left[idx] = (uint32_t)k;
+                                localBatch->right[idx] = (uint32_t)(l0 + x) | rightFlag;
+                                localBatch->leftOrder[idx] = (uint8_t)(i + 1);
+                                localBatch->op[idx] = (op == 0) ? '*' : '+';
+                                localBatch->count++;
+
+                                if (localBatch->count == BATCH_SIZE) {
+                                    if (widths.combiners == 0) {
+                                        // Sem combinadores (time pequeno) o produtor combina o próprio lote
+                                        pipelineCombine(&p, &combiner, localBatch);
+                                        localBatch->count = 0;
+                                    } else {
+                                        enqueue(queue, localBatch);
+                                        localBatch = acquireBatch(queue);
+                                    }
+                                }
+                            }
                         }
-                        idx = localBatch.count;
-                localBatch.f1[idx] = b1->functions[k];
-                localBatch.f2[idx] = b2->functions[l];
-                localBatch.op[idx] = '+'; 
-                localBatch.count++;
-                
-                if (localBatch.count == BATCH_SIZE) {
-                    enqueue(queue, &localBatch);
-                    localBatch.count = 0;
-                }
                     }
                 }
+                checkpointMarkTile(&progress, i, tile);
+                }
             }
 
-            if (localBatch.count > 0) {
-            enqueue(queue, &localBatch);
+            if (localBatch->count > 0 && !cancelRaised(&cancel) && widths.combiners == 0) {
+            pipelineCombine(&p, &combiner, localBatch);
+            releaseBatch(queue, localBatch);
+            } else if (localBatch->count > 0 && !cancelRaised(&cancel)) {
+            enqueue(queue, localBatch);
+            } else {
+            releaseBatch(queue, localBatch);
             }
 
+            prefilterMerge(&stats);
+            ringProducerDone(&queue->ready);
+    }
+
+            // Estágio 2: os combinadores desde o começo, os produtores depois que acabam os pares.
+            // dequeue dorme enquanto a fila está vazia e devolve NULL quando os produtores terminaram
+            TaskBatch *task;
+            while ((task = dequeue(queue)) != NULL) {
+                atomic_fetch_add_explicit(&p.readyDepthSum, ringDepth(&queue->ready), memory_order_relaxed);
+                atomic_fetch_add_explicit(&p.readySamples, 1, memory_order_relaxed);
+                if (!cancelRaised(&cancel)) pipelineCombine(&p, &combiner, task); //Parada ativada: o lote volta para o pool sem combinar
+                releaseBatch(queue, task);
+            }
+            for (int s = 0; s < p.results->shardCount; s++) {
+                pipelineFlushResults(&p, &combiner, s);
+                if (!p.inlineDedup) ringProducerDone(&p.results->shards[s]);
+            }
+            prefilterMerge(&combiner.stats);
             #pragma omp atomic
-            active_workers--;
+            global_service_time += combiner.serviceTime;
         }
     } // Fim do parallel region
-    
-    omp_destroy_lock(&queue->lock);
+
+    for (int i = 0; i < targetOrder; i++) pairSpaceFree(&spaces[i]);
+    free(spaces);
+    prefilterReport(targetOrder);
+    destroyQueue(queue);
     free(queue);
-    if (stop) {
-        // Libera todas as funções criadas
-        for (int i = 0; i < newFuncCount; i++) {
-            Cudd_RecursiveDeref(manager, newFunctions[i]->bdd);
-            free(newFunctions[i]);
+    int shardCount = p.results->shardCount;
+    destroyResultQueue(p.results);
+    free(p.results);
+
+    // Profundidade média das filas nesta ordem (-1 sem amostra): fila funda pede mais threads no estágio seguinte
+    uint64_t readySamples = atomic_load(&p.readySamples), shardSamples = atomic_load(&p.shardSamples);
+    double readyDepth = readySamples ? (double)atomic_load(&p.readyDepthSum) / readySamples : -1.0;
+    double shardDepth = shardSamples ? (double)atomic_load(&p.shardDepthSum) / shardSamples : -1.0;
+    printf("Pipeline (ordem %d): %d produtores, %d combinadores, %d shards (fila média %.1f pares, %.1f resultados)\n",
+           targetOrder, widths.producers, widths.combiners, widths.shards, readyDepth < 0 ? 0.0 : readyDepth, shardDepth < 0 ? 0.0 : shardDepth);
+    pipelineAdapt(&widths, readyDepth, shardDepth);
+    pipelineWidths = widths;
+
+    if (cancelRaised(&cancel)) {
+        // Libera de uma vez todas as funções que os shards aceitaram
+        for (int s = 0; s < shardCount; s++) {
+            for (int i = 0; !useTruthTable && i < p.parts[s].size; i++) {
+                if (p.parts[s].bdd[i]) Cudd_RecursiveDeref(manager, p.parts[s].bdd[i]);
+            }
+            bucketFreeColumns(&p.parts[s]);
         }
-        free(newFunctions);
+        free(p.parts);
+        checkpointEndOrder(&progress);
         return true; // Equivalência encontrada
     }
 
-    targetBucket->order = targetOrder;
-    targetBucket->size = newFuncCount;
-    if (newFuncCount > 0) {
-        targetBucket->functions = newFunctions;
-    } else
-    {
-        free(newFunctions);
-        targetBucket->functions = NULL;
+    // Junta os parciais dos shards no bucket da ordem
+    bucketPublish(targetBucket, targetOrder, p.parts, shardCount);
+    free(p.parts);
+    // Parada pedida no meio da ordem: os lotes dos blocos marcados passaram pelas filas e estão no bucket
+    if (progress.done != NULL && checkpointStopRequested() && checkpointOrderPending(&progress)) {
+        checkpointSaveAndExit(&progress, buckets, targetBucket);
+    }
+    checkpointEndOrder(&progress);
+
+    // Verifica o bucket final se a opção não era saída imediata (no modo c ninguém olhou os resultados antes)
+    for (int i = 0; i < targetBucket->size; i++) {
+        if (bucketIsObjective(targetBucket, i, objectiveExp)) {
+            printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+            printBucketFunction(buckets, targetOrder, bucketObjectiveRef(targetBucket, i, objectiveExp));
+            printf("\n");
+            printf("No de literais: %d\n", targetOrder);
+            return true;
+        }
     }
     return false;        
 }
 
-Function* varNode(char varName, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = VAR; // variável
-    node->varName = varName;
-    node->left = NULL;
-    node->right = NULL;
-    return node;
+void pipelineDefaultWidths(PipelineWidths *w, int threads)
+{
+    w->threads = threads;
+    if (threads <= 1) {
+        // Uma thread só faz os três estágios em sequência
+        w->producers = 1;
+        w->combiners = 0;
+        w->shards = 0;
+    } else if (threads == 2) {
+        w->producers = 1;
+        w->combiners = 0;
+        w->shards = 1;
+    } else {
+        w->shards = threads / 4;
+        if (w->shards < 1) w->shards = 1;
+        if (w->shards > PIPELINE_MAX_SHARDS) w->shards = PIPELINE_MAX_SHARDS;
+        w->combiners = (threads - w->shards) / 2;
+        if (w->combiners < 1) w->combiners = 1;
+        w->producers = threads - w->shards - w->combiners;
+    }
 }
 
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = operador; // 1 p/ not, 2 p/ and, 3 p/ or
-    node->varName = '\0'; // não usado para operadores
-    node->left = left;
-    node->right = right;
-    return node;
+// Uma thread muda de estágio por fila e por ordem. Fila de pares funda: faltam combinadores; rasa: faltam produtores.
+// Fila de resultados funda: faltam shards; rasa: sobra shard
+void pipelineAdapt(PipelineWidths *w, double readyDepth, double shardDepth)
+{
+    if (w->threads < 3) return;
+    if (readyDepth >= 0) {
+        if (readyDepth > PIPELINE_DEEP_BATCHES && w->producers > 1) {
+            w->producers--;
+            w->combiners++;
+        } else if (readyDepth < PIPELINE_SHALLOW_BATCHES && w->combiners > 1) {
+            w->combiners--;
+            w->producers++;
+        }
+    }
+    if (shardDepth >= 0) {
+        if (shardDepth > PIPELINE_DEEP_BATCHES && w->shards < PIPELINE_MAX_SHARDS && (w->combiners > 1 || w->producers > 1)) {
+            if (w->combiners >= w->producers && w->combiners > 1) w->combiners--;
+            else w->producers--;
+            w->shards++;
+        } else if (shardDepth < PIPELINE_SHALLOW_BATCHES && w->shards > 1) {
+            w->shards--;
+            w->combiners++;
+        }
+    }
+}
+
+void pipelineCombine(Pipeline *p, Combiner *c, TaskBatch *task)
+{
+    DdManager *manager = p->manager;
+    int shardCount = p->results->shardCount;
+    double t_svc_start = omp_get_wtime();
+    for (int i = 0; i < task->count; i++) {
+        if (cancelRaised(p->cancel)) break; // Checa o token dentro do lote também
+
+        Bucket *b1 = &p->buckets[task->leftOrder[i] - 1];
+        Bucket *b2 = &p->buckets[p->targetOrder - task->leftOrder[i] - 1];
+        uint32_t k = task->left[i];
+        uint32_t l = task->right[i];
+        char op = task->op[i];
+
+        DdNode *newBdd = NULL;
+        TruthTable newTt = 0;
+        uint64_t key, rawKey;
+        if (useTruthTable) {
+            TruthTable rightTt = bucketRefTt(b2, l);
+            newTt = (op == '*') ? (b1->tt[k] & rightTt) : (b1->tt[k] | rightTt);
+            if (newTt == 0 || newTt == fullTt) continue;
+            rawKey = newTt;
+            key = foldComplements ? bucketCanonicalTt(newTt) : newTt;
+        } else {
+            DdNode *rightBdd = Cudd_NotCond(b2->bdd[BUCKET_INDEX(l)], (l & BUCKET_NEGATED) != 0);
+            // AND e OR do mesmo par chegam juntos, então a resposta do pré-filtro é reaproveitada
+            if (task->leftOrder[i] != c->lastOrder || k != c->lastLeft || l != c->lastRight) {
+                c->lastOrder = task->leftOrder[i];
+                c->lastLeft = k;
+                c->lastRight = l;
+                Signature leftSig, rightSig;
+                const Signature *sf = bucketRefSig(b1, k, &leftSig);
+                const Signature *sg = bucketRefSig(b2, l, &rightSig);
+                if (prefilterNeedsManager(sf, sg)) {
+                    BDD_CRITICAL
+                    c->lastOps = prefilterBdd(manager, b1->bdd[k], rightBdd, sf, sg, &c->stats);
+                } else {
+                    c->lastOps = prefilterBdd(manager, b1->bdd[k], rightBdd, sf, sg, &c->stats); // Só assinaturas, sem trava
+                }
+            }
+            if (!(c->lastOps & ((op == '*') ? PREFILTER_AND : PREFILTER_OR))) continue;
+            //Crítico pois precisa acessar o manager, que é compartilhado (o BDD_CRITICAL some no backend próprio)
+            BDD_CRITICAL
+            newBdd = combineBdds(manager, b1->bdd[k], rightBdd, op);
+            if (newBdd == NULL) continue;
+            if (newBdd == Cudd_ReadLogicZero(manager) || newBdd == Cudd_ReadOne(manager)) {
+                BDD_CRITICAL
+                Cudd_RecursiveDeref(manager, newBdd);
+                continue;
+            }
+            rawKey = (uint64_t)(uintptr_t)newBdd;
+            key = (uint64_t)(uintptr_t)(foldComplements ? bucketCanonicalBdd(newBdd) : newBdd);
+        }
+
+        // Com a dobra a chave é o representante, e o complemento do objetivo também é acerto
+        bool negHit = foldComplements && (useTruthTable ? newTt == (~objectiveTt & fullTt) : newBdd == Cudd_Not(p->objectiveExp));
+        bool isTarget = negHit || (useTruthTable ? (newTt == objectiveTt) : (newBdd == p->objectiveExp));
+        if (isTarget && p->choice == 'e') {
+            OpType hitOp = (op == '*') ? AND : OR;
+            uint32_t hitLeft = k, hitRight = l;
+            if (negHit) bucketDualize(&hitOp, &hitLeft, &hitRight);
+            // Só quem levantou o token primeiro imprime
+            if (cancelRaise(p->cancel)) {
+                printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", p->targetOrder);
+                printf("RESULTADO_LITERAIS: %d\n", p->targetOrder);
+                printf("RESULTADO_EXPRESSAO: ");
+                printBucketCombination(p->buckets, hitOp, task->leftOrder[i], hitLeft, p->targetOrder - task->leftOrder[i], hitRight);
+                printf("\n");
+            }
+            if (newBdd) {
+                BDD_CRITICAL
+                Cudd_RecursiveDeref(manager, newBdd);
+            }
+            break;
+        }
+
+        // O shard sai dos bits altos do hash (os baixos escolhem o slot no conjunto de duplicatas)
+        int shard = (shardCount > 1) ? (int)((seenSetHash(key) >> 40) % (uint64_t)shardCount) : 0;
+        if (c->open[shard] == NULL) c->open[shard] = acquireResult(p->results);
+        ResultBatch *r = c->open[shard];
+        int idx = r->count++;
+        r->key[idx] = key;
+        r->complemented[idx] = key != rawKey;
+        r->left[idx] = k;
+        r->right[idx] = l;
+        r->leftOrder[idx] = task->leftOrder[i];
+        r->op[idx] = op;
+        if (r->count == BATCH_SIZE) pipelineFlushResults(p, c, shard);
+    }
+    c->serviceTime += omp_get_wtime() - t_svc_start;
+}
+
+void pipelineFlushResults(Pipeline *p, Combiner *c, int shard)
+{
+    ResultBatch *r = c->open[shard];
+    if (r == NULL) return;
+    c->open[shard] = NULL;
+    if (p->inlineDedup) {
+        pipelineDedup(p, shard, r);
+        releaseResult(p->results, r);
+    } else if (r->count > 0) {
+        ringPush(&p->results->shards[shard], r);
+    } else {
+        releaseResult(p->results, r);
+    }
+}
+
+/* Inserção em lote no conjunto de duplicatas e append no parcial do shard, sem trava nenhuma.
+Recusadas (ou tudo, depois do token) liberam o BDD de uma vez, numa seção crítica por lote */
+void pipelineDedup(Pipeline *p, int shard, ResultBatch *r)
+{
+    DdNode *rejected[BATCH_SIZE];
+    bool isNew[BATCH_SIZE];
+    int rejectedCount = 0;
+    bool stopped = cancelRaised(p->cancel);
+    Bucket *part = &p->parts[shard];
+
+    if (!stopped) seenSetInsertBatch(p->uniqueCheck, r->key, r->count, isNew);
+    for (int b = 0; b < r->count; b++) {
+        if (!stopped && isNew[b]) {
+            bucketAppendFolded(part, useTruthTable ? r->key[b] : 0, useTruthTable ? NULL : (DdNode *)(uintptr_t)r->key[b],
+                               r->complemented[b], (r->op[b] == '*') ? AND : OR, r->leftOrder[b], r->left[b], r->right[b]);
+        } else if (!useTruthTable) {
+            rejected[rejectedCount++] = (DdNode *)(uintptr_t)r->key[b];
+        }
+    }
+
+    if (rejectedCount > 0) {
+        BDD_CRITICAL
+        {
+            for (int b = 0; b < rejectedCount; b++) Cudd_RecursiveDeref(p->manager, rejected[b]);
+        }
+    }
 }
 
 void printFunction(Function* node) {
@@ -884,41 +1329,105 @@ void logExpressionToFile(Function *node, int ordem) {
     
     fclose(f);
 }*/
-void initQueue(TaskQueue *q) {
-    q->head = 0;
-    q->tail = 0;
-    q->count = 0;
-    q->finished = false;
-    omp_init_lock(&q->lock);
+bool initQueue(TaskQueue *q) {
+    q->maxBatches = TASK_POOL_BYTES / sizeof(TaskBatch);
+    if (q->maxBatches < 2) q->maxBatches = 2;
+    atomic_init(&q->allocated, 0);
+    // As duas filas cabem todos os lotes, então um push nunca espera: quem limita é o pool
+    if (!ringInit(&q->ready, q->maxBatches)) return false;
+    if (!ringInit(&q->pool, q->maxBatches)) {
+        ringFree(&q->ready);
+        return false;
+    }
+    return true;
+}
+
+void destroyQueue(TaskQueue *q) {
+    void *batch;
+    while (ringTryPop(&q->ready, &batch)) free(batch);
+    while (ringTryPop(&q->pool, &batch)) free(batch);
+    ringFree(&q->ready);
+    ringFree(&q->pool);
+}
+
+// Pega um lote vazio: do pool, ou alocando um novo enquanto não passou do limite, ou esperando um voltar
+void *acquireFromPool(BatchRing *pool, _Atomic size_t *allocated, size_t maxBatches, size_t batchBytes) {
+    void *batch = NULL;
+    if (ringTryPop(pool, &batch)) return batch;
+
+    size_t count = atomic_load(allocated);
+    while (count < maxBatches) {
+        if (atomic_compare_exchange_weak(allocated, &count, count + 1)) {
+            batch = malloc(batchBytes);
+            if (batch == NULL) {
+                fprintf(stderr, "Erro ao alocar lote de tarefas\n");
+                exit(EXIT_FAILURE);
+            }
+            return batch;
+        }
+    }
+
+    // Limite atingido: espera o estágio seguinte devolver um (o pool nunca é fechado)
+    ringPop(pool, &batch);
+    return batch;
+}
+
+TaskBatch *acquireBatch(TaskQueue *q) {
+    TaskBatch *t = (TaskBatch *)acquireFromPool(&q->pool, &q->allocated, q->maxBatches, sizeof(TaskBatch));
+    t->count = 0;
+    return t;
+}
+
+void releaseBatch(TaskQueue *q, TaskBatch *t) {
+    t->count = 0;
+    ringPush(&q->pool, t);
 }
 
 void enqueue(TaskQueue *q, TaskBatch *t) {
-    // Spinlock simples se a fila estiver cheia para não bloquear indefinidamente
-    while (1) {
-        omp_set_lock(&q->lock);
-        if (q->count < QUEUE_SIZE) {
-           q->batches[q->tail] = *t; 
-            q->tail = (q->tail + 1) % QUEUE_SIZE;
-            q->count++;
-            omp_unset_lock(&q->lock);
-            break;
+    ringPush(&q->ready, t);
+}
+
+// Bloqueia até ter lote ou até todos os produtores terminarem (NULL)
+TaskBatch *dequeue(TaskQueue *q) {
+    void *batch;
+    if (!ringPop(&q->ready, &batch)) return NULL;
+    return (TaskBatch *)batch;
+}
+
+bool initResultQueue(ResultQueue *q, int shardCount) {
+    q->maxBatches = RESULT_POOL_BYTES / sizeof(ResultBatch);
+    if (q->maxBatches < 2) q->maxBatches = 2;
+    q->shardCount = shardCount;
+    atomic_init(&q->allocated, 0);
+    // Cada fila de shard cabe todos os lotes, então o push do combinador nunca espera
+    if (!ringInit(&q->pool, q->maxBatches)) return false;
+    for (int s = 0; s < shardCount; s++) {
+        if (!ringInit(&q->shards[s], q->maxBatches)) {
+            while (s-- > 0) ringFree(&q->shards[s]);
+            ringFree(&q->pool);
+            return false;
         }
-        omp_unset_lock(&q->lock);
-        // Pequena pausa para dar chance ao consumidor
-        
-        #pragma omp flush
     }
+    return true;
+}
+
+void destroyResultQueue(ResultQueue *q) {
+    void *batch;
+    for (int s = 0; s < q->shardCount; s++) {
+        while (ringTryPop(&q->shards[s], &batch)) free(batch);
+        ringFree(&q->shards[s]);
+    }
+    while (ringTryPop(&q->pool, &batch)) free(batch);
+    ringFree(&q->pool);
+}
+
+ResultBatch *acquireResult(ResultQueue *q) {
+    ResultBatch *r = (ResultBatch *)acquireFromPool(&q->pool, &q->allocated, q->maxBatches, sizeof(ResultBatch));
+    r->count = 0;
+    return r;
 }
 
-bool dequeue(TaskQueue *q, TaskBatch *t) {
-    bool hasItem = false;
-    omp_set_lock(&q->lock);
-    if (q->count > 0) {
-        *t = q->batches[q->head];
-        q->head = (q->head + 1) % QUEUE_SIZE;
-        q->count--;
-        hasItem = true;
-    }
-    omp_unset_lock(&q->lock);
-    return hasItem;
+void releaseResult(ResultQueue *q, ResultBatch *r) {
+    r->count = 0;
+    ringPush(&q->pool, r);
 }
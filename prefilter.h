@@ -0,0 +1,113 @@
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bdd.h"
+#include "ttkernel.h"
+#include "signature.h"
+
+/* Pré-filtro por par antes de qualquer combinação ou deduplicação. Funções dos buckets nunca são constantes, então:
+- complemento (f == !g): AND = 0 e OR = 1, o par inteiro sai;
+- implicação (f <= g ou g <= f): AND e OR repetem um dos operandos, que já está num bucket menor, o par inteiro sai;
+- disjuntos (f <= !g): só o AND sai (daria 0);
+- cobertura (!f <= g): só o OR sai (daria 1).
+No BDD os testes são Cudd_bddLeq, que não cria nó nenhum, e só rodam quando as assinaturas por simulação não refutam
+a relação (o contador signature soma os Cudd_bddLeq evitados assim). Na tabela verdade as mesmas regras saem de graça das máscaras
+do kernel vetorial. Cada thread conta no seu PrefilterStats e soma no global da ordem no fim. */
+#define PREFILTER_AND 1
+#define PREFILTER_OR 2
+
+typedef struct {
+    uint64_t pairs;
+    uint64_t complement;
+    uint64_t implication;
+    uint64_t disjoint;
+    uint64_t cover;
+    uint64_t signature;
+} PrefilterStats;
+
+static PrefilterStats prefilterOrder; //Contadores da ordem em andamento
+
+// (f ^ negF) <= (g ^ negG), com a assinatura tentando responder antes do Cudd_bddLeq
+static inline bool prefilterLeq(DdManager *manager, DdNode *f, bool negF, DdNode *g, bool negG,
+                                const Signature *sf, const Signature *sg, PrefilterStats *stats)
+{
+    if (!sigMayLeq(sf, negF, sg, negG)) {
+        stats->signature++;
+        return false;
+    }
+    return Cudd_bddLeq(manager, Cudd_NotCond(f, negF), Cudd_NotCond(g, negG));
+}
+
+// false quando as assinaturas refutam as quatro relações: aí o prefilterBdd não chama o manager e pode rodar fora da trava
+static inline bool prefilterNeedsManager(const Signature *sf, const Signature *sg)
+{
+    return sigMayLeq(sf, false, sg, false) || sigMayLeq(sg, false, sf, false) ||
+           sigMayLeq(sf, false, sg, true) || sigMayLeq(sf, true, sg, false);
+}
+
+// Operações do par que ainda podem gerar função nova (PREFILTER_AND | PREFILTER_OR). sf e sg podem ser NULL (sem assinatura)
+static inline int prefilterBdd(DdManager *manager, DdNode *f, DdNode *g, const Signature *sf, const Signature *sg, PrefilterStats *stats)
+{
+    stats->pairs++;
+    if (f == Cudd_Not(g)) {
+        stats->complement++;
+        return 0;
+    }
+    if (prefilterLeq(manager, f, false, g, false, sf, sg, stats) || prefilterLeq(manager, g, false, f, false, sg, sf, stats)) {
+        stats->implication++;
+        return 0;
+    }
+    int ops = PREFILTER_AND | PREFILTER_OR;
+    if (prefilterLeq(manager, f, false, g, true, sf, sg, stats)) {
+        stats->disjoint++;
+        ops &= ~PREFILTER_AND;
+    }
+    if (prefilterLeq(manager, f, true, g, false, sf, sg, stats)) {
+        stats->cover++;
+        ops &= ~PREFILTER_OR;
+    }
+    return ops;
+}
+
+// Mesmas regras, lidas das máscaras de um trecho do kernel
+static inline void prefilterCountMask(PrefilterStats *stats, int count, const TtComboMask *mask)
+{
+    stats->pairs += count;
+    stats->complement += __builtin_popcountll(mask->andZero & mask->orFull);
+    stats->implication += __builtin_popcountll(mask->dominated);
+    stats->disjoint += __builtin_popcountll(mask->andZero & ~mask->orFull);
+    stats->cover += __builtin_popcountll(mask->orFull & ~mask->andZero);
+}
+
+static inline void prefilterBegin(void)
+{
+    PrefilterStats empty = {0, 0, 0, 0, 0, 0};
+    prefilterOrder = empty;
+}
+
+// Soma os contadores de uma thread nos da ordem
+static inline void prefilterMerge(const PrefilterStats *local)
+{
+    __atomic_fetch_add(&prefilterOrder.pairs, local->pairs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prefilterOrder.complement, local->complement, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prefilterOrder.implication, local->implication, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prefilterOrder.disjoint, local->disjoint, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prefilterOrder.cover, local->cover, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prefilterOrder.signature, local->signature, __ATOMIC_RELAXED);
+}
+
+static inline void prefilterReport(int order)
+{
+    const PrefilterStats *s = &prefilterOrder;
+    if (s->pairs == 0) return;
+    printf("Pré-filtro (ordem %d): %llu pares, complemento %llu, implicação %llu, disjuntos %llu, cobertura %llu",
+           order, (unsigned long long)s->pairs, (unsigned long long)s->complement, (unsigned long long)s->implication,
+           (unsigned long long)s->disjoint, (unsigned long long)s->cover);
+    if (s->signature > 0) printf(", %llu testes exatos evitados pela assinatura", (unsigned long long)s->signature);
+    printf("\n");
+}
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Fila circular limitada de ponteiros com vários produtores e vários consumidores (MPMC).
+Cada célula tem um número de sequência que diz se ela está livre para o próximo push ou pronta para o próximo pop,
+então push e pop são um compare-and-swap na posição e nenhuma trava (esquema do Vyukov).
+Quando a fila está cheia (ou vazia) a thread não fica girando: espera um pouco com pausa de CPU, depois cede o núcleo,
+e por fim dorme num futex até algum pop (ou push) mudar o contador. Os contadores só acordam alguém se tiver thread
+dormindo, então no caso comum não há chamada de sistema. Fora do Linux o último estágio vira sched_yield. */
+#define RING_SPIN_LIMIT 64
+#define RING_YIELD_LIMIT 128
+
+typedef struct {
+    _Atomic size_t sequence;
+    void *data;
+} RingCell;
+
+typedef struct {
+    RingCell *cells;
+    size_t mask;
+    // Posições em linhas de cache separadas para produtores e consumidores não brigarem pela mesma linha
+    _Alignas(64) _Atomic size_t enqueuePos;
+    _Alignas(64) _Atomic size_t dequeuePos;
+    _Alignas(64) _Atomic uint32_t pushes; //Muda a cada push (futex dos consumidores)
+    _Atomic uint32_t pops; //Muda a cada pop (futex dos produtores)
+    _Atomic int sleepingConsumers;
+    _Atomic int sleepingProducers;
+    _Atomic int producers; //Produtores ainda ativos, o último fecha a fila
+    atomic_bool closed;
+} BatchRing;
+
+static inline void ringFutexWait(_Atomic uint32_t *word, uint32_t seen)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+#else
+    (void)word;
+    (void)seen;
+    sched_yield();
+#endif
+}
+
+static inline void ringFutexWakeAll(_Atomic uint32_t *word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+static inline void ringCpuRelax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Espera adaptativa: pausa, depois cede o núcleo, depois dorme até o contador mudar
+static inline void ringBackoff(int *attempt, _Atomic uint32_t *word, uint32_t seen, _Atomic int *sleeping)
+{
+    (*attempt)++;
+    if (*attempt < RING_SPIN_LIMIT) {
+        ringCpuRelax();
+    } else if (*attempt < RING_YIELD_LIMIT) {
+        sched_yield();
+    } else {
+        atomic_fetch_add(sleeping, 1);
+        ringFutexWait(word, seen);
+        atomic_fetch_sub(sleeping, 1);
+    }
+}
+
+// Capacidade em número de ponteiros, arredondada para potência de 2
+static inline bool ringInit(BatchRing *ring, size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    ring->cells = (RingCell *)malloc(size * sizeof(RingCell));
+    if (ring->cells == NULL) return false;
+    for (size_t k = 0; k < size; k++) {
+        atomic_init(&ring->cells[k].sequence, k);
+        ring->cells[k].data = NULL;
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->enqueuePos, 0);
+    atomic_init(&ring->dequeuePos, 0);
+    atomic_init(&ring->pushes, 0);
+    atomic_init(&ring->pops, 0);
+    atomic_init(&ring->sleepingConsumers, 0);
+    atomic_init(&ring->sleepingProducers, 0);
+    atomic_init(&ring->producers, 0);
+    atomic_init(&ring->closed, false);
+    return true;
+}
+
+static inline void ringFree(BatchRing *ring)
+{
+    free(ring->cells);
+    ring->cells = NULL;
+}
+
+static inline bool ringTryPush(BatchRing *ring, void *data)
+{
+    size_t pos = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+    while (true) {
+        RingCell *cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->data = data;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // Cheia
+        } else {
+            pos = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+        }
+    }
+    atomic_fetch_add(&ring->pushes, 1);
+    if (atomic_load(&ring->sleepingConsumers) > 0) ringFutexWakeAll(&ring->pushes);
+    return true;
+}
+
+static inline bool ringTryPop(BatchRing *ring, void **data)
+{
+    size_t pos = atomic_load_explicit(&ring->dequeuePos, memory_order_relaxed);
+    while (true) {
+        RingCell *cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->dequeuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *data = cell->data;
+                atomic_store_explicit(&cell->sequence, pos + ring->mask + 1, memory_order_release);
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // Vazia
+        } else {
+            pos = atomic_load_explicit(&ring->dequeuePos, memory_order_relaxed);
+        }
+    }
+    atomic_fetch_add(&ring->pops, 1);
+    if (atomic_load(&ring->sleepingProducers) > 0) ringFutexWakeAll(&ring->pops);
+    return true;
+}
+
+// Push bloqueante: espera vaga na fila
+static inline void ringPush(BatchRing *ring, void *data)
+{
+    int attempt = 0;
+    while (true) {
+        uint32_t seen = atomic_load(&ring->pops);
+        if (ringTryPush(ring, data)) return;
+        ringBackoff(&attempt, &ring->pops, seen, &ring->sleepingProducers);
+    }
+}
+
+// Pop bloqueante. Retorna false quando a fila foi fechada e não sobrou nada
+static inline bool ringPop(BatchRing *ring, void **data)
+{
+    int attempt = 0;
+    while (true) {
+        uint32_t seen = atomic_load(&ring->pushes);
+        if (ringTryPop(ring, data)) return true;
+        if (atomic_load(&ring->closed)) {
+            // Um push pode ter entrado entre a tentativa e a leitura do closed
+            return ringTryPop(ring, data);
+        }
+        ringBackoff(&attempt, &ring->pushes, seen, &ring->sleepingConsumers);
+    }
+}
+
+// Lotes na fila agora (aproximado: as duas posições são lidas sem trava). Serve só para medir a profundidade
+static inline size_t ringDepth(BatchRing *ring)
+{
+    size_t dequeued = atomic_load_explicit(&ring->dequeuePos, memory_order_relaxed);
+    size_t enqueued = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+    return (enqueued > dequeued) ? enqueued - dequeued : 0;
+}
+
+// Avisa os consumidores que não vem mais nada
+static inline void ringClose(BatchRing *ring)
+{
+    atomic_store(&ring->closed, true);
+    atomic_fetch_add(&ring->pushes, 1);
+    ringFutexWakeAll(&ring->pushes);
+}
+
+// Número de produtores. Com zero a fila já nasce fechada
+static inline void ringSetProducers(BatchRing *ring, int producers)
+{
+    atomic_store(&ring->producers, producers);
+    if (producers == 0) ringClose(ring);
+}
+
+// Cada produtor chama ao terminar; o último fecha a fila (depois de todos os pushes, pela ordem acq_rel)
+static inline void ringProducerDone(BatchRing *ring)
+{
+    if (atomic_fetch_sub_explicit(&ring->producers, 1, memory_order_acq_rel) == 1) ringClose(ring);
+}
+
+#endif
@@ -0,0 +1,502 @@
+#ifndef ROBDD_H
+#define ROBDD_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <omp.h>
+
+/* Pacote de BDD reduzido e ordenado próprio, com só o que o projeto usa do CUDD (ithVar, Not, And, Or, Cofactor,
+Leq, Eval, Transfer). Diferente do CUDD, várias threads podem combinar no mesmo manager ao mesmo tempo:
+- Arestas complementadas como no CUDD: o bit baixo do ponteiro nega a função e o filho "then" nunca é complementado,
+  então Not é de graça e f == Not(g) é uma comparação de ponteiros.
+- Tabela única em endereçamento aberto com slots atômicos: um nó novo entra com um compare-and-swap no slot vazio,
+  e quem perde a corrida reaproveita o nó que ganhou (o seu fica perdido até a próxima coleta).
+- Cache de operações por thread, sem trava nenhuma (indexada pelo omp_get_thread_num).
+- Contagem de referências só no nó de cima, como no CUDD, e coleta de lixo por marcação a partir dos nós referenciados.
+  A coleta só roda em rbSafePoint, chamado pelos executáveis entre as ordens, quando nenhuma thread está combinando.
+A capacidade é fixa (2^ROBDD_LOG_NODES nós); a memória é reservada com calloc e só é tocada conforme o uso. */
+#ifndef ROBDD_LOG_NODES
+#define ROBDD_LOG_NODES 23
+#endif
+#ifndef ROBDD_LOG_CACHE
+#define ROBDD_LOG_CACHE 18
+#endif
+#define ROBDD_MAX_VARS 1024
+#define ROBDD_CONST_INDEX UINT32_MAX
+
+enum { RB_OP_AND = 1, RB_OP_COFACTOR, RB_OP_LEQ, RB_OP_TRANSFER };
+
+typedef struct RbNode {
+    uint32_t index; //Variável (ROBDD_CONST_INDEX na constante)
+    _Atomic uint32_t ref;
+    struct RbNode *high; //Nunca complementado
+    struct RbNode *low;
+} RbNode;
+
+typedef struct {
+    RbNode *f;
+    RbNode *g;
+    RbNode *result;
+    uint32_t op; //0 = vazio
+} RbCacheEntry;
+
+typedef struct {
+    RbNode *nodes; //nodes[0] é a constante um
+    size_t maxNodes;
+    _Atomic size_t bump; //Primeiro nó nunca usado
+    uint32_t *freeList; //Nós liberados pela última coleta
+    size_t freeCount;
+    _Atomic size_t freeCursor;
+    _Atomic(RbNode *) *slots;
+    size_t slotMask;
+    _Atomic size_t live; //Nós na tabela única
+    RbNode *vars[ROBDD_MAX_VARS];
+    int varCount;
+    RbCacheEntry **caches; //Um por thread, alocado no primeiro uso
+    int cacheCount;
+} RbManager;
+
+#define rbRegular(e) ((RbNode *)((uintptr_t)(e) & ~(uintptr_t)1))
+#define rbIsComplement(e) ((int)((uintptr_t)(e) & 1))
+#define rbNot(e) ((RbNode *)((uintptr_t)(e) ^ (uintptr_t)1))
+#define rbNotCond(e, c) ((RbNode *)((uintptr_t)(e) ^ (uintptr_t)((c) ? 1 : 0)))
+
+static inline RbNode *rbReadOne(RbManager *m)
+{
+    return &m->nodes[0];
+}
+
+static inline RbNode *rbReadZero(RbManager *m)
+{
+    return rbNot(&m->nodes[0]);
+}
+
+static inline RbManager *rbInit(int numVars)
+{
+    RbManager *m = (RbManager *)calloc(1, sizeof(RbManager));
+    if (m == NULL) return NULL;
+    m->maxNodes = (size_t)1 << ROBDD_LOG_NODES;
+    // Tabela com o dobro de slots: carga máxima de 1/2 e a sondagem sempre acha um vazio
+    m->nodes = (RbNode *)calloc(m->maxNodes, sizeof(RbNode));
+    m->slots = (_Atomic(RbNode *) *)calloc(2 * m->maxNodes, sizeof(*m->slots));
+    m->cacheCount = omp_get_max_threads();
+    m->caches = (RbCacheEntry **)calloc(m->cacheCount, sizeof(RbCacheEntry *));
+    if (m->nodes == NULL || m->slots == NULL || m->caches == NULL) {
+        free(m->nodes);
+        free(m->slots);
+        free(m->caches);
+        free(m);
+        return NULL;
+    }
+    m->slotMask = 2 * m->maxNodes - 1;
+    m->nodes[0].index = ROBDD_CONST_INDEX;
+    atomic_init(&m->nodes[0].ref, 1);
+    atomic_init(&m->bump, 1);
+    atomic_init(&m->freeCursor, 0);
+    atomic_init(&m->live, 1);
+    (void)numVars; // As variáveis são criadas pelo rbIthVar, como no CUDD
+    return m;
+}
+
+static inline void rbQuit(RbManager *m)
+{
+    for (int t = 0; t < m->cacheCount; t++) free(m->caches[t]);
+    free(m->caches);
+    free(m->freeList);
+    free((void *)m->slots);
+    free(m->nodes);
+    free(m);
+}
+
+static inline void rbRef(RbNode *e)
+{
+    atomic_fetch_add_explicit(&rbRegular(e)->ref, 1, memory_order_relaxed);
+}
+
+// Só solta a referência; o nó (e o que só ele segurava) sai na próxima coleta
+static inline void rbDeref(RbManager *m, RbNode *e)
+{
+    (void)m;
+    atomic_fetch_sub_explicit(&rbRegular(e)->ref, 1, memory_order_relaxed);
+}
+
+static inline RbNode *rbAllocNode(RbManager *m)
+{
+    size_t c = atomic_fetch_add_explicit(&m->freeCursor, 1, memory_order_relaxed);
+    if (c < m->freeCount) return &m->nodes[m->freeList[c]];
+    size_t b = atomic_fetch_add_explicit(&m->bump, 1, memory_order_relaxed);
+    if (b >= m->maxNodes) {
+        fprintf(stderr, "ROBDD: capacidade de %zu nós esgotada (recompile com -DROBDD_LOG_NODES maior)\n", m->maxNodes);
+        exit(EXIT_FAILURE);
+    }
+    return &m->nodes[b];
+}
+
+static inline size_t rbHash(uint32_t index, const RbNode *high, const RbNode *low)
+{
+    uint64_t h = (uint64_t)index * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t)(uintptr_t)high >> 3) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= ((uint64_t)(uintptr_t)low >> 3) * 0x165667B19E3779F9ULL;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+// Devolve o nó (index, high, low), criando se preciso. Mantém a forma canônica (high nunca complementado)
+static inline RbNode *rbUniqueFind(RbManager *m, uint32_t index, RbNode *high, RbNode *low)
+{
+    if (high == low) return high;
+    int complement = rbIsComplement(high);
+    if (complement) {
+        high = rbNot(high);
+        low = rbNot(low);
+    }
+
+    size_t h = rbHash(index, high, low) & m->slotMask;
+    RbNode *fresh = NULL;
+    while (true) {
+        RbNode *cur = atomic_load_explicit(&m->slots[h], memory_order_acquire);
+        if (cur == NULL) {
+            if (fresh == NULL) {
+                fresh = rbAllocNode(m);
+                fresh->index = index;
+                fresh->high = high;
+                fresh->low = low;
+                atomic_store_explicit(&fresh->ref, 0, memory_order_relaxed);
+            }
+            if (atomic_compare_exchange_strong_explicit(&m->slots[h], &cur, fresh,
+                                                        memory_order_release, memory_order_acquire)) {
+                atomic_fetch_add_explicit(&m->live, 1, memory_order_relaxed);
+                return rbNotCond(fresh, complement);
+            }
+            // Outra thread ocupou o slot: cur agora é o nó dela
+        }
+        if (cur->index == index && cur->high == high && cur->low == low) return rbNotCond(cur, complement);
+        h = (h + 1) & m->slotMask;
+    }
+}
+
+static inline RbCacheEntry *rbCacheFor(RbManager *m)
+{
+    int tid = omp_get_thread_num();
+    if (tid >= m->cacheCount) return NULL; // Time maior que o previsto: segue sem cache
+    if (m->caches[tid] == NULL) {
+        m->caches[tid] = (RbCacheEntry *)calloc((size_t)1 << ROBDD_LOG_CACHE, sizeof(RbCacheEntry));
+    }
+    return m->caches[tid];
+}
+
+static inline RbCacheEntry *rbCacheSlot(RbCacheEntry *cache, uint32_t op, const RbNode *f, const RbNode *g)
+{
+    // op entra multiplicado: sozinho ele só mexeria nos bits baixos, que o índice descarta
+    uint64_t h = ((uint64_t)(uintptr_t)f * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)(uintptr_t)g * 0xC2B2AE3D27D4EB4FULL) ^
+                 ((uint64_t)op * 0x165667B19E3779F9ULL);
+    return &cache[(h >> 17) & (((size_t)1 << ROBDD_LOG_CACHE) - 1)];
+}
+
+static inline bool rbCacheLookup(RbCacheEntry *cache, uint32_t op, RbNode *f, RbNode *g, RbNode **result)
+{
+    if (cache == NULL) return false;
+    RbCacheEntry *entry = rbCacheSlot(cache, op, f, g);
+    if (entry->op != op || entry->f != f || entry->g != g) return false;
+    *result = entry->result;
+    return true;
+}
+
+static inline void rbCacheInsert(RbCacheEntry *cache, uint32_t op, RbNode *f, RbNode *g, RbNode *result)
+{
+    if (cache == NULL) return;
+    RbCacheEntry *entry = rbCacheSlot(cache, op, f, g);
+    entry->op = op;
+    entry->f = f;
+    entry->g = g;
+    entry->result = result;
+}
+
+static inline uint32_t rbTopIndex(RbNode *e)
+{
+    return rbRegular(e)->index;
+}
+
+// Cofatores de e em relação à variável index (e mesma se não depender dela no topo)
+static inline void rbCofactors(RbNode *e, uint32_t index, RbNode **high, RbNode **low)
+{
+    RbNode *reg = rbRegular(e);
+    if (reg->index != index) {
+        *high = e;
+        *low = e;
+        return;
+    }
+    int c = rbIsComplement(e);
+    *high = rbNotCond(reg->high, c);
+    *low = rbNotCond(reg->low, c);
+}
+
+static inline RbNode *rbAndRec(RbManager *m, RbCacheEntry *cache, RbNode *f, RbNode *g)
+{
+    RbNode *one = rbReadOne(m);
+    RbNode *zero = rbNot(one);
+    if (f == zero || g == zero || f == rbNot(g)) return zero;
+    if (f == one || f == g) return g;
+    if (g == one) return f;
+    if ((uintptr_t)f > (uintptr_t)g) {
+        RbNode *tmp = f;
+        f = g;
+        g = tmp;
+    }
+
+    RbNode *result;
+    if (rbCacheLookup(cache, RB_OP_AND, f, g, &result)) return result;
+
+    uint32_t index = rbTopIndex(f) < rbTopIndex(g) ? rbTopIndex(f) : rbTopIndex(g);
+    RbNode *fh, *fl, *gh, *gl;
+    rbCofactors(f, index, &fh, &fl);
+    rbCofactors(g, index, &gh, &gl);
+    RbNode *high = rbAndRec(m, cache, fh, gh);
+    RbNode *low = rbAndRec(m, cache, fl, gl);
+    result = rbUniqueFind(m, index, high, low);
+
+    rbCacheInsert(cache, RB_OP_AND, f, g, result);
+    return result;
+}
+
+static inline RbNode *rbAnd(RbManager *m, RbNode *f, RbNode *g)
+{
+    return rbAndRec(m, rbCacheFor(m), f, g);
+}
+
+static inline RbNode *rbOr(RbManager *m, RbNode *f, RbNode *g)
+{
+    return rbNot(rbAnd(m, rbNot(f), rbNot(g)));
+}
+
+// Cofator de f em relação a um cubo (conjunção de literais), como o Cudd_Cofactor
+static inline RbNode *rbCofactorRec(RbManager *m, RbCacheEntry *cache, RbNode *f, RbNode *cube)
+{
+    RbNode *one = rbReadOne(m);
+    if (cube == one || rbRegular(f) == one) return f;
+
+    RbNode *result;
+    if (rbCacheLookup(cache, RB_OP_COFACTOR, f, cube, &result)) return result;
+
+    uint32_t topF = rbTopIndex(f);
+    uint32_t topC = rbTopIndex(cube);
+    RbNode *ch, *cl;
+    rbCofactors(cube, topC, &ch, &cl);
+    bool positive = ch != rbNot(one);
+    RbNode *nextCube = positive ? ch : cl;
+
+    if (topC < topF) {
+        result = rbCofactorRec(m, cache, f, nextCube);
+    } else {
+        RbNode *fh, *fl;
+        rbCofactors(f, topF, &fh, &fl);
+        if (topC == topF) {
+            result = rbCofactorRec(m, cache, positive ? fh : fl, nextCube);
+        } else {
+            RbNode *high = rbCofactorRec(m, cache, fh, cube);
+            RbNode *low = rbCofactorRec(m, cache, fl, cube);
+            result = rbUniqueFind(m, topF, high, low);
+        }
+    }
+
+    rbCacheInsert(cache, RB_OP_COFACTOR, f, cube, result);
+    return result;
+}
+
+static inline RbNode *rbCofactor(RbManager *m, RbNode *f, RbNode *cube)
+{
+    if (cube == rbReadZero(m)) {
+        fprintf(stderr, "ROBDD: cofator em relação à constante zero\n");
+        return NULL;
+    }
+    return rbCofactorRec(m, rbCacheFor(m), f, cube);
+}
+
+// f <= g sem criar nó nenhum (o resultado no cache é a constante um ou zero)
+static inline bool rbLeqRec(RbManager *m, RbCacheEntry *cache, RbNode *f, RbNode *g)
+{
+    RbNode *one = rbReadOne(m);
+    RbNode *zero = rbNot(one);
+    if (f == g || f == zero || g == one) return true;
+    if (f == one || g == zero || f == rbNot(g)) return false;
+
+    RbNode *result;
+    if (rbCacheLookup(cache, RB_OP_LEQ, f, g, &result)) return result == one;
+
+    uint32_t index = rbTopIndex(f) < rbTopIndex(g) ? rbTopIndex(f) : rbTopIndex(g);
+    RbNode *fh, *fl, *gh, *gl;
+    rbCofactors(f, index, &fh, &fl);
+    rbCofactors(g, index, &gh, &gl);
+    bool leq = rbLeqRec(m, cache, fh, gh) && rbLeqRec(m, cache, fl, gl);
+
+    rbCacheInsert(cache, RB_OP_LEQ, f, g, leq ? one : zero);
+    return leq;
+}
+
+static inline bool rbLeq(RbManager *m, RbNode *f, RbNode *g)
+{
+    return rbLeqRec(m, rbCacheFor(m), f, g);
+}
+
+static inline RbNode *rbEval(RbManager *m, RbNode *f, int *inputs)
+{
+    int complement = rbIsComplement(f);
+    RbNode *node = rbRegular(f);
+    while (node->index != ROBDD_CONST_INDEX) {
+        RbNode *next = inputs[node->index] ? node->high : node->low;
+        complement ^= rbIsComplement(next);
+        node = rbRegular(next);
+    }
+    return rbNotCond(rbReadOne(m), complement);
+}
+
+// Cria as variáveis até i se ainda não existem. Não é segura para várias threads (só o parse chama)
+static inline RbNode *rbIthVar(RbManager *m, int i)
+{
+    if (i < 0 || i >= ROBDD_MAX_VARS) {
+        fprintf(stderr, "ROBDD: variável %d fora do limite de %d\n", i, ROBDD_MAX_VARS);
+        return NULL;
+    }
+    while (m->varCount <= i) {
+        RbNode *var = rbUniqueFind(m, (uint32_t)m->varCount, rbReadOne(m), rbReadZero(m));
+        rbRef(var); // Fica viva até o rbQuit
+        m->vars[m->varCount++] = var;
+    }
+    return m->vars[i];
+}
+
+// Copia f de src para dst (mesmos índices de variáveis). A cache de dst guarda o nó de origem já copiado
+static inline RbNode *rbTransferRec(RbManager *src, RbManager *dst, RbCacheEntry *cache, RbNode *f)
+{
+    RbNode *reg = rbRegular(f);
+    int complement = rbIsComplement(f);
+    if (reg == rbReadOne(src)) return rbNotCond(rbReadOne(dst), complement);
+
+    RbNode *result;
+    if (!rbCacheLookup(cache, RB_OP_TRANSFER, reg, (RbNode *)src, &result)) {
+        RbNode *high = rbTransferRec(src, dst, cache, reg->high);
+        RbNode *low = rbTransferRec(src, dst, cache, reg->low);
+        result = rbUniqueFind(dst, reg->index, high, low);
+        rbCacheInsert(cache, RB_OP_TRANSFER, reg, (RbNode *)src, result);
+    }
+    return rbNotCond(result, complement);
+}
+
+static inline RbNode *rbTransfer(RbManager *src, RbManager *dst, RbNode *f)
+{
+    return rbTransferRec(src, dst, rbCacheFor(dst), f);
+}
+
+static inline void rbMark(RbManager *m, uint8_t *mark, RbNode *node)
+{
+    while (true) {
+        size_t k = (size_t)(node - m->nodes);
+        if (mark[k]) return;
+        mark[k] = 1;
+        if (node->index == ROBDD_CONST_INDEX) return;
+        rbMark(m, mark, rbRegular(node->low));
+        node = node->high; // O lado high é iterativo
+    }
+}
+
+/* Coleta de lixo: marca o que é alcançável a partir dos nós referenciados, remonta a tabela única só com eles
+e devolve o resto para a lista livre. As caches apontam para nós que podem ter saído, então são zeradas. */
+static inline void rbCollect(RbManager *m)
+{
+    size_t used = atomic_load(&m->bump);
+    uint8_t *mark = (uint8_t *)calloc(used, sizeof(uint8_t));
+    uint32_t *freeList = (uint32_t *)realloc(m->freeList, used * sizeof(uint32_t));
+    if (mark == NULL || freeList == NULL) {
+        free(mark);
+        if (freeList) m->freeList = freeList;
+        return; // Sem memória para coletar agora; segue crescendo
+    }
+    m->freeList = freeList;
+
+    mark[0] = 1;
+    for (size_t k = 1; k < used; k++) {
+        if (atomic_load_explicit(&m->nodes[k].ref, memory_order_relaxed) > 0) rbMark(m, mark, &m->nodes[k]);
+    }
+
+    memset((void *)m->slots, 0, (m->slotMask + 1) * sizeof(*m->slots));
+    size_t live = 1;
+    m->freeCount = 0;
+    for (size_t k = 1; k < used; k++) {
+        RbNode *node = &m->nodes[k];
+        if (!mark[k]) {
+            atomic_store_explicit(&node->ref, 0, memory_order_relaxed);
+            m->freeList[m->freeCount++] = (uint32_t)k;
+            continue;
+        }
+        size_t h = rbHash(node->index, node->high, node->low) & m->slotMask;
+        while (atomic_load_explicit(&m->slots[h], memory_order_relaxed) != NULL) h = (h + 1) & m->slotMask;
+        atomic_store_explicit(&m->slots[h], node, memory_order_relaxed);
+        live++;
+    }
+    atomic_store(&m->live, live);
+    atomic_store(&m->freeCursor, 0);
+    free(mark);
+
+    for (int t = 0; t < m->cacheCount; t++) {
+        if (m->caches[t]) memset(m->caches[t], 0, ((size_t)1 << ROBDD_LOG_CACHE) * sizeof(RbCacheEntry));
+    }
+}
+
+// Chamado sem nenhuma thread combinando. Coleta quando mais da metade da capacidade já foi usada
+static inline void rbSafePoint(RbManager *m)
+{
+    size_t reused = atomic_load(&m->freeCursor);
+    if (reused > m->freeCount) reused = m->freeCount;
+    size_t available = (m->maxNodes - atomic_load(&m->bump)) + (m->freeCount - reused);
+    if (available < m->maxNodes / 2) rbCollect(m);
+}
+
+// Fração das atribuições que levam ao um, a partir do nó regular
+static inline double rbMinterms(RbManager *m, RbNode *node, double *memo, uint8_t *done)
+{
+    if (node->index == ROBDD_CONST_INDEX) return 1.0;
+    size_t k = (size_t)(node - m->nodes);
+    if (done[k]) return memo[k];
+    double high = rbMinterms(m, node->high, memo, done);
+    double low = rbMinterms(m, rbRegular(node->low), memo, done);
+    if (rbIsComplement(node->low)) low = 1.0 - low;
+    memo[k] = (high + low) / 2.0;
+    done[k] = 1;
+    return memo[k];
+}
+
+// Equivalente enxuto do Cudd_PrintDebug: número de nós e de mintermos sobre n variáveis
+static inline int rbPrintDebug(RbManager *m, RbNode *f, int n, int pr)
+{
+    if (pr <= 0) return 1;
+    size_t used = atomic_load(&m->bump);
+    uint8_t *mark = (uint8_t *)calloc(used, sizeof(uint8_t));
+    double *memo = (double *)malloc(used * sizeof(double));
+    uint8_t *done = (uint8_t *)calloc(used, sizeof(uint8_t));
+    if (mark == NULL || memo == NULL || done == NULL) {
+        free(mark);
+        free(memo);
+        free(done);
+        return 0;
+    }
+    rbMark(m, mark, rbRegular(f));
+    size_t count = 0;
+    for (size_t k = 0; k < used; k++) count += mark[k];
+
+    double fraction = rbMinterms(m, rbRegular(f), memo, done);
+    if (rbIsComplement(f)) fraction = 1.0 - fraction;
+    double minterms = fraction;
+    for (int v = 0; v < n; v++) minterms *= 2.0;
+    printf(": %zu nodes 1 leaves %g minterms\n", count, minterms);
+
+    free(mark);
+    free(memo);
+    free(done);
+    return 1;
+}
+
+#endif
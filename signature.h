@@ -0,0 +1,112 @@
+#ifndef SIGNATURE_H
+#define SIGNATURE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "bdd.h"
+
+/* Assinatura por simulação para o backend BDD (objetivos acima de TT_MAX_VARS variáveis).
+A assinatura de f é o valor de f em SIG_BITS vetores de entrada aleatórios fixos, um bit por vetor, então a assinatura
+de f*g é sig(f) & sig(g), a de f+g é sig(f) | sig(g) e a de !f é ~sig(f): as funções dos buckets ganham a assinatura
+de graça a partir das dos pais, e só o bucket 1 e o objetivo são avaliados com Cudd_Eval.
+A assinatura só refuta: se algum vetor tem f = 1 e g = 0, f <= g é falso sem chamar o Cudd_bddLeq (que no CUDD roda
+sob trava). Assinaturas iguais não provam nada, então a deduplicação continua exata, pela chave do BDD. */
+#define SIG_WORDS 4
+#define SIG_BITS (SIG_WORDS * 64)
+#define SIG_SEED 0x9e3779b97f4a7c15ULL
+
+typedef struct {
+    uint64_t w[SIG_WORDS];
+} Signature;
+
+static bool sigEnabled = false;
+static int sigVarCount = 0;
+static int *sigInputs = NULL; //SIG_BITS vetores de sigVarCount entradas, no formato do Cudd_Eval
+static Signature sigObjective;
+
+static inline uint64_t sigRandom(uint64_t *state)
+{
+    // xorshift64*: a mesma sequência em toda execução
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dULL;
+}
+
+// Avalia f nos vetores fixos. Só lê o BDD
+static inline Signature sigEvaluate(DdManager *manager, DdNode *f)
+{
+    Signature s = {{0}};
+    for (int b = 0; b < SIG_BITS; b++) {
+        if (Cudd_Eval(manager, f, &sigInputs[b * sigVarCount]) == Cudd_ReadOne(manager)) s.w[b / 64] |= (uint64_t)1 << (b % 64);
+    }
+    return s;
+}
+
+// Sorteia os vetores (variável i é a do Cudd_bddIthVar(manager, i) do parse) e calcula a assinatura do objetivo
+static inline void sigInit(DdManager *manager, DdNode *objectiveExp, int varCount)
+{
+    free(sigInputs);
+    sigVarCount = varCount > 0 ? varCount : 1;
+    sigInputs = (int *)malloc((size_t)SIG_BITS * sigVarCount * sizeof(int));
+    if (sigInputs == NULL) {
+        fprintf(stderr, "Erro ao alocar os vetores de simulação\n");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t state = SIG_SEED;
+    for (int b = 0; b < SIG_BITS; b++) {
+        uint64_t bits = 0;
+        for (int v = 0; v < sigVarCount; v++) {
+            if (v % 64 == 0) bits = sigRandom(&state);
+            sigInputs[b * sigVarCount + v] = (bits >> (v % 64)) & 1;
+        }
+    }
+    sigObjective = sigEvaluate(manager, objectiveExp);
+    sigEnabled = true;
+}
+
+static inline void sigFree(void)
+{
+    free(sigInputs);
+    sigInputs = NULL;
+    sigEnabled = false;
+}
+
+static inline Signature sigNotCond(Signature s, bool negate)
+{
+    if (negate) {
+        for (int w = 0; w < SIG_WORDS; w++) s.w[w] = ~s.w[w];
+    }
+    return s;
+}
+
+static inline Signature sigCombine(const Signature *a, const Signature *b, bool isAnd)
+{
+    Signature s;
+    for (int w = 0; w < SIG_WORDS; w++) s.w[w] = isAnd ? (a->w[w] & b->w[w]) : (a->w[w] | b->w[w]);
+    return s;
+}
+
+/* false quando as assinaturas já provam que (a ^ negA) <= (b ^ negB) é falso. Sem assinatura (NULL) não prova nada.
+As quatro combinações de polaridade cobrem as regras do pré-filtro: implicação, disjuntos (f <= !g) e cobertura (!f <= g) */
+static inline bool sigMayLeq(const Signature *a, bool negA, const Signature *b, bool negB)
+{
+    if (a == NULL || b == NULL) return true;
+    uint64_t flipA = negA ? ~(uint64_t)0 : 0, flipB = negB ? ~(uint64_t)0 : 0;
+    for (int w = 0; w < SIG_WORDS; w++) {
+        if ((a->w[w] ^ flipA) & ~(b->w[w] ^ flipB)) return false;
+    }
+    return true;
+}
+
+// Resíduo do goal check (g & !f no lado AND, f & !g no lado OR), mesma conta do goalcheck.h
+static inline Signature sigResidue(const Signature *g, bool andSide)
+{
+    Signature s;
+    for (int w = 0; w < SIG_WORDS; w++) s.w[w] = andSide ? (g->w[w] & ~sigObjective.w[w]) : (sigObjective.w[w] & ~g->w[w]);
+    return s;
+}
+
+#endif
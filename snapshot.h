@@ -0,0 +1,267 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bucket.h"
+#include "dedup.h"
+#include "cachedir.h"
+
+/* Snapshot em disco dos buckets completos (só no backend de tabela verdade). Sem contar o objetivo, o bucket k só depende
+do bucket 1 (variáveis e polaridades que sobraram do filtro de unate, e a dobra): o pré-filtro e a deduplicação não olham
+o objetivo, e uma ordem só é publicada se nenhum acerto a interrompeu. Então objetivos com o mesmo bucket 1 montam os
+mesmos buckets, e cada ordem que termina é gravada num arquivo por bucket 1
+(<pasta do cache>/buckets_<variáveis>v_<hash do bucket 1>.snap).
+Na partida o arquivo é mapeado somente leitura e as colunas dos buckets apontam direto para o mapeamento (Bucket.mapped),
+sem cópia nenhuma; as ordens carregadas só passam pelo goal check (ou pela procura do objetivo no modo c).
+Formato (BUCKET_SNAPSHOT_VERSION): cabeçalho, o tamanho de cada ordem e, por ordem, as colunas tt, left, right,
+leftOrder e op do Bucket, cada uma começando em múltiplo de 8 bytes. O bucket 1 vai junto só para conferir que o
+arquivo é do mesmo bucket 1 (os nomes das variáveis são sempre os do objetivo atual).
+O arquivo novo é escrito ao lado e trocado com rename, então quem tem o antigo mapeado não é afetado.
+No BDD a chave é o ponteiro do nó, que não sobrevive à execução, então lá não há snapshot.
+Só liga com a pasta do cache definida (cachedir.h), e o arquivo entra no limite de tamanho dela: a ordem que não cabe
+não é gravada, nem as seguintes. Compilar com -DNO_BUCKET_SNAPSHOT desliga de vez. */
+#define BUCKET_SNAPSHOT_MAGIC "TCCBSNAP"
+#define BUCKET_SNAPSHOT_VERSION 1
+#define BUCKET_SNAPSHOT_PATH_MAX 256
+
+#ifdef NO_BUCKET_SNAPSHOT
+#define BUCKET_SNAPSHOT_ENABLED 0
+#else
+#define BUCKET_SNAPSHOT_ENABLED 1
+#endif
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t varCount;
+    uint32_t orders; //Buckets 1..orders, seguidos de orders tamanhos em uint64_t
+    uint32_t folded; //foldComplements de quem gravou
+    uint64_t firstBucketHash;
+} BucketSnapshotHeader;
+
+typedef struct {
+    char path[BUCKET_SNAPSHOT_PATH_MAX];
+    uint64_t hash;
+    int varCount;
+    int orders; //Maior ordem no arquivo (lida ou gravada nesta execução)
+    bool full; //Uma ordem não coube no limite da pasta: as próximas também não são gravadas
+    int loaded; //Maior ordem cujas colunas apontam para o mapeamento
+    void *map;
+    size_t mapSize;
+} BucketSnapshot;
+
+static inline size_t bucketSnapshotAlign(size_t bytes)
+{
+    return (bytes + 7) & ~(size_t)7;
+}
+
+static inline size_t bucketSnapshotOrderBytes(uint64_t size)
+{
+    return bucketSnapshotAlign(size * sizeof(TruthTable)) + 2 * bucketSnapshotAlign(size * sizeof(uint32_t)) +
+           2 * bucketSnapshotAlign(size * sizeof(uint8_t));
+}
+
+static inline size_t bucketSnapshotTableBytes(int orders)
+{
+    return bucketSnapshotAlign(sizeof(BucketSnapshotHeader) + (size_t)orders * sizeof(uint64_t));
+}
+
+// FNV-1a do que define os buckets: variáveis, dobra e as colunas tt e op do bucket 1
+static inline uint64_t bucketSnapshotHash(const Bucket *first, int varCount)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint64_t words[2] = {(uint64_t)varCount, (uint64_t)foldComplements};
+    for (int w = 0; w < 2; w++) hash = (hash ^ words[w]) * 0x100000001b3ULL;
+    for (int k = 0; k < first->size; k++) {
+        hash = (hash ^ first->tt[k]) * 0x100000001b3ULL;
+        hash = (hash ^ first->op[k]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Aponta as colunas do bucket para a ordem que começa em base (o bucket não pode crescer depois disso)
+static inline const char *bucketSnapshotAttach(Bucket *bucket, int order, uint64_t size, const char *base)
+{
+    bucket->tt = (TruthTable *)base;
+    base += bucketSnapshotAlign(size * sizeof(TruthTable));
+    bucket->left = (uint32_t *)base;
+    base += bucketSnapshotAlign(size * sizeof(uint32_t));
+    bucket->right = (uint32_t *)base;
+    base += bucketSnapshotAlign(size * sizeof(uint32_t));
+    bucket->leftOrder = (uint8_t *)base;
+    base += bucketSnapshotAlign(size * sizeof(uint8_t));
+    bucket->op = (uint8_t *)base;
+    base += bucketSnapshotAlign(size * sizeof(uint8_t));
+    bucket->order = order;
+    bucket->size = (int)size;
+    bucket->capacity = (int)size;
+    bucket->mapped = true;
+    return base;
+}
+
+/* Procura o snapshot do bucket 1 atual e mapeia as ordens 2..numBuckets que ele tiver, já inserindo as chaves no
+conjunto de duplicatas. Sem arquivo (ou com um incompatível) nada muda e a busca começa do zero. Retorna a maior ordem
+carregada (1 = nenhuma) */
+static inline int bucketSnapshotOpen(BucketSnapshot *snapshot, Bucket *buckets, int numBuckets, int varCount, SeenSet *uniqueCheck)
+{
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->varCount = varCount;
+    snapshot->hash = bucketSnapshotHash(&buckets[0], varCount);
+    snapshot->loaded = 1;
+    snprintf(snapshot->path, sizeof(snapshot->path), "%s/buckets_%dv_%016llx.snap", cacheDir(), varCount,
+             (unsigned long long)snapshot->hash);
+
+    int fd = open(snapshot->path, O_RDONLY);
+    if (fd < 0) return 1; // Primeira execução com esse bucket 1
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BucketSnapshotHeader)) {
+        fprintf(stderr, "Snapshot %s com tamanho inválido, ignorado\n", snapshot->path);
+        close(fd);
+        return 1;
+    }
+    size_t mapSize = (size_t)st.st_size;
+    void *map = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Erro no mmap do snapshot");
+        return 1;
+    }
+
+    const BucketSnapshotHeader *header = (const BucketSnapshotHeader *)map;
+    const uint64_t *sizes = (const uint64_t *)((const char *)map + sizeof(BucketSnapshotHeader));
+    bool valid = memcmp(header->magic, BUCKET_SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == BUCKET_SNAPSHOT_VERSION && header->varCount == (uint32_t)varCount &&
+                 header->folded == (uint32_t)foldComplements && header->firstBucketHash == snapshot->hash &&
+                 header->orders >= 1 && bucketSnapshotTableBytes(header->orders) <= mapSize;
+    size_t expected = valid ? bucketSnapshotTableBytes(header->orders) : 0;
+    for (uint32_t o = 0; valid && o < header->orders; o++) expected += bucketSnapshotOrderBytes(sizes[o]);
+    valid = valid && expected == mapSize && sizes[0] == (uint64_t)buckets[0].size;
+
+    // O hash só escolhe o arquivo: o bucket 1 tem que ser igual de verdade
+    const char *base = (const char *)map + (valid ? bucketSnapshotTableBytes(header->orders) : 0);
+    if (valid) {
+        Bucket first = {0};
+        bucketSnapshotAttach(&first, 1, sizes[0], base);
+        valid = memcmp(first.tt, buckets[0].tt, sizes[0] * sizeof(TruthTable)) == 0 &&
+                memcmp(first.op, buckets[0].op, sizes[0] * sizeof(uint8_t)) == 0;
+    }
+    if (!valid) {
+        fprintf(stderr, "Snapshot %s com formato ou versão incompatível, ignorado\n", snapshot->path);
+        munmap(map, mapSize);
+        return 1;
+    }
+
+    snapshot->map = map;
+    snapshot->mapSize = mapSize;
+    snapshot->orders = (int)header->orders;
+    int load = (snapshot->orders < numBuckets) ? snapshot->orders : numBuckets;
+    size_t total = 0;
+    for (int o = 2; o <= load; o++) total += sizes[o - 1];
+    seenSetReserve(uniqueCheck, total);
+
+    base += bucketSnapshotOrderBytes(sizes[0]);
+    for (int o = 2; o <= load; o++) {
+        Bucket *bucket = &buckets[o - 1];
+        base = bucketSnapshotAttach(bucket, o, sizes[o - 1], base);
+        for (int k = 0; k < bucket->size; k++) seenSetInsert(uniqueCheck, bucket->tt[k]);
+    }
+    snapshot->loaded = load;
+    if (load > 1) printf("Snapshot: ordens 2 a %d de %s\n", load, snapshot->path);
+    return load;
+}
+
+static inline bool bucketSnapshotWriteColumn(FILE *file, const void *column, size_t bytes)
+{
+    static const char padding[8] = {0};
+    size_t pad = bucketSnapshotAlign(bytes) - bytes;
+    return (bytes == 0 || fwrite(column, 1, bytes, file) == bytes) && (pad == 0 || fwrite(padding, 1, pad, file) == pad);
+}
+
+/* Grava os buckets 1..order se a ordem acabou de ser publicada e o arquivo ainda não a tem. Falha na gravação só
+avisa: a busca não depende do snapshot */
+static inline void bucketSnapshotSave(BucketSnapshot *snapshot, Bucket *buckets, int order)
+{
+    if (snapshot->full || order <= snapshot->orders || buckets[order - 1].order != order) return;
+    uint64_t bytes = bucketSnapshotTableBytes(order);
+    for (int o = 1; o <= order; o++) bytes += bucketSnapshotOrderBytes((uint64_t)buckets[o - 1].size);
+    if (!cacheDirFits(snapshot->path, bytes)) {
+        snapshot->full = true;
+        return;
+    }
+
+    char temporary[BUCKET_SNAPSHOT_PATH_MAX + 32];
+    snprintf(temporary, sizeof(temporary), "%s.%d.tmp", snapshot->path, (int)getpid());
+    FILE *file = fopen(temporary, "wb");
+    if (file == NULL) {
+        perror("Erro ao criar o snapshot");
+        return;
+    }
+    BucketSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BUCKET_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = BUCKET_SNAPSHOT_VERSION;
+    header.varCount = (uint32_t)snapshot->varCount;
+    header.orders = (uint32_t)order;
+    header.folded = (uint32_t)foldComplements;
+    header.firstBucketHash = snapshot->hash;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int o = 1; o <= order && ok; o++) {
+        uint64_t size = (uint64_t)buckets[o - 1].size;
+        ok = fwrite(&size, sizeof(size), 1, file) == 1;
+    }
+    size_t tableEnd = sizeof(header) + (size_t)order * sizeof(uint64_t);
+    static const char padding[8] = {0};
+    if (ok && bucketSnapshotTableBytes(order) > tableEnd) {
+        ok = fwrite(padding, 1, bucketSnapshotTableBytes(order) - tableEnd, file) == bucketSnapshotTableBytes(order) - tableEnd;
+    }
+    for (int o = 1; o <= order && ok; o++) {
+        const Bucket *bucket = &buckets[o - 1];
+        size_t n = (size_t)bucket->size;
+        ok = bucketSnapshotWriteColumn(file, bucket->tt, n * sizeof(TruthTable)) &&
+             bucketSnapshotWriteColumn(file, bucket->left, n * sizeof(uint32_t)) &&
+             bucketSnapshotWriteColumn(file, bucket->right, n * sizeof(uint32_t)) &&
+             bucketSnapshotWriteColumn(file, bucket->leftOrder, n * sizeof(uint8_t)) &&
+             bucketSnapshotWriteColumn(file, bucket->op, n * sizeof(uint8_t));
+    }
+    if (fclose(file) != 0) ok = false;
+    if (!ok || rename(temporary, snapshot->path) != 0) {
+        fprintf(stderr, "Erro ao gravar o snapshot %s\n", snapshot->path);
+        unlink(temporary);
+        return;
+    }
+    snapshot->orders = order;
+}
+
+// Ordem carregada no modo c: o bucket já está completo, só falta ver se o objetivo está nele
+static inline bool bucketSnapshotFindObjective(Bucket *buckets, int order, DdNode *objectiveExp)
+{
+    Bucket *bucket = &buckets[order - 1];
+    for (int k = 0; k < bucket->size; k++) {
+        if (bucketIsObjective(bucket, k, objectiveExp)) {
+            printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", order);
+            printBucketFunction(buckets, order, bucketObjectiveRef(bucket, k, objectiveExp));
+            printf("\n");
+            printf("No de literais: %d\n", order);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Desfaz o mapeamento. Chamar depois do freeAllBuckets (as colunas mapeadas não são liberadas por ele)
+static inline void bucketSnapshotClose(BucketSnapshot *snapshot)
+{
+    if (snapshot->map) munmap(snapshot->map, snapshot->mapSize);
+    snapshot->map = NULL;
+}
+
+#endif
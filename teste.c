@@ -2,42 +2,30 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
-#include <cudd.h>
+#include "bdd.h"
 #include <st.h>
 #include <omp.h> 
-
-typedef enum{
-    VAR,
-    NOT,
-    AND,
-    OR
-} OpType;
-
-typedef struct Function
-{
-    DdNode *bdd;
-    struct Function *left;
-    struct Function *right;
-    OpType operador;
-    char varName; //Apenas se operador == VAR
-} Function;
-
-typedef struct
-{
-    Function **functions;
-    int order;
-    int size;
-} Bucket;
-
-typedef struct {
-    Function *f1;
-    Function *f2;
-    DdNode *bdd;
-    char op;
-} CombinationBuffer;
-
-
-
+#include "bucket.h"
+#include "dedup.h"
+#include "litdb.h"
+#include "goalcheck.h"
+#include "topdown.h"
+#include "batch.h"
+#include "pairspace.h"
+#include "ttkernel.h"
+#include "prefilter.h"
+#include "npncache.h"
+#include "dsd.h"
+#include "bounds.h"
+#include "snapshot.h"
+#include "checkpoint.h"
+
+// Backend por tabela verdade: ativado quando o objetivo tem até TT_MAX_VARS variáveis
+bool useTruthTable = false;
+TruthTable objectiveTt = 0;
+TruthTable fullTt = 0;
+// Dobra de complementos (bucket.h): ligada quando o bucket 1 fecha por complemento
+bool foldComplements = false;
 
 
 //Adicionar apenas os literais no objetivo, remover as negações desnecessárias
@@ -47,7 +35,7 @@ typedef struct {
 // Função para adicionar um novo bucket
 Bucket *addBucket(Bucket *buckets, int *numBuckets);
 // Imprimir o bucket para fins de debug
-void printBucket(DdManager *manager, Bucket bucket, int varCount);
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount);
 // Função para liberar memória alocada
 // void freeAll(Bucket *buckets, int numBuckets);
 void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets);
@@ -64,17 +52,15 @@ DdNode *evaluatePostfix(DdManager *manager, char **postfix, int count, Function
 // Analisa a expressão infixada de entrada, converte para pós-fixada, e retorna o BDD resultante
 DdNode *parseInputExpression(DdManager *manager, const char *input, Function **outVarMap, int *outVarCount, int *literalCount);
 // Gera o bucket 1 com base no varMap retornado por parseInputExpression
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck);
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck);
 // Combina dois BDDs com AND, OR ou NOT
 DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operator);
 // Função para criar um novo bucket de ordem l realizando todas as combinações possíveis entre todos os buckets de ordem n + m = l
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice);
-// Criar um novo nó caso seja variável
-Function* varNode(char varName, DdNode *bdd);
-//Criar um novo nó caso seja operador
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd);
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
 //Printar a implementação
 void printFunction(Function* node);
+//Gera a tabela pré-computada de 4 variáveis (litdb.h)
+int generateLiteralDb(DdManager *manager, const char *path);
 
 int main(int argc, char *argv[])
 {
@@ -82,8 +68,11 @@ int main(int argc, char *argv[])
 
     if (argc < 3)
     {
-        fprintf(stderr, "Uso: %s <expressão> <modo>\n", argv[0]);
-        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n");
+        fprintf(stderr, "Uso: %s <expressão> <modo> [tabela] [--resume]\n", argv[0]);
+        fprintf(stderr, "Modos disponíveis:\n e - parar ao encontrar equivalência\n c - completar o bucket final\n d - consultar a tabela pré-computada (até 4 variáveis, padrão %s)\n t - busca top-down a partir do objetivo (até %d variáveis)\n", LITDB_DEFAULT_PATH, TT_MAX_VARS);
+        fprintf(stderr, "Para vários alvos (um por linha): %s --batch <arquivo>\n", argv[0]);
+        fprintf(stderr, "Cache NPN e snapshots entre execuções (desligados por padrão): %s=<pasta> [%s=<MB>]\n", CACHE_DIR_ENV, CACHE_DIR_MAX_ENV);
+        fprintf(stderr, "Para gerar a tabela: %s --gen-db <arquivo>\n", argv[0]);
         return EXIT_FAILURE;
     }
     DdManager *manager = Cudd_Init(0, 0, CUDD_UNIQUE_SLOTS, CUDD_CACHE_SLOTS, 0);
@@ -93,20 +82,29 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
-    //tabela hash para verificar duplicatas, migrada para cá pra permitir verificação entre buckets
-    st_table *uniqueCheck = st_init_table(st_ptrcmp, st_ptrhash);
-    if (uniqueCheck == NULL)
-    {
-        fprintf(stderr, "Erro ao criar tabela hash ST\n");
+    if (strcmp(argv[1], "--gen-db") == 0) {
+        int status = generateLiteralDb(manager, argv[2]);
         Cudd_Quit(manager);
-        return EXIT_FAILURE;
+        return status;
+    }
+
+    if (strcmp(argv[1], "--batch") == 0) {
+        int status = runBatch(manager, argv[2]);
+        Cudd_Quit(manager);
+        return status;
     }
+
     char choice = argv[2][0];
 
-    if (choice != 'e' && choice != 'c') {
-        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e' ou 'c'.\n", choice);
+    if (choice != 'e' && choice != 'c' && choice != 'd' && choice != 't') {
+        fprintf(stderr, "Erro: Modo inválido '%c'. Use 'e', 'c', 'd' ou 't'.\n", choice);
         return EXIT_FAILURE;
     }
+    // --resume: continua do checkpoint de uma execução interrompida (checkpoint.h)
+    bool resume = false;
+    for (int a = 3; a < argc; a++) {
+        if (strcmp(argv[a], "--resume") == 0) resume = true;
+    }
 
     int numBuckets = 0;
     bool found = false;
@@ -121,14 +119,12 @@ int main(int argc, char *argv[])
     if (objectiveExp == NULL)
     {
         fprintf(stderr, "Erro ao parsear a expressão.\n");
-        st_free_table(uniqueCheck);
         Cudd_Quit(manager);
         return EXIT_FAILURE;
     }
     //Esqueci que tautologias e contradições existem, então adicionei só agora kkkkk
     if(objectiveExp == Cudd_ReadLogicZero(manager)) {
         printf("A expressão é uma contradição (Sempre falsa).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
@@ -136,7 +132,6 @@ int main(int argc, char *argv[])
     }
     if(objectiveExp == Cudd_ReadOne(manager)) {
         printf("A expressão é uma tautologia (Sempre verdadeira).\n");
-        st_free_table(uniqueCheck);
         if (varMap) free(varMap);
         Cudd_RecursiveDeref(manager, objectiveExp);
         Cudd_Quit(manager);
@@ -144,40 +139,165 @@ int main(int argc, char *argv[])
     }
     Cudd_PrintDebug(manager, objectiveExp, varCount, 2);
 
+    // Com poucas variáveis o CUDD só serve para o parse, o resto roda sobre tabelas verdade
+    if (varCount <= TT_MAX_VARS) {
+        useTruthTable = true;
+        fullTt = ttFullMask(varCount);
+        objectiveTt = bddToTruthTable(manager, objectiveExp, varCount);
+        printf("Backend: tabela verdade (%d variáveis)\n", varCount);
+    }
+
+    // Modo d: a resposta já está na tabela, não precisa de bucket nenhum
+    if (choice == 'd') {
+        int status = litDbQuery(argc > 3 ? argv[3] : LITDB_DEFAULT_PATH, objectiveTt, varCount, varMap);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return status;
+    }
+    if (choice == 't' && !useTruthTable) {
+        fprintf(stderr, "Erro: o modo t só funciona com até %d variáveis (objetivo tem %d).\n", TT_MAX_VARS, varCount);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+
+    // Cache NPN: objetivo equivalente a um já resolvido (a menos de permutação e negações) não passa pela busca
+    NpnCache npnCache;
+    char varNames[TT_MAX_VARS + 1] = {0};
+    bool npnActive = npnCacheActive() && useTruthTable && (choice == 'e' || choice == 'c');
+    if (npnActive) {
+        for (int i = 0; i < varCount; i++) varNames[i] = varMap[i].varName;
+        npnCacheLoad(&npnCache, NPN_CACHE_DEFAULT_PATH);
+        if (npnCacheReport(&npnCache, objectiveTt, varCount, varNames)) {
+            npnCacheFree(&npnCache);
+            Cudd_RecursiveDeref(manager, objectiveExp);
+            for (int i = 0; i < varCount; i++) {
+                if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+            }
+            free(varMap);
+            Cudd_Quit(manager);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    // Decomposição disjunta: objetivo que quebra em blocos de variáveis separadas é resolvido bloco a bloco
+    if ((choice == 'e' || choice == 'c') && dsdReport(manager, objectiveExp, varMap, varCount, literalCount, npnActive ? &npnCache : NULL)) {
+        if (npnActive) npnCacheFree(&npnCache);
+        Cudd_RecursiveDeref(manager, objectiveExp);
+        for (int i = 0; i < varCount; i++) {
+            if (varMap[i].bdd) Cudd_RecursiveDeref(manager, varMap[i].bdd);
+        }
+        free(varMap);
+        Cudd_Quit(manager);
+        return EXIT_SUCCESS;
+    }
+
+    //Conjunto para verificar duplicatas entre buckets. A representação depende do backend, então só é criado depois do parse
+    SeenSet *uniqueCheck = seenSetCreate(useTruthTable, varCount);
+    if (uniqueCheck == NULL)
+    {
+        fprintf(stderr, "Erro ao criar o conjunto de duplicatas\n");
+        Cudd_Quit(manager);
+        return EXIT_FAILURE;
+    }
+    printf("Dedup: %s\n", seenSetDescription(uniqueCheck));
+    if (useTruthTable) printf("Kernel: %s\n", ttCombineKernelName());
+    else {
+        // Fora do alcance da tabela verdade: assinaturas por simulação para evitar testes exatos no BDD
+        sigInit(manager, objectiveExp, varCount);
+        printf("Assinaturas: %d vetores de simulação\n", SIG_BITS);
+    }
+
     double start_time = omp_get_wtime();
 
+    // Limites da busca: abaixo do inferior não existe fórmula e a incumbente já é uma resposta com upper literais
+    int searchLimit = literalCount;
+    Bounds bounds = {0, 0, "", false};
+    BucketSnapshot snapshot = {0};
+    if (choice == 'e' || choice == 'c') {
+        boundsCompute(manager, objectiveExp, varMap, varCount, argv[1], literalCount, &bounds);
+        if (bounds.upper > 0) searchLimit = bounds.upper - 1;
+    }
+
     buckets = addBucket(buckets, &numBuckets);
-    initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    if (bounds.upper > 0 && bounds.lower >= bounds.upper) {
+        // Os limites se encontraram: nenhum bucket precisa ser montado
+        if (npnActive) bucketEchoBegin();
+        boundsReportIncumbent(&bounds);
+        found = true;
+    } else {
+        initializeFirstBucket(manager, varMap, varCount, &buckets[0], objectiveExp, &found, uniqueCheck);
+    }
+    if (!found && choice != 't') {
+        foldComplements = bucketFoldLiterals(manager, &buckets[0]);
+        if (foldComplements) printf("Dobra de complementos: ativa (%d representantes no bucket 1)\n", buckets[0].size);
+    }
     if (!found) {
 
-    printBucket(manager, buckets[0], varCount);
+    printBucket(manager, buckets, 1, varCount);
+    if (npnActive) bucketEchoBegin(); // A expressão do resultado vai para o cache NPN
 
     // Inicializa todos os buckets que poderão ser usados nesta execução do programa
-    while (numBuckets < literalCount)
+    while (numBuckets < searchLimit)
     {
         buckets = addBucket(buckets, &numBuckets);
     }
-    for (int order = 2; order <= literalCount; order++)
+    // Ordens que já estão no snapshot deste bucket 1 (snapshot.h) não são montadas de novo
+    bool snapshotActive = BUCKET_SNAPSHOT_ENABLED && cacheDir() != NULL && useTruthTable && (choice == 'e' || choice == 'c');
+    if (snapshotActive) bucketSnapshotOpen(&snapshot, buckets, numBuckets, varCount, uniqueCheck);
+    if (snapshotActive) checkpointInit(&snapshot, buckets, resume);
+    else if (resume) fprintf(stderr, "--resume ignorado: checkpoint só existe com %s, a tabela verdade e os modos e e c\n", CACHE_DIR_ENV);
+    if (choice == 't') {
+        // Motor top-down: só monta os buckets até a metade do orçamento
+        found = topDownSearch(manager, buckets, numBuckets, varCount, objectiveExp, uniqueCheck, false);
+    }
+    for (int order = 2; order <= searchLimit && choice != 't'; order++)
     {
   
         found = createCombinedBucket(manager, buckets, numBuckets, order, objectiveExp, uniqueCheck, choice);
         if (found) break; // Sai do loop se encontrou a equivalência
+        if (snapshotActive) {
+            bucketSnapshotSave(&snapshot, buckets, order);
+            checkpointOrderPublished(order);
+            if (checkpointStopRequested() && order < searchLimit) checkpointExitAfterOrder(order);
+        }
         //printBucket(manager, buckets[order - 1], varCount);
         
     }
+    if (!found && bounds.upper > 0) {
+        // Nada com menos literais que a incumbente
+        boundsReportIncumbent(&bounds);
+        found = true;
+    }
     }
     if (!found) {
-        printf("Nenhuma equivalência encontrada até a ordem %d.\n", literalCount);
+        printf("Nenhuma equivalência encontrada até a ordem %d.\n", searchLimit);
     }
 
     double end_time = omp_get_wtime();
+    if (npnActive) {
+        const char *resultExpression = bucketEchoEnd();
+        if (found && !bounds.reported) npnCacheRecord(&npnCache, objectiveTt, varCount, varNames, resultExpression);
+        npnCacheFree(&npnCache);
+    }
 
     // Após o uso, libera a hash
-    st_free_table(uniqueCheck);
+    seenSetFree(uniqueCheck);
+    sigFree();
 
 
     Cudd_RecursiveDeref(manager, objectiveExp);
     freeAllBuckets(manager, buckets, numBuckets);
+    checkpointFinish();
+    bucketSnapshotClose(&snapshot);
 
     if (varMap != NULL) {
         for (int i = 0; i < varCount; i++) {
@@ -246,9 +366,7 @@ Bucket *addBucket(Bucket *buckets, int *numBuckets)
         fprintf(stderr, "Erro ao realocar memória para buckets.\n");
         exit(EXIT_FAILURE);
     }
-    buckets[(*numBuckets) - 1].order = 0;
-    buckets[(*numBuckets) - 1].functions = NULL;
-    buckets[(*numBuckets) - 1].size = 0;
+    memset(&buckets[(*numBuckets) - 1], 0, sizeof(Bucket));
     return buckets;
 }
 /*
@@ -264,15 +382,16 @@ void printBucket(Bucket bucket) {
 }
 */
 
-void printBucket(DdManager *manager, Bucket bucket, int varCount)
+void printBucket(DdManager *manager, Bucket *buckets, int order, int varCount)
 {
-    printf("Bucket Order: %d | Size: %d\n", bucket.order, bucket.size);
-    if (bucket.functions != NULL)
+    Bucket *bucket = &buckets[order - 1];
+    printf("Bucket Order: %d | Size: %d\n", bucket->order, bucket->size);
+    if (bucket->size > 0)
     {
-        for (int i = 0; i < bucket.size; i++)
+        for (int i = 0; i < bucket->size; i++)
         {
             printf("  Function[%d]:", i);
-            printFunction(bucket.functions[i]);
+            printBucketFunction(buckets, order, i);
             printf("\n");
             //Cudd_PrintDebug(manager, bucket.functions[i], varCount, 2);
         }
@@ -300,23 +419,16 @@ void freeAllBuckets(DdManager *manager, Bucket *buckets, int numBuckets)
         return;
     for (int i = 0; i < numBuckets; i++)
     {
-        if (buckets[i].functions != NULL)
+        if (buckets[i].bdd != NULL)
         {
             // Dereferencia todas as funções no bucket
             for (int j = 0; j < buckets[i].size; j++)
             {
-                if (buckets[i].functions[j] != NULL)
-                {
-                    
-                    if (buckets[i].functions[j]->bdd) {
-                        Cudd_RecursiveDeref(manager, buckets[i].functions[j]->bdd);
-                    }
-
-                    free(buckets[i].functions[j]);
-                }
+                Cudd_RecursiveDeref(manager, buckets[i].bdd[j]);
             }
-            free(buckets[i].functions); // Libera o array de ponteiros
         }
+        bucketFreeColumns(&buckets[i]); // Libera as colunas
+        goalIndexFree(manager, &buckets[i].goal);
     }
     free(buckets); // Libera o array de buckets
 }
@@ -537,7 +649,7 @@ DdNode *parseInputExpression(DdManager *manager, const char *input, Function **o
     return finalBdd;
 }
 
-/*DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck)
+/*DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck)
 {
     bucket->order = 1;
     bucket->functions = (Function **)malloc(((varCount * 2) + 1) * sizeof(Function *));
@@ -610,54 +722,69 @@ DdNode *parseInputExpression(DdManager *manager, const char *input, Function **o
     return NULL;
 }*/
 
-DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, st_table *uniqueCheck)
+DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount, Bucket *bucket, DdNode *objectiveExp, bool *found, SeenSet *uniqueCheck)
 {
     printf("Inicializando o primeiro bucket...\n");
     bucket->order = 1;
-    bucket->functions = (Function **)malloc(((varCount * 2) + 1) * sizeof(Function *));
-    if (bucket->functions == NULL) exit(EXIT_FAILURE);
+    bucketReserve(bucket, varCount * 2);
 
     int actualSize = 0;
     
     for (int i = 0; i < varCount; i++)
     {
-        DdNode *varBdd = varMap[i].bdd;
+        bool isPosUnate, isNegUnate;
+
+        if (useTruthTable) {
+            // Mesma análise, mas com os cofatores tirados direto da tabela verdade
+            TruthTable cofPos = ttCofactor(objectiveTt, i, true, varCount);
+            TruthTable cofNeg = ttCofactor(objectiveTt, i, false, varCount);
+
+            // Verifica Dependência
+            if (cofPos == cofNeg) continue;
+
+            isPosUnate = ttLeq(cofNeg, cofPos);
+            isNegUnate = ttLeq(cofPos, cofNeg);
+        } else {
+            DdNode *varBdd = varMap[i].bdd;
+
+            // Calcula Cofatores: f(x=1) e f(x=0)
+            DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
+            Cudd_Ref(cofPos);
+            DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
+            Cudd_Ref(cofNeg);
+
+            // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
+            if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
+                Cudd_RecursiveDeref(manager, cofPos);
+                Cudd_RecursiveDeref(manager, cofNeg);
+                continue; 
+            }
 
+            // Verifica Unicidade
+            isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
+            isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
 
-        // Calcula Cofatores: f(x=1) e f(x=0)
-        DdNode *cofPos = Cudd_Cofactor(manager, objectiveExp, varBdd);
-        Cudd_Ref(cofPos);
-        DdNode *cofNeg = Cudd_Cofactor(manager, objectiveExp, Cudd_Not(varBdd));
-        Cudd_Ref(cofNeg);
-        
-        // Verifica Dependência: Se f(1) == f(0), a função não depende da variável
-        if (Cudd_bddLeq(manager, cofPos, cofNeg) && Cudd_bddLeq(manager, cofNeg, cofPos)) {
             Cudd_RecursiveDeref(manager, cofPos);
             Cudd_RecursiveDeref(manager, cofNeg);
-            continue; 
         }
-
-        // Verifica Unicidade
-        bool isPosUnate = Cudd_bddLeq(manager, cofNeg, cofPos); 
-        bool isNegUnate = Cudd_bddLeq(manager, cofPos, cofNeg);
         bool isBinate = !isPosUnate && !isNegUnate;
 
-        Cudd_RecursiveDeref(manager, cofPos);
-        Cudd_RecursiveDeref(manager, cofNeg);
-
         // Adiciona se for positivo unate ou binate
         if (isPosUnate || isBinate) {
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função
-            bucket->functions[actualSize] = varNode(varMap[i].varName, varMap[i].bdd);
+            // Cria a entrada da função
+            if (useTruthTable) {
+                bucketAppendLiteral(bucket, ttVar(i, varCount), NULL, varMap[i].varName, false);
+            } else {
+                Cudd_Ref(varMap[i].bdd);
+                bucketAppendLiteral(bucket, 0, varMap[i].bdd, varMap[i].varName, false);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
-            //logExpressionToFile(bucket->functions[actualSize], 1);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) {
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) {
                 
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 *found = true;
             }
             actualSize++;
@@ -665,21 +792,23 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
 
         // Adiciona se for negativo unate ou binate
         if (isNegUnate || isBinate) {
-            // Temporário para o BDD negado
-            DdNode *notBdd = Cudd_Not(varMap[i].bdd);
-            Cudd_Ref(notBdd);
-            Function *varNodePtr = varNode(varMap[i].varName, varMap[i].bdd);
-            Cudd_Ref(varMap[i].bdd);
-            // Cria o nó da função
-            bucket->functions[actualSize] = opNode(NOT, varNodePtr, NULL, notBdd);
+            if (useTruthTable) {
+                TruthTable varTt = ttVar(i, varCount);
+                bucketAppendLiteral(bucket, ~varTt & fullTt, NULL, varMap[i].varName, true);
+            } else {
+                // BDD negado
+                DdNode *notBdd = Cudd_Not(varMap[i].bdd);
+                Cudd_Ref(notBdd);
+                // Cria a entrada da função
+                bucketAppendLiteral(bucket, 0, notBdd, varMap[i].varName, true);
+            }
             // Insere na tabela hash de verificação
-            st_insert(uniqueCheck, (char *)bucket->functions[actualSize]->bdd, (char *)bucket->functions[actualSize]->bdd);
-            //logExpressionToFile(bucket->functions[actualSize], 1);
+            seenSetInsert(uniqueCheck, bucketKey(bucket, actualSize));
             //Verifica se é solução
-            if (bucket->functions[actualSize]->bdd == objectiveExp) 
+            if (bucketIsObjective(bucket, actualSize, objectiveExp)) 
             {
                 printf("Solução Encontrada (Ordem 1): ");
-                printFunction(bucket->functions[actualSize]);
+                printBucketFunction(bucket, 1, actualSize);
                 printf("\n");
                 *found = true;
             }
@@ -687,7 +816,6 @@ DdNode *initializeFirstBucket(DdManager *manager, Function *varMap, int varCount
         }
     }
 
-    bucket->size = actualSize;
     printf("Primeiro bucket inicializado com %d funções.\n", actualSize);
     return NULL;
 }
@@ -718,32 +846,52 @@ DdNode *combineBdds(DdManager *manager, DdNode *bdd1, DdNode *bdd2, char operato
     return result;
 }
 
-// Função para realizar o realloc quando necessário
-void addFunctionToDynamicArray(Function *func, Function ***array, int *count, int *capacity)
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice)
 {
-    if (*count == *capacity)
-    {
-        // Dobra a capacidade (ou inicializa se for 0)
-        *capacity = (*capacity == 0) ? 256 : (*capacity) * 2;
-        *array = (Function **)realloc(*array, (*capacity) * sizeof(Function *));
-        if (*array == NULL)
-        {
-            fprintf(stderr, "Erro ao realocar array dinâmico de BDDs\n");
-            exit(EXIT_FAILURE);
-        }
+    Bucket *targetBucket = &buckets[targetOrder - 1];
+
+    // Assinaturas dos buckets que vão ser combinados (só no backend BDD): o goal check e o pré-filtro consultam
+    bucketSigEnsure(manager, buckets, targetOrder - 1);
+
+    // No modo e o objetivo é procurado por consulta nos buckets menores, e o bucket só é montado se ainda puder alimentar uma ordem maior
+    if (choice == 'e') {
+        if (goalCheckOrder(manager, buckets, targetOrder, objectiveExp)) return true;
+        if (targetOrder >= numBuckets) return false;
     }
-    (*array)[*count] = func;
-    (*count)++;
-}
 
-bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, st_table *uniqueCheck, char choice)
-{
-    Bucket *targetBucket = &buckets[targetOrder - 1];
-    
-    Function **newFunctions = NULL;
-    int newFuncCount = 0;
-    int newFuncCapacity = 0;
-    for (int i = 0; i < targetOrder - 1; i++)
+    // Bucket mapeado do snapshot: já está completo, só falta procurar o objetivo nele (no modo e o goal check já procurou)
+    if (targetBucket->mapped) return bucketSnapshotFindObjective(buckets, targetOrder, objectiveExp);
+
+    // Nenhuma thread combinando agora: o backend próprio pode coletar os nós mortos da ordem anterior
+    if (!useTruthTable) bddSafePoint(manager);
+
+    // Reserva espaço no conjunto de duplicatas antes de combinar (ninguém está inserindo agora)
+    seenSetReserve(uniqueCheck, predictBucketGrowth(buckets, targetOrder));
+
+    // Sem threads as funções novas entram direto no bucket alvo, que não é lido nesta ordem
+    targetBucket->order = targetOrder;
+    TtCombineKernel combineKernel = ttCombineKernel();
+    TruthTable andOut[TT_KERNEL_LANES], orOut[TT_KERNEL_LANES], negRight[TT_KERNEL_LANES];
+    TruthTable negObjectiveTt = ~objectiveTt & fullTt;
+    int polarities = foldComplements ? 2 : 1; // Com a dobra, b1[k] também combina com o complemento de b2[l]
+    TtComboMask mask;
+    PrefilterStats stats = {0, 0, 0, 0, 0, 0};
+    prefilterBegin();
+
+    // Os espaços de pares saem antes do laço: o checkpoint numera os blocos de todos eles (no corte de quem gravou, se retomado)
+    int chunkWorkers = checkpointWorkers(targetOrder, 1);
+    PairSpace *spaces = (PairSpace *)calloc(targetOrder, sizeof(PairSpace));
+    if (spaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < targetOrder - 1; i++) {
+        int j = targetOrder - buckets[i].order - 1;
+        if (j < i) break;
+        if (buckets[i].size > 0 && buckets[j].size > 0) pairSpaceInit(&spaces[i], buckets[i].size, buckets[j].size, i == j, chunkWorkers);
+    }
+    // Blocos prontos de uma execução interrompida são pulados e as funções deles já entram no bucket alvo
+    CheckpointProgress progress;
+    checkpointBeginOrder(&progress, targetOrder, spaces, targetOrder - 1, chunkWorkers, targetBucket, uniqueCheck);
+
+    for (int i = 0; i < targetOrder - 1 && !checkpointStopRequested(); i++)
     {
         int order1 = buckets[i].order;
         int order2 = targetOrder - order1;
@@ -756,68 +904,148 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
 
         if (b1->size == 0 || b2->size == 0) continue;
 
-        for (int k = 0; k < b1->size; k++)
+        // Mesmo percurso em blocos das versões paralelas, aqui só para o bucket da direita ficar na cache
+        PairSpace *space = &spaces[i];
+        for (int t = 0; t < space->tileCount && !checkpointStopRequested(); t++)
         {
-            int startL = (i == j) ? k : 0;
-            for (int l = startL; l < b2->size; l++)
+            if (checkpointTileDone(&progress, i, t)) continue;
+            const PairTile *tile = &space->tiles[t];
+            for (int k = tile->kBegin; k < tile->kEnd; k++)
             {
-                Function *f1 = b1->functions[k];
-                Function *f2 = b2->functions[l];
-
-                for (int op = 0; op < 2; op++)
-                {
-                    DdNode *newBdd;
-                    char opChar = (op == 0) ? '*' : '+';
-                    newBdd = combineBdds(manager, f1->bdd, f2->bdd, opChar);
-
-                    if (newBdd == NULL) continue;
-
-                    if (newBdd == Cudd_ReadLogicZero(manager) || newBdd == Cudd_ReadOne(manager)) {
-                        Cudd_RecursiveDeref(manager, newBdd);
-                        continue;
-                    }
-
-                    // Parada imediata caso encontre equivalência
-                    if (newBdd == objectiveExp && choice == 'e') {
-                        printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
-                        printf("RESULTADO_LITERAIS: %d\n", targetOrder);
-                        Function *temp = opNode((opChar == '*') ? AND : OR, f1, f2, newBdd);
-                        printf("RESULTADO_EXPRESSAO: ");
-                        printFunction(temp);
-                        printf("\n");
-                        free(temp);
-                        free(newFunctions);
-                        Cudd_RecursiveDeref(manager, newBdd);
-                        return true;
+                int firstL = pairTileFirstCol(space, tile, k);
+                if (useTruthTable) {
+                    // Kernel vetorial: AND e OR de b1[k] contra um trecho inteiro da linha, só as não constantes voltam nas máscaras
+                    for (int l0 = firstL; l0 < tile->lEnd; l0 += TT_KERNEL_LANES) {
+                        int count = (tile->lEnd - l0 < TT_KERNEL_LANES) ? tile->lEnd - l0 : TT_KERNEL_LANES;
+                        for (int pol = 0; pol < polarities; pol++) {
+                            const TruthTable *right = &b2->tt[l0];
+                            if (pol) {
+                                for (int x = 0; x < count; x++) negRight[x] = ~b2->tt[l0 + x] & fullTt;
+                                right = negRight;
+                            }
+                            uint32_t rightFlag = pol ? BUCKET_NEGATED : 0;
+                            combineKernel(b1->tt[k], right, count, fullTt, objectiveTt, andOut, orOut, &mask);
+                            prefilterCountMask(&stats, count, &mask);
+
+                            // Com a dobra o complemento do objetivo também serve (a combinação dual dá o objetivo)
+                            uint64_t andNegHit = 0, orNegHit = 0;
+                            if (foldComplements) {
+                                andNegHit = ttKernelMatch(andOut, mask.andKeep, negObjectiveTt);
+                                orNegHit = ttKernelMatch(orOut, mask.orKeep, negObjectiveTt);
+                            }
+
+                            // Parada imediata caso encontre equivalência (primeiro par do trecho, AND antes de OR)
+                            uint64_t hits = mask.andHit | mask.orHit | andNegHit | orNegHit;
+                            if (hits && choice == 'e') {
+                                int x = __builtin_ctzll(hits);
+                                OpType op = (((mask.andHit | andNegHit) >> x) & 1) ? AND : OR;
+                                uint32_t left = (uint32_t)k, rightRef = (uint32_t)(l0 + x) | rightFlag;
+                                if (((andNegHit | orNegHit) >> x) & 1) bucketDualize(&op, &left, &rightRef);
+                                printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+                                printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+                                printf("RESULTADO_EXPRESSAO: ");
+                                printBucketCombination(buckets, op, i + 1, left, j + 1, rightRef);
+                                printf("\n");
+                                bucketFreeColumns(targetBucket);
+                                for (int s = 0; s < targetOrder; s++) pairSpaceFree(&spaces[s]);
+                                free(spaces);
+                                checkpointEndOrder(&progress);
+                                return true;
+                            }
+
+                            for (uint64_t keep = mask.andKeep | mask.orKeep; keep != 0; keep &= keep - 1) {
+                                int x = __builtin_ctzll(keep);
+                                uint32_t rightRef = (uint32_t)(l0 + x) | rightFlag;
+                                if ((mask.andKeep >> x) & 1) {
+                                    TruthTable key = foldComplements ? bucketCanonicalTt(andOut[x]) : andOut[x];
+                                    if (seenSetInsert(uniqueCheck, key)) {
+                                        bucketAppendFolded(targetBucket, key, NULL, key != andOut[x], AND, i + 1, k, rightRef);
+                                    }
+                                }
+                                if ((mask.orKeep >> x) & 1) {
+                                    TruthTable key = foldComplements ? bucketCanonicalTt(orOut[x]) : orOut[x];
+                                    if (seenSetInsert(uniqueCheck, key)) {
+                                        bucketAppendFolded(targetBucket, key, NULL, key != orOut[x], OR, i + 1, k, rightRef);
+                                    }
+                                }
+                            }
+                        }
                     }
+                    continue;
+                }
 
-                    if (st_lookup(uniqueCheck, (char *)newBdd, NULL) == 0) {
-                        Function *newFunction = opNode((opChar == '*') ? AND : OR, f1, f2, newBdd);
-                        st_insert(uniqueCheck, (char *)newBdd, (char *)newBdd);
-                        addFunctionToDynamicArray(newFunction, &newFunctions, &newFuncCount, &newFuncCapacity);
-                    } else {
-                        Cudd_RecursiveDeref(manager, newBdd);
+                for (int l = firstL; l < tile->lEnd; l++)
+                {
+                    for (int pol = 0; pol < polarities; pol++)
+                    {
+                        DdNode *right = Cudd_NotCond(b2->bdd[l], pol);
+                        uint32_t rightRef = (uint32_t)l | (pol ? BUCKET_NEGATED : 0);
+                        // Implicação, complemento, disjunção e cobertura saem aqui, antes de criar qualquer nó
+                        Signature leftSig, rightSig;
+                        int ops = prefilterBdd(manager, b1->bdd[k], right, bucketRefSig(b1, (uint32_t)k, &leftSig), bucketRefSig(b2, rightRef, &rightSig), &stats);
+                        for (int op = 0; op < 2; op++)
+                        {
+                            if (!(ops & ((op == 0) ? PREFILTER_AND : PREFILTER_OR))) continue;
+                            char opChar = (op == 0) ? '*' : '+';
+                            DdNode *newBdd = combineBdds(manager, b1->bdd[k], right, opChar);
+
+                            if (newBdd == NULL) continue;
+
+                            if (newBdd == Cudd_ReadLogicZero(manager) || newBdd == Cudd_ReadOne(manager)) {
+                                Cudd_RecursiveDeref(manager, newBdd);
+                                continue;
+                            }
+
+                            // Parada imediata caso encontre equivalência
+                            bool negHit = foldComplements && newBdd == Cudd_Not(objectiveExp);
+                            if ((newBdd == objectiveExp || negHit) && choice == 'e') {
+                                OpType hitOp = (opChar == '*') ? AND : OR;
+                                uint32_t left = (uint32_t)k, hitRight = rightRef;
+                                if (negHit) bucketDualize(&hitOp, &left, &hitRight);
+                                printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
+                                printf("RESULTADO_LITERAIS: %d\n", targetOrder);
+                                printf("RESULTADO_EXPRESSAO: ");
+                                printBucketCombination(buckets, hitOp, i + 1, left, j + 1, hitRight);
+                                printf("\n");
+                                for (int t = 0; t < targetBucket->size; t++) Cudd_RecursiveDeref(manager, targetBucket->bdd[t]);
+                                bucketFreeColumns(targetBucket);
+                                Cudd_RecursiveDeref(manager, newBdd);
+                                for (int s = 0; s < targetOrder; s++) pairSpaceFree(&spaces[s]);
+                                free(spaces);
+                                checkpointEndOrder(&progress);
+                                return true;
+                            }
+
+                            // O nó regular carrega a referência do resultado, complementado ou não
+                            DdNode *key = foldComplements ? bucketCanonicalBdd(newBdd) : newBdd;
+                            if (seenSetInsert(uniqueCheck, (uint64_t)(uintptr_t)key)) {
+                                bucketAppendFolded(targetBucket, 0, key, key != newBdd, (opChar == '*') ? AND : OR, i + 1, k, rightRef);
+                            } else {
+                                Cudd_RecursiveDeref(manager, newBdd);
+                            }
+                        }
                     }
                 }
             }
+            checkpointMarkTile(&progress, i, t);
         }
     }
-
-    targetBucket->order = targetOrder;
-    targetBucket->size = newFuncCount;
-
-    if (newFuncCount > 0) {
-        targetBucket->functions = newFunctions;
-    } else {
-        free(newFunctions);
-        targetBucket->functions = NULL;
+    for (int i = 0; i < targetOrder; i++) pairSpaceFree(&spaces[i]);
+    free(spaces);
+    prefilterMerge(&stats);
+    prefilterReport(targetOrder);
+
+    // Parada pedida no meio da ordem: o bucket alvo tem as funções de todos os blocos marcados
+    if (progress.done != NULL && checkpointStopRequested() && checkpointOrderPending(&progress)) {
+        checkpointSaveAndExit(&progress, buckets, targetBucket);
     }
+    checkpointEndOrder(&progress);
 
     // Verifica array final se a opção não era saída imediata
-    for (int i = 0; i < newFuncCount; i++) {
-        if (newFunctions[i]->bdd == objectiveExp) {
+    for (int i = 0; i < targetBucket->size; i++) {
+        if (bucketIsObjective(targetBucket, i, objectiveExp)) {
             printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", targetOrder);
-            printFunction(newFunctions[i]);
+            printBucketFunction(buckets, targetOrder, bucketObjectiveRef(targetBucket, i, objectiveExp));
             printf("\n");
             printf("No de literais: %d\n", targetOrder);
             return true;
@@ -827,26 +1055,6 @@ bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, i
     return false;
 }
 
-Function* varNode(char varName, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = VAR; // variável
-    node->varName = varName;
-    node->left = NULL;
-    node->right = NULL;
-    return node;
-}
-
-Function* opNode(OpType operador, Function* left, Function* right, DdNode *bdd) {
-    Function* node = (Function*)malloc(sizeof(Function));
-    node->bdd = bdd;
-    node->operador = operador; // 1 p/ not, 2 p/ and, 3 p/ or
-    node->varName = '\0'; // não usado para operadores
-    node->left = left;
-    node->right = right;
-    return node;
-}
-
 void printFunction(Function* node) {
     if (node == NULL) return;
 
@@ -874,4 +1082,77 @@ void printFunction(Function* node) {
         printFunction(node->right);
         if (parRight) printf(")");
     }
-}
\ No newline at end of file
+}
+
+/* Enumera todas as funções de LITDB_VARS variáveis partindo dos 8 literais (sem o filtro de unate,
+já que aqui não existe objetivo) e combinando buckets até que todas as não constantes tenham aparecido.
+Como cada função entra no primeiro bucket em que aparece, a ordem guardada é o mínimo de literais. */
+int generateLiteralDb(DdManager *manager, const char *path)
+{
+    double start_time = omp_get_wtime();
+
+    useTruthTable = true;
+    fullTt = ttFullMask(LITDB_VARS);
+    objectiveTt = 0; // Constante, nunca é gerada pelas combinações
+
+    SeenSet *uniqueCheck = seenSetCreate(true, LITDB_VARS);
+    LitDbEntry *entries = (LitDbEntry *)calloc(LITDB_ENTRIES, sizeof(LitDbEntry));
+    if (uniqueCheck == NULL || entries == NULL) {
+        fprintf(stderr, "Erro ao alocar memória para a tabela\n");
+        seenSetFree(uniqueCheck);
+        free(entries);
+        return EXIT_FAILURE;
+    }
+
+    int numBuckets = 0;
+    Bucket *buckets = addBucket(NULL, &numBuckets);
+    literalBucketInit(&buckets[0], "ABCD", LITDB_VARS, uniqueCheck);
+
+    // Constantes 0 e 1 ficam de fora
+    int total = (int)bucketFunctionCount(&buckets[0]);
+    printf("Ordem 1: %d funções\n", total);
+    for (int order = 2; total < LITDB_ENTRIES - 2; order++) {
+        if (order > UINT8_MAX) {
+            fprintf(stderr, "Erro: enumeração não saturou (%d de %d funções)\n", total, LITDB_ENTRIES - 2);
+            freeAllBuckets(manager, buckets, numBuckets);
+            seenSetFree(uniqueCheck);
+            free(entries);
+            return EXIT_FAILURE;
+        }
+        buckets = addBucket(buckets, &numBuckets);
+        createCombinedBucket(manager, buckets, numBuckets, order, NULL, uniqueCheck, 'c');
+        total += (int)bucketFunctionCount(&buckets[order - 1]);
+        printf("Ordem %d: %d funções (total %d)\n", order, (int)bucketFunctionCount(&buckets[order - 1]), total);
+    }
+
+    // Com a dobra cada entrada grava também o complemento, com a combinação dual como testemunho
+    for (int b = 0; b < numBuckets; b++) {
+        for (int k = 0; k < buckets[b].size; k++) {
+            for (int pol = 0; pol < (foldComplements ? 2 : 1); pol++) {
+                Bucket *bucket = &buckets[b];
+                uint32_t ref = (uint32_t)k | (pol ? BUCKET_NEGATED : 0);
+                LitDbEntry *e = &entries[bucketRefTt(bucket, ref)];
+                e->literals = (uint8_t)bucket->order;
+                e->op = bucketRefOp(buckets, bucket->order, ref);
+                if (e->op == VAR || e->op == NOT) {
+                    e->left = (uint16_t)(bucket->left[k] - 'A');
+                } else {
+                    int leftOrder = bucket->leftOrder[k];
+                    uint32_t flip = pol ? BUCKET_NEGATED : 0;
+                    e->left = (uint16_t)bucketRefTt(&buckets[leftOrder - 1], bucket->left[k] ^ flip);
+                    e->right = (uint16_t)bucketRefTt(&buckets[bucket->order - leftOrder - 1], bucket->right[k] ^ flip);
+                }
+            }
+        }
+    }
+
+    int status = litDbWrite(path, entries) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    if (status == EXIT_SUCCESS) {
+        printf("Tabela gravada em %s (%.2f s)\n", path, omp_get_wtime() - start_time);
+    }
+
+    freeAllBuckets(manager, buckets, numBuckets);
+    seenSetFree(uniqueCheck);
+    free(entries);
+    return status;
+}
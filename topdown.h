@@ -0,0 +1,372 @@
+#ifndef TOPDOWN_H
+#define TOPDOWN_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <omp.h>
+#include "bucket.h"
+#include "dedup.h"
+
+/* Motor top-down (modo t). Em vez de crescer os buckets até o objetivo aparecer, parte do objetivo e tenta quebrá-lo
+em g*h ou g+h com um orçamento de literais, aprofundando o orçamento de um em um (iterative deepening).
+Em uma fórmula mínima de custo b o filho menor custa no máximo b/2, então g sai dos buckets até a ordem b/2
+(que são montados sob demanda pelo próprio createCombinedBucket) e só o outro filho vira subalvo.
+O subalvo não é uma função fechada e sim um intervalo (on, off): pontos que têm que valer 1, pontos que têm que valer 0,
+e o resto é livre. Para AND: g cobre on e h tem que cobrir on e zerar off & g. Para OR: g não toca off e h cobre on & !g.
+Os resultados de cada intervalo ficam numa tabela compartilhada entre as threads: o maior orçamento já provado
+insuficiente e, se houver, uma solução com o seu custo. O limite inferior é o número de variáveis essenciais do intervalo
+(existe um ponto de on e um de off que diferem só nela), o que poda boa parte dos ramos antes de recursão.
+Só funciona com o backend de tabela verdade. */
+#define TD_SHARDS 64
+#define TD_INITIAL_SLOTS 256
+
+// Implementada em cada executável, usada para montar os buckets dos candidatos
+bool createCombinedBucket(DdManager *manager, Bucket *buckets, int numBuckets, int targetOrder, DdNode *objectiveExp, SeenSet *uniqueCheck, char choice);
+
+typedef struct TdEntry {
+    TruthTable on;
+    TruthTable off;
+    int failBudget; //Maior orçamento já provado insuficiente (0 = nenhum)
+    int cost; //Custo da solução, se houver
+    Function *solution;
+    struct TdEntry *next;
+} TdEntry;
+
+typedef struct {
+    TdEntry **heads;
+    size_t capacity;
+    size_t count;
+    omp_lock_t lock;
+} TdShard;
+
+typedef struct {
+    TdShard shards[TD_SHARDS];
+    // Nós AND/OR criados pelo motor. Ficam vivos até o fim porque outras soluções podem apontar para eles
+    Function **nodes;
+    int nodeCount;
+    int nodeCapacity;
+    // Cópias em árvore das funções dos buckets usadas nas soluções (bucketMaterialize)
+    Function **leaves;
+    int leafCount;
+    int leafCapacity;
+    omp_lock_t nodeLock;
+    Bucket *buckets;
+    int varCount;
+} TopDown;
+
+static inline uint64_t tdHash(TruthTable on, TruthTable off)
+{
+    uint64_t h = on * 0x9E3779B97F4A7C15ULL ^ off;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline void tdInit(TopDown *td, Bucket *buckets, int varCount)
+{
+    memset(td, 0, sizeof(*td));
+    td->buckets = buckets;
+    td->varCount = varCount;
+    omp_init_lock(&td->nodeLock);
+    for (int s = 0; s < TD_SHARDS; s++) {
+        td->shards[s].capacity = TD_INITIAL_SLOTS;
+        td->shards[s].heads = (TdEntry **)calloc(TD_INITIAL_SLOTS, sizeof(TdEntry *));
+        if (td->shards[s].heads == NULL) {
+            fprintf(stderr, "Erro ao alocar a tabela do top-down\n");
+            exit(EXIT_FAILURE);
+        }
+        omp_init_lock(&td->shards[s].lock);
+    }
+}
+
+static inline void tdFree(TopDown *td)
+{
+    for (int s = 0; s < TD_SHARDS; s++) {
+        TdShard *shard = &td->shards[s];
+        for (size_t k = 0; k < shard->capacity; k++) {
+            TdEntry *e = shard->heads[k];
+            while (e) {
+                TdEntry *next = e->next;
+                free(e);
+                e = next;
+            }
+        }
+        free(shard->heads);
+        omp_destroy_lock(&shard->lock);
+    }
+    for (int k = 0; k < td->nodeCount; k++) free(td->nodes[k]);
+    free(td->nodes);
+    for (int k = 0; k < td->leafCount; k++) freeFunctionTree(td->leaves[k]);
+    free(td->leaves);
+    omp_destroy_lock(&td->nodeLock);
+}
+
+// Devolve a entrada do intervalo, criando se não existir. Tem que ser chamada com a trava da fatia
+static inline TdEntry *tdEntryLocked(TdShard *shard, uint64_t hash, TruthTable on, TruthTable off)
+{
+    size_t slot = (hash / TD_SHARDS) & (shard->capacity - 1);
+    for (TdEntry *e = shard->heads[slot]; e; e = e->next) {
+        if (e->on == on && e->off == off) return e;
+    }
+
+    if (shard->count >= shard->capacity * 2) {
+        // Dobra a fatia e redistribui as cadeias
+        size_t newCapacity = shard->capacity * 2;
+        TdEntry **newHeads = (TdEntry **)calloc(newCapacity, sizeof(TdEntry *));
+        if (newHeads == NULL) {
+            fprintf(stderr, "Erro ao realocar a tabela do top-down\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t k = 0; k < shard->capacity; k++) {
+            TdEntry *e = shard->heads[k];
+            while (e) {
+                TdEntry *next = e->next;
+                size_t s = (tdHash(e->on, e->off) / TD_SHARDS) & (newCapacity - 1);
+                e->next = newHeads[s];
+                newHeads[s] = e;
+                e = next;
+            }
+        }
+        free(shard->heads);
+        shard->heads = newHeads;
+        shard->capacity = newCapacity;
+        slot = (hash / TD_SHARDS) & (shard->capacity - 1);
+    }
+
+    TdEntry *e = (TdEntry *)calloc(1, sizeof(TdEntry));
+    if (e == NULL) {
+        fprintf(stderr, "Erro ao alocar entrada do top-down\n");
+        exit(EXIT_FAILURE);
+    }
+    e->on = on;
+    e->off = off;
+    e->next = shard->heads[slot];
+    shard->heads[slot] = e;
+    shard->count++;
+    return e;
+}
+
+// Consulta a tabela: true se já existe resposta para esse orçamento (solução em *solution, ou NULL se é impossível)
+static inline bool tdLookup(TopDown *td, TruthTable on, TruthTable off, int budget, Function **solution, int *cost)
+{
+    uint64_t hash = tdHash(on, off);
+    TdShard *shard = &td->shards[hash % TD_SHARDS];
+    bool known = false;
+    omp_set_lock(&shard->lock);
+    TdEntry *e = tdEntryLocked(shard, hash, on, off);
+    if (e->solution && e->cost <= budget) {
+        *solution = e->solution;
+        *cost = e->cost;
+        known = true;
+    } else if (e->failBudget >= budget) {
+        *solution = NULL;
+        known = true;
+    }
+    omp_unset_lock(&shard->lock);
+    return known;
+}
+
+static inline void tdRecord(TopDown *td, TruthTable on, TruthTable off, int budget, Function *solution, int cost)
+{
+    uint64_t hash = tdHash(on, off);
+    TdShard *shard = &td->shards[hash % TD_SHARDS];
+    omp_set_lock(&shard->lock);
+    TdEntry *e = tdEntryLocked(shard, hash, on, off);
+    if (solution == NULL) {
+        if (budget > e->failBudget) e->failBudget = budget;
+    } else if (e->solution == NULL || cost < e->cost) {
+        e->solution = solution;
+        e->cost = cost;
+    }
+    omp_unset_lock(&shard->lock);
+}
+
+static inline Function *tdNewNode(TopDown *td, OpType operador, Function *left, Function *right)
+{
+    Function *node = (Function *)malloc(sizeof(Function));
+    if (node == NULL) {
+        fprintf(stderr, "Erro ao alocar nó do top-down\n");
+        exit(EXIT_FAILURE);
+    }
+    node->bdd = NULL;
+    node->tt = (operador == AND) ? (left->tt & right->tt) : (left->tt | right->tt);
+    node->left = left;
+    node->right = right;
+    node->operador = operador;
+    node->varName = '\0';
+
+    omp_set_lock(&td->nodeLock);
+    if (td->nodeCount == td->nodeCapacity) {
+        td->nodeCapacity = (td->nodeCapacity == 0) ? 256 : td->nodeCapacity * 2;
+        td->nodes = (Function **)realloc(td->nodes, td->nodeCapacity * sizeof(Function *));
+        if (td->nodes == NULL) {
+            fprintf(stderr, "Erro ao realocar nós do top-down\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    td->nodes[td->nodeCount++] = node;
+    omp_unset_lock(&td->nodeLock);
+    return node;
+}
+
+// A função k do bucket de ordem order como árvore própria do motor (a solução é impressa pela árvore)
+static inline Function *tdBucketNode(TopDown *td, int order, int k)
+{
+    Function *leaf = bucketMaterialize(td->buckets, order, (uint32_t)k);
+
+    omp_set_lock(&td->nodeLock);
+    if (td->leafCount == td->leafCapacity) {
+        td->leafCapacity = (td->leafCapacity == 0) ? 64 : td->leafCapacity * 2;
+        td->leaves = (Function **)realloc(td->leaves, td->leafCapacity * sizeof(Function *));
+        if (td->leaves == NULL) {
+            fprintf(stderr, "Erro ao realocar nós do top-down\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    td->leaves[td->leafCount++] = leaf;
+    omp_unset_lock(&td->nodeLock);
+    return leaf;
+}
+
+// Número de variáveis essenciais do intervalo: limite inferior para o número de literais
+static inline int tdLowerBound(TruthTable on, TruthTable off, int varCount)
+{
+    int essential = 0;
+    for (int v = 0; v < varCount; v++) {
+        int shift = 1 << v;
+        TruthTable var = ttVar(v, varCount);
+        TruthTable up = ((on & ~var) << shift) & off & var;
+        TruthTable down = ((on & var) >> shift) & off & ~var;
+        if (up | down) essential++;
+    }
+    return essential;
+}
+
+/* Procura uma fórmula de no máximo "budget" literais para o intervalo (on, off).
+Com parallel o laço de candidatos do nível atual é dividido entre as threads; a recursão é sempre sequencial. */
+static inline Function *tdSolve(TopDown *td, TruthTable on, TruthTable off, int budget, int *outCost, bool parallel)
+{
+    Function *known = NULL;
+    int knownCost = 0;
+    if (tdLookup(td, on, off, budget, &known, &knownCost)) {
+        if (known) *outCost = knownCost;
+        return known;
+    }
+    if (budget < 1 || tdLowerBound(on, off, td->varCount) > budget) {
+        tdRecord(td, on, off, budget, NULL, 0);
+        return NULL;
+    }
+
+    // Candidatos g: buckets de ordem 1 até budget/2 (o bucket 1 já vem com o filtro de unate)
+    int halfOrder = budget / 2;
+    if (halfOrder < 1) halfOrder = 1;
+    int total = 0;
+    for (int b = 0; b < halfOrder; b++) total += td->buckets[b].size;
+
+    Function *result = NULL;
+    int resultCost = 0;
+
+    #pragma omp parallel for schedule(dynamic) if(parallel)
+    for (int idx = 0; idx < total; idx++)
+    {
+        Function *current;
+        #pragma omp atomic read
+        current = result;
+        if (current) continue;
+
+        int b = 0;
+        int k = idx;
+        while (k >= td->buckets[b].size) {
+            k -= td->buckets[b].size;
+            b++;
+        }
+        TruthTable g = td->buckets[b].tt[k];
+        int gCost = td->buckets[b].order;
+        int rest = budget - gCost;
+
+        Function *found = NULL;
+        int foundCost = 0;
+        bool coversOn = ttLeq(on, g);
+        bool avoidsOff = (g & off) == 0;
+
+        if (coversOn && avoidsOff) {
+            // O próprio g já serve
+            found = tdBucketNode(td, b + 1, k);
+            foundCost = gCost;
+        } else if (rest >= 1 && coversOn) {
+            int hCost = 0;
+            Function *h = tdSolve(td, on, off & g, rest, &hCost, false);
+            if (h) {
+                found = tdNewNode(td, AND, tdBucketNode(td, b + 1, k), h);
+                foundCost = gCost + hCost;
+            }
+        } else if (rest >= 1 && avoidsOff) {
+            int hCost = 0;
+            Function *h = tdSolve(td, on & ~g, off, rest, &hCost, false);
+            if (h) {
+                found = tdNewNode(td, OR, tdBucketNode(td, b + 1, k), h);
+                foundCost = gCost + hCost;
+            }
+        }
+
+        if (found) {
+            #pragma omp critical(topdown_result)
+            {
+                if (result == NULL || foundCost < resultCost) {
+                    resultCost = foundCost;
+                    #pragma omp atomic write
+                    result = found;
+                }
+            }
+        }
+    }
+
+    tdRecord(td, on, off, budget, result, resultCost);
+    if (result) *outCost = resultCost;
+    return result;
+}
+
+/* Laço do modo t: aprofunda o orçamento de 2 até maxOrder, montando os buckets de ordem até orçamento/2 quando precisa.
+buckets já tem que estar alocado até maxOrder com o primeiro bucket inicializado. */
+static inline bool topDownSearch(DdManager *manager, Bucket *buckets, int maxOrder, int varCount, DdNode *objectiveExp, SeenSet *uniqueCheck, bool parallel)
+{
+    TopDown td;
+    tdInit(&td, buckets, varCount);
+
+    TruthTable off = ~objectiveTt & fullTt;
+    int built = 1;
+    bool found = false;
+    int start = tdLowerBound(objectiveTt, off, varCount);
+    if (start < 2) start = 2;
+
+    for (int budget = start; budget <= maxOrder && !found; budget++) {
+        while (built < budget / 2) {
+            built++;
+            createCombinedBucket(manager, buckets, maxOrder, built, objectiveExp, uniqueCheck, 'c');
+        }
+
+        int cost = 0;
+        Function *solution = tdSolve(&td, objectiveTt, off, budget, &cost, parallel);
+        if (solution) {
+            printf("\n!!! EQUIVALÊNCIA ENCONTRADA (Ordem %d) !!!\n", cost);
+            printf("RESULTADO_LITERAIS: %d\n", cost);
+            printf("RESULTADO_EXPRESSAO: ");
+            printFunction(solution);
+            printf("\n");
+            found = true;
+        }
+    }
+
+    size_t entries = 0;
+    for (int s = 0; s < TD_SHARDS; s++) entries += td.shards[s].count;
+    printf("Top-down: %zu subalvos memorizados, buckets montados até a ordem %d\n", entries, built);
+
+    tdFree(&td);
+    return found;
+}
+
+#endif
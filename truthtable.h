@@ -0,0 +1,79 @@
+#ifndef TRUTHTABLE_H
+#define TRUTHTABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bdd.h"
+
+/* Backend por tabela verdade. Com até 6 variáveis a função inteira cabe em uma palavra de 64 bits
+(4 variáveis -> 16 bits), então AND/OR viram uma instrução só e não precisamos passar pelo manager do CUDD.
+O bit m da tabela é o valor da função na atribuição em que a variável i vale (m >> i) & 1,
+com i sendo o mesmo índice usado em Cudd_bddIthVar no parse. */
+#define TT_MAX_VARS 6
+
+typedef uint64_t TruthTable;
+
+// Padrões das variáveis projetadas (x0 = 1010..., x1 = 1100..., etc)
+static const TruthTable ttVarPatterns[TT_MAX_VARS] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL
+};
+
+// Máscara com os 2^varCount bits válidos da tabela (constante 1)
+static inline TruthTable ttFullMask(int varCount)
+{
+    if (varCount >= TT_MAX_VARS) return ~(TruthTable)0;
+    return ((TruthTable)1 << (1 << varCount)) - 1;
+}
+
+// Tabela da variável de índice "index"
+static inline TruthTable ttVar(int index, int varCount)
+{
+    return ttVarPatterns[index] & ttFullMask(varCount);
+}
+
+// Cofator positivo/negativo em relação à variável "index", replicado nas duas metades
+// (assim o resultado continua sendo uma tabela de varCount variáveis e dá pra comparar direto)
+static inline TruthTable ttCofactor(TruthTable tt, int index, bool positive, int varCount)
+{
+    int shift = 1 << index;
+    TruthTable var = ttVar(index, varCount);
+    if (positive) {
+        TruthTable half = tt & var;
+        return half | (half >> shift);
+    }
+    TruthTable half = tt & ~var & ttFullMask(varCount);
+    return (half | (half << shift)) & ttFullMask(varCount);
+}
+
+// a <= b (implicação)
+static inline bool ttLeq(TruthTable a, TruthTable b)
+{
+    return (a & ~b) == 0;
+}
+
+// Converte o BDD do objetivo em tabela verdade avaliando todas as 2^varCount atribuições.
+// Só é chamada uma vez por execução, então não vale a pena percorrer o grafo na mão.
+static inline TruthTable bddToTruthTable(DdManager *manager, DdNode *bdd, int varCount)
+{
+    int inputs[TT_MAX_VARS] = {0};
+    TruthTable tt = 0;
+    for (int m = 0; m < (1 << varCount); m++)
+    {
+        for (int v = 0; v < varCount; v++)
+        {
+            inputs[v] = (m >> v) & 1;
+        }
+        if (Cudd_Eval(manager, bdd, inputs) == Cudd_ReadOne(manager))
+        {
+            tt |= (TruthTable)1 << m;
+        }
+    }
+    return tt;
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef TTKERNEL_H
+#define TTKERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "truthtable.h"
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define TT_KERNEL_X86 1
+#else
+#define TT_KERNEL_X86 0
+#endif
+
+/* Combinação em lote no backend por tabela verdade: uma função da esquerda contra um trecho contíguo de até
+TT_KERNEL_LANES tabelas do bucket da direita. AND e OR saem juntos, já comparados com 0, com a constante 1 e com o
+objetivo, e o resultado vem em máscaras de bits (bit x = posição x do trecho). Quem chama só percorre os bits ligados
+de keep para a deduplicação: constantes e resultados iguais a um dos operandos (um implica o outro, então o resultado
+já está num bucket menor) nem saem do kernel. As máscaras de descarte alimentam os contadores do pré-filtro.
+Os kernels AVX2 (4 tabelas por instrução) e AVX-512 (8) são escolhidos em tempo de execução pela CPU, com o escalar
+como reserva; o binário continua sendo compilado sem -march. As tabelas são sempre de 64 bits (mesmo com 4 variáveis),
+então não existe a versão de 16 lanes de 16 bits. */
+#define TT_KERNEL_LANES 64
+
+typedef struct {
+    uint64_t andKeep; //AND não constante e diferente dos operandos
+    uint64_t orKeep; //OR não constante e diferente dos operandos
+    uint64_t andHit; //AND igual ao objetivo (e mantido)
+    uint64_t orHit;
+    uint64_t andZero; //Disjuntos
+    uint64_t orFull; //Juntos cobrem tudo
+    uint64_t dominated; //Um operando implica o outro (AND e OR repetem os operandos)
+} TtComboMask;
+
+typedef void (*TtCombineKernel)(TruthTable left, const TruthTable *right, int count, TruthTable full, TruthTable target,
+                                TruthTable *andOut, TruthTable *orOut, TtComboMask *mask);
+
+static inline void ttCombineScalar(TruthTable left, const TruthTable *right, int count, TruthTable full, TruthTable target,
+                                   TruthTable *andOut, TruthTable *orOut, TtComboMask *mask)
+{
+    uint64_t andKeep = 0, orKeep = 0, andHit = 0, orHit = 0, andZero = 0, orFull = 0, dominated = 0;
+    for (int x = 0; x < count; x++) {
+        TruthTable a = left & right[x];
+        TruthTable o = left | right[x];
+        andOut[x] = a;
+        orOut[x] = o;
+        uint64_t bit = (uint64_t)1 << x;
+        if (a != 0 && a != full) andKeep |= bit;
+        if (o != 0 && o != full) orKeep |= bit;
+        if (a == 0) andZero |= bit;
+        if (o == full) orFull |= bit;
+        if (a == left || a == right[x]) dominated |= bit;
+        if (a == target) andHit |= bit;
+        if (o == target) orHit |= bit;
+    }
+    mask->andKeep = andKeep & ~dominated;
+    mask->orKeep = orKeep & ~dominated;
+    mask->andHit = andHit & mask->andKeep;
+    mask->orHit = orHit & mask->orKeep;
+    mask->andZero = andZero;
+    mask->orFull = orFull;
+    mask->dominated = dominated;
+}
+
+#if TT_KERNEL_X86
+__attribute__((target("avx2")))
+static void ttCombineAvx2(TruthTable left, const TruthTable *right, int count, TruthTable full, TruthTable target,
+                          TruthTable *andOut, TruthTable *orOut, TtComboMask *mask)
+{
+    __m256i vLeft = _mm256_set1_epi64x((long long)left);
+    __m256i vZero = _mm256_setzero_si256();
+    __m256i vFull = _mm256_set1_epi64x((long long)full);
+    __m256i vTarget = _mm256_set1_epi64x((long long)target);
+    uint64_t andConst = 0, orConst = 0, andHit = 0, orHit = 0, andZero = 0, orFull = 0, dominated = 0;
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m256i r = _mm256_loadu_si256((const __m256i *)(right + x));
+        __m256i a = _mm256_and_si256(vLeft, r);
+        __m256i o = _mm256_or_si256(vLeft, r);
+        _mm256_storeu_si256((__m256i *)(andOut + x), a);
+        _mm256_storeu_si256((__m256i *)(orOut + x), o);
+        // movemask_pd pega o bit de sinal de cada lane de 64 bits, ou seja, o resultado da comparação
+        __m256i aZero = _mm256_cmpeq_epi64(a, vZero);
+        __m256i oFull = _mm256_cmpeq_epi64(o, vFull);
+        __m256i aConst = _mm256_or_si256(aZero, _mm256_cmpeq_epi64(a, vFull));
+        __m256i oConst = _mm256_or_si256(_mm256_cmpeq_epi64(o, vZero), oFull);
+        __m256i dom = _mm256_or_si256(_mm256_cmpeq_epi64(a, vLeft), _mm256_cmpeq_epi64(a, r));
+        andConst |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(aConst)) << x;
+        orConst |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(oConst)) << x;
+        andZero |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(aZero)) << x;
+        orFull |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(oFull)) << x;
+        dominated |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(dom)) << x;
+        andHit |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, vTarget))) << x;
+        orHit |= (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(o, vTarget))) << x;
+    }
+    uint64_t valid = (count >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << count) - 1);
+    mask->andKeep = ~andConst & ~dominated & valid;
+    mask->orKeep = ~orConst & ~dominated & valid;
+    mask->andHit = andHit & mask->andKeep;
+    mask->orHit = orHit & mask->orKeep;
+    mask->andZero = andZero;
+    mask->orFull = orFull;
+    mask->dominated = dominated;
+    if (x < count) {
+        // Sobra do fim do trecho
+        TtComboMask tail;
+        ttCombineScalar(left, right + x, count - x, full, target, andOut + x, orOut + x, &tail);
+        uint64_t tailBits = ~(uint64_t)0 << x;
+        mask->andKeep = (mask->andKeep & ~tailBits) | (tail.andKeep << x);
+        mask->orKeep = (mask->orKeep & ~tailBits) | (tail.orKeep << x);
+        mask->andHit = (mask->andHit & ~tailBits) | (tail.andHit << x);
+        mask->orHit = (mask->orHit & ~tailBits) | (tail.orHit << x);
+        mask->andZero = (mask->andZero & ~tailBits) | (tail.andZero << x);
+        mask->orFull = (mask->orFull & ~tailBits) | (tail.orFull << x);
+        mask->dominated = (mask->dominated & ~tailBits) | (tail.dominated << x);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void ttCombineAvx512(TruthTable left, const TruthTable *right, int count, TruthTable full, TruthTable target,
+                            TruthTable *andOut, TruthTable *orOut, TtComboMask *mask)
+{
+    __m512i vLeft = _mm512_set1_epi64((long long)left);
+    __m512i vZero = _mm512_setzero_si512();
+    __m512i vFull = _mm512_set1_epi64((long long)full);
+    __m512i vTarget = _mm512_set1_epi64((long long)target);
+    uint64_t andKeep = 0, orKeep = 0, andHit = 0, orHit = 0, andZero = 0, orFull = 0, dominated = 0;
+    for (int x = 0; x < count; x += 8) {
+        // A máscara de carga cobre a sobra no último grupo, sem laço escalar
+        __mmask8 lanes = (count - x >= 8) ? 0xFF : (__mmask8)((1u << (count - x)) - 1);
+        __m512i r = _mm512_maskz_loadu_epi64(lanes, right + x);
+        __m512i a = _mm512_and_si512(vLeft, r);
+        __m512i o = _mm512_or_si512(vLeft, r);
+        _mm512_mask_storeu_epi64(andOut + x, lanes, a);
+        _mm512_mask_storeu_epi64(orOut + x, lanes, o);
+        __mmask8 aZero = _mm512_mask_cmpeq_epi64_mask(lanes, a, vZero);
+        __mmask8 oFull = _mm512_mask_cmpeq_epi64_mask(lanes, o, vFull);
+        __mmask8 dom = _mm512_mask_cmpeq_epi64_mask(lanes, a, vLeft) | _mm512_mask_cmpeq_epi64_mask(lanes, a, r);
+        __mmask8 aKeep = _mm512_mask_cmpneq_epi64_mask(lanes & ~aZero & ~dom, a, vFull);
+        __mmask8 oKeep = _mm512_mask_cmpneq_epi64_mask(lanes & ~oFull & ~dom, o, vZero);
+        andZero |= (uint64_t)aZero << x;
+        orFull |= (uint64_t)oFull << x;
+        dominated |= (uint64_t)dom << x;
+        andKeep |= (uint64_t)aKeep << x;
+        orKeep |= (uint64_t)oKeep << x;
+        andHit |= (uint64_t)_mm512_mask_cmpeq_epi64_mask(aKeep, a, vTarget) << x;
+        orHit |= (uint64_t)_mm512_mask_cmpeq_epi64_mask(oKeep, o, vTarget) << x;
+    }
+    mask->andKeep = andKeep;
+    mask->orKeep = orKeep;
+    mask->andHit = andHit;
+    mask->orHit = orHit;
+    mask->andZero = andZero;
+    mask->orFull = orFull;
+    mask->dominated = dominated;
+}
+#endif
+
+// Posições de keep em que a saída do kernel vale value (alvo complementado da dobra de complementos)
+static inline uint64_t ttKernelMatch(const TruthTable *out, uint64_t keep, TruthTable value)
+{
+    uint64_t match = 0;
+    for (; keep != 0; keep &= keep - 1) {
+        int x = __builtin_ctzll(keep);
+        if (out[x] == value) match |= (uint64_t)1 << x;
+    }
+    return match;
+}
+
+// Escolhido uma vez, na primeira chamada de ttCombineKernel
+static TtCombineKernel ttKernelSelected = NULL;
+
+static inline TtCombineKernel ttCombineKernel(void)
+{
+    TtCombineKernel kernel = __atomic_load_n(&ttKernelSelected, __ATOMIC_ACQUIRE);
+    if (kernel != NULL) return kernel;
+    kernel = ttCombineScalar;
+#if TT_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) kernel = ttCombineAvx512;
+    else if (__builtin_cpu_supports("avx2")) kernel = ttCombineAvx2;
+#endif
+    __atomic_store_n(&ttKernelSelected, kernel, __ATOMIC_RELEASE);
+    return kernel;
+}
+
+static inline const char *ttCombineKernelName(void)
+{
+    TtCombineKernel kernel = ttCombineKernel();
+#if TT_KERNEL_X86
+    if (kernel == ttCombineAvx512) return "AVX-512";
+    if (kernel == ttCombineAvx2) return "AVX2";
+#endif
+    (void)kernel;
+    return "escalar";
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "pairspace.h"
+
+/* Tarefas de uma ordem inteira: todo pedaço (chunk) de todo par de buckets (i, j) vira uma tarefa, e todas entram
+de uma vez. Cada worker recebe uma faixa contígua de tarefas com trabalho parecido (o seu deque) e consome do
+começo; quem esvazia o próprio deque rouba do fim do deque dos outros. Os pares pequenos deixam de rodar sozinhos
+entre as barreiras dos grandes, e a ordem tem uma barreira só, no fim da região paralela, antes de publicar o bucket.
+As tarefas não mudam depois do início, então o deque é só o intervalo [head, tail) empacotado num inteiro de 64 bits:
+dono e ladrão andam com o mesmo compare-and-swap e nunca pegam a mesma tarefa.
+O pool de threads é o time do OpenMP, que já fica vivo entre as regiões paralelas. */
+typedef struct {
+    int pair; //Índice i do bucket da esquerda (o da direita sai da ordem)
+    int chunk;
+} PairTask;
+
+typedef struct {
+    _Atomic uint64_t range; //head nos 32 bits de baixo, tail nos de cima
+    char pad[64 - sizeof(uint64_t)]; //Um deque por linha de cache
+} WorkDeque;
+
+typedef struct {
+    PairTask *tasks;
+    int taskCount;
+    uint64_t totalWork;
+    WorkDeque *deques;
+    int workers;
+    _Atomic uint64_t steals;
+} WorkPool;
+
+static inline uint64_t workRange(uint32_t head, uint32_t tail)
+{
+    return (uint64_t)head | ((uint64_t)tail << 32);
+}
+
+/* Tarefas dos espaços spaces[i] (os que têm pedaço), divididas em workers faixas pela soma acumulada do trabalho.
+O trabalho de um pedaço é aproximado pela média do seu espaço, que o pairSpaceInit já cortou em partes iguais */
+static inline void workPoolInit(WorkPool *pool, const PairSpace *spaces, int spaceCount, int workers)
+{
+    if (workers < 1) workers = 1;
+    pool->workers = workers;
+    pool->taskCount = 0;
+    pool->totalWork = 0;
+    atomic_init(&pool->steals, 0);
+    for (int i = 0; i < spaceCount; i++) {
+        pool->taskCount += spaces[i].chunkCount;
+        pool->totalWork += spaces[i].totalWork;
+    }
+    pool->tasks = (PairTask *)malloc(((size_t)pool->taskCount + 1) * sizeof(PairTask));
+    uint64_t *work = (uint64_t *)malloc(((size_t)pool->taskCount + 1) * sizeof(uint64_t));
+    pool->deques = (WorkDeque *)aligned_alloc(64, (size_t)workers * sizeof(WorkDeque));
+    if (pool->tasks == NULL || work == NULL || pool->deques == NULL) {
+        fprintf(stderr, "Erro ao alocar as tarefas da ordem\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int t = 0;
+    for (int i = 0; i < spaceCount; i++) {
+        for (int c = 0; c < spaces[i].chunkCount; c++) {
+            pool->tasks[t].pair = i;
+            pool->tasks[t].chunk = c;
+            work[t++] = spaces[i].totalWork / spaces[i].chunkCount + 1;
+        }
+    }
+
+    // Faixa w começa na primeira tarefa que passa de w/workers do trabalho
+    uint64_t total = 0;
+    for (int x = 0; x < pool->taskCount; x++) total += work[x];
+    uint64_t prefix = 0;
+    int x = 0;
+    for (int w = 0; w < workers; w++) {
+        uint32_t head = (uint32_t)x;
+        while (x < pool->taskCount && (prefix + work[x]) * workers <= (uint64_t)(w + 1) * total) prefix += work[x++];
+        if (w == workers - 1) x = pool->taskCount;
+        else if (x == (int)head && x < pool->taskCount) prefix += work[x++]; // Pelo menos uma, se sobrar
+        atomic_init(&pool->deques[w].range, workRange(head, (uint32_t)x));
+    }
+    free(work);
+}
+
+// Tira do começo do próprio deque ou, se ele acabou, do fim do deque de outro. -1 quando não sobrou nada
+static inline int workPoolNext(WorkPool *pool, int worker)
+{
+    _Atomic uint64_t *own = &pool->deques[worker].range;
+    uint64_t range = atomic_load_explicit(own, memory_order_relaxed);
+    while ((uint32_t)range < (uint32_t)(range >> 32)) {
+        uint32_t head = (uint32_t)range;
+        if (atomic_compare_exchange_weak_explicit(own, &range, workRange(head + 1, (uint32_t)(range >> 32)),
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return (int)head;
+        }
+    }
+
+    for (int v = 1; v < pool->workers; v++) {
+        _Atomic uint64_t *victim = &pool->deques[(worker + v) % pool->workers].range;
+        range = atomic_load_explicit(victim, memory_order_relaxed);
+        while ((uint32_t)range < (uint32_t)(range >> 32)) {
+            uint32_t tail = (uint32_t)(range >> 32) - 1;
+            if (atomic_compare_exchange_weak_explicit(victim, &range, workRange((uint32_t)range, tail),
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                atomic_fetch_add_explicit(&pool->steals, 1, memory_order_relaxed);
+                return (int)tail;
+            }
+        }
+    }
+    return -1;
+}
+
+static inline void workPoolFree(WorkPool *pool)
+{
+    free(pool->tasks);
+    free(pool->deques);
+    pool->tasks = NULL;
+    pool->deques = NULL;
+    pool->taskCount = 0;
+}
+
+#endif